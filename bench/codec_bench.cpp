@@ -0,0 +1,132 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "codec.hpp"
+
+// Encodes and decodes a buffer of ticks with codec and compares against a raw
+// memcpy of the same structs and a printf/strtod text format.
+
+namespace
+{
+
+enum class Side : std::uint8_t { Bid, Ask };
+
+struct Tick
+{
+    std::uint64_t timestamp;
+    double price;
+    std::uint32_t quantity;
+    std::uint32_t instrument;
+    Side side;
+};
+
+constexpr std::size_t count = 1 << 20;
+
+template<typename F>
+void measure(const char* name, std::size_t bytes, F&& f)
+{
+    // Warm up caches and the branch predictor before timing
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    constexpr int rounds = 10;
+    for(int i = 0; i < rounds; ++i)
+    {
+        f();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    const double perRecord = elapsed.count() / (rounds * count);
+    std::printf("%-16s %8.2f ns/record %10zu bytes/record\n", name, perRecord, bytes);
+}
+
+template<typename T>
+void keep(const T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+}
+
+int main()
+{
+    std::vector<Tick> ticks(count);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        ticks[i] = Tick{i * 1000, 100.0 + static_cast<double>(i % 100) * 0.25,
+                        static_cast<std::uint32_t>(i % 500), static_cast<std::uint32_t>(i % 16),
+                        i % 2 ? Side::Bid : Side::Ask};
+    }
+    std::vector<Tick> decoded(count);
+    constexpr auto size = hbreukers::codec::encodedSize<Tick>;
+    std::vector<std::byte> buffer(count * sizeof(Tick));
+
+    measure("memcpy", sizeof(Tick), [&]
+    {
+        std::memcpy(buffer.data(), ticks.data(), count * sizeof(Tick));
+        keep(buffer);
+    });
+
+    measure("codec encode", size, [&]
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            hbreukers::codec::encode(ticks[i], std::span<std::byte>(buffer).subspan(i * size));
+        }
+        keep(buffer);
+    });
+
+    measure("codec decode", size, [&]
+    {
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            decoded[i] = hbreukers::codec::decode<Tick>(std::span<const std::byte>(buffer).subspan(i * size));
+        }
+        keep(decoded);
+    });
+
+    measure("codec view", size, [&]
+    {
+        const hbreukers::codec::Views<Tick> views(std::span<const std::byte>(buffer).first(count * size));
+        double sum = 0;
+        for(std::size_t i = 0; i < views.size(); ++i)
+        {
+            sum += views[i].get<1>();
+        }
+        keep(sum);
+    });
+
+    std::vector<char> text(count * 64);
+    std::size_t textSize = 0;
+    const auto encodeText = [&]
+    {
+        textSize = 0;
+        for(const auto& tick : ticks)
+        {
+            textSize += static_cast<std::size_t>(std::snprintf(text.data() + textSize, 64, "%llu,%.17g,%u,%u,%d\n",
+                static_cast<unsigned long long>(tick.timestamp), tick.price, tick.quantity, tick.instrument,
+                static_cast<int>(tick.side)));
+        }
+        keep(text);
+    };
+    encodeText();
+    measure("text encode", textSize / count, encodeText);
+
+    measure("text decode", textSize / count, [&]
+    {
+        char* cursor = text.data();
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            decoded[i].timestamp = std::strtoull(cursor, &cursor, 10);
+            decoded[i].price = std::strtod(cursor + 1, &cursor);
+            decoded[i].quantity = static_cast<std::uint32_t>(std::strtoul(cursor + 1, &cursor, 10));
+            decoded[i].instrument = static_cast<std::uint32_t>(std::strtoul(cursor + 1, &cursor, 10));
+            decoded[i].side = static_cast<Side>(std::strtol(cursor + 1, &cursor, 10));
+            ++cursor;
+        }
+        keep(decoded);
+    });
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+
+#include "dataStream.hpp"
+#include "pipeline.hpp"
+#include "runtimeDataStreamManager.hpp"
+
+// Runs the same chain of processes on the compile-time DataStreamManager and
+// on the RuntimeDataStreamManager, to show what dispatching through function
+// pointers and slots costs per node.
+
+namespace
+{
+
+constexpr std::int64_t count = 1 << 22;
+
+struct Counter
+{
+    std::int64_t next = 0;
+
+    std::optional<std::int64_t> operator()()
+    {
+        if(next == count)
+        {
+            return std::nullopt;
+        }
+        return next++;
+    }
+
+    bool exhausted() const
+    {
+        return next == count;
+    }
+};
+
+template<typename F>
+void measure(const char* name, int nodes, F&& f)
+{
+    // Warm up caches and the branch predictor before timing
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    constexpr int rounds = 5;
+    for(int i = 0; i < rounds; ++i)
+    {
+        f();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    const double perRecord = elapsed.count() / (rounds * count);
+    std::printf("%-16s %8.2f ns/record %8.2f ns/node\n", name, perRecord, perRecord / nodes);
+}
+
+template<typename T>
+void keep(const T& value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+}
+
+int main()
+{
+    std::int64_t sum = 0;
+    auto source = hbreukers::makeSource(Counter{});
+    auto s1 = source.process([](std::int64_t in) { return in + 1; });
+    auto s2 = s1.process([](std::int64_t in) { return in ^ 3; });
+    auto s3 = s2.filter([](std::int64_t in) { return in % 7 != 0; });
+    auto s4 = s3.process([](std::int64_t in) { return in * 3; });
+    auto s5 = s4.process([](std::int64_t in) { return in - 2; });
+    auto s6 = s5.filter([](std::int64_t in) { return in % 5 != 0; });
+    auto s7 = s6.process([](std::int64_t in) { return in >> 1; });
+    auto s8 = s7.process([](std::int64_t in) { return in + 7; });
+    auto sink = s8.addDataSink([&sum](std::int64_t in) { sum += in; });
+    constexpr int nodes = 10;
+
+    measure("compile-time", nodes, [&]
+    {
+        sum = 0;
+        auto manager = hbreukers::pipeline(source, s1, s2, s3, s4, s5, s6, s7, s8, sink).build();
+        manager.run();
+        keep(sum);
+    });
+    const auto compiledSum = sum;
+
+    measure("runtime", nodes, [&]
+    {
+        sum = 0;
+        hbreukers::RuntimeDataStreamManager manager;
+        auto n = manager.add(s8, manager.add(s7, manager.add(s6, manager.add(s5, manager.add(s4,
+            manager.add(s3, manager.add(s2, manager.add(s1, manager.addSource(source)))))))));
+        manager.add(sink, n);
+        manager.run();
+        keep(sum);
+    });
+
+    if(sum != compiledSum)
+    {
+        std::printf("Results differ: %lld and %lld\n", static_cast<long long>(compiledSum), static_cast<long long>(sum));
+        return 1;
+    }
+}
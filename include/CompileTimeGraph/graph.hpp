@@ -17,14 +17,20 @@ namespace ctgl {
         };
 
         // Edge represents a directed edge from the tail Node |T| to the head
-        // Node |H| with weight |W|.
-        template<typename T, typename H, int W>
+        // Node |H| with weight |W|. A feedback Edge |F| closes a cycle on purpose.
+        template<typename T, typename H, int W, bool F = false>
         struct Edge {
             using Tail = T;
             using Head = H;
             static constexpr int weight = W;
+            static constexpr bool feedback = F;
         };
 
+        // FeedbackEdge represents an Edge that is meant to close a cycle, such as
+        // one carrying results back to an earlier Node.
+        template<typename T, typename H, int W>
+        using FeedbackEdge = Edge<T, H, W, true>;
+
         // Graph represents a graph consisting of the |N| nodes and |E| edges.
         template <typename N, typename E>
         struct Graph {
@@ -44,10 +50,30 @@ namespace ctgl {
         template <typename G, typename N>
         constexpr auto getOutgoingEdges(G, N) noexcept;
 
+        // Finds all incoming Edges to the given Node in the provided Graph.
+        template <typename G, typename N>
+        constexpr auto getIncomingEdges(G, N) noexcept;
+
+        // Finds all Nodes without incoming Edges in the provided Graph.
+        template <typename G>
+        constexpr auto getSourceNodes(G) noexcept;
+
+        // Orders the Nodes of the provided Graph such that every Node comes
+        // after all of its predecessors.  Ties are broken by the order of the
+        // Nodes in the Graph.  If the Graph has a cycle, DNE is returned.
+        template <typename G>
+        constexpr auto topologicalSort(G) noexcept;
+
         // Reports whether the provided Graph has a cycle.
         template <typename G>
         constexpr bool hasCycle(G) noexcept;
 
+        // Finds the Edges closing a cycle in the provided Graph: those whose
+        // head reaches their tail and comes no later than it in the Nodes of
+        // the Graph.  Removing them leaves an acyclic Graph.
+        template <typename G>
+        constexpr auto getBackEdges(G) noexcept;
+
         // Reports whether the provided Graph has a negative cycle.
         template <typename G>
         constexpr bool hasNegativeCycle(G) noexcept;
@@ -70,8 +96,8 @@ namespace ctgl {
             return list::unique(getAdjacentNodes(N{}, typename G::Edges{}));
         }
 
-        template <typename N, typename H, int W, typename... Es>
-        constexpr auto getAdjacentNodes(N, List<Edge<N, H, W>, Es...>) noexcept {
+        template <typename N, typename H, int W, bool F, typename... Es>
+        constexpr auto getAdjacentNodes(N, List<Edge<N, H, W, F>, Es...>) noexcept {
             // The first Edge in the List originates from the source Node.
             return H{} + getAdjacentNodes(N{}, List<Es...>{});
         }
@@ -139,6 +165,93 @@ namespace ctgl {
             return List<>{};
         }
 
+        template <typename G, typename N>
+        constexpr auto getIncomingEdges(G, N) noexcept {
+            return list::unique(getIncomingEdges(N{}, typename G::Edges{}));
+        }
+
+        template <typename N, typename E, typename... Es>
+        constexpr auto getIncomingEdges(N, List<E, Es...>) noexcept {
+            constexpr bool match = std::is_same_v<N, typename E::Head>;
+            constexpr auto after = getIncomingEdges(N{}, List<Es...>{});
+            if constexpr (match) {
+                return E{} + after;
+            } else {
+                return after;
+            }
+        }
+
+        template <typename N>
+        constexpr auto getIncomingEdges(N, List<>) noexcept {
+            return List<>{};
+        }
+
+        template <typename G>
+        constexpr auto getSourceNodes(G) noexcept {
+            return getSourceNodes(G{}, typename G::Nodes{});
+        }
+
+        template <typename G, typename N, typename... Ns>
+        constexpr auto getSourceNodes(G, List<N, Ns...>) noexcept {
+            constexpr bool source = list::empty(getIncomingEdges(G{}, N{}));
+            constexpr auto after = getSourceNodes(G{}, List<Ns...>{});
+            if constexpr (source) {
+                return N{} + after;
+            } else {
+                return after;
+            }
+        }
+
+        template <typename G>
+        constexpr auto getSourceNodes(G, List<>) noexcept {
+            return List<>{};
+        }
+
+        template <typename... Es, typename... Ss>
+        constexpr bool isReady(List<Es...>, List<Ss...>) noexcept {
+            // A Node is ready once the tails of all its incoming Edges are sorted.
+            return (list::contains(typename Es::Tail{}, List<Ss...>{}) && ...);
+        }
+
+        template <typename G, typename... Ss>
+        constexpr auto findReadyNode(G, List<>, List<Ss...>) noexcept {
+            return List<>{};
+        }
+
+        template <typename G, typename R, typename... Rs, typename... Ss>
+        constexpr auto findReadyNode(G, List<R, Rs...>, List<Ss...>) noexcept {
+            constexpr bool ready = isReady(getIncomingEdges(G{}, R{}), List<Ss...>{});
+            if constexpr (ready) {
+                return List<R>{};
+            } else {
+                return findReadyNode(G{}, List<Rs...>{}, List<Ss...>{});
+            }
+        }
+
+        template <typename G>
+        constexpr auto topologicalSort(G) noexcept {
+            return topologicalSort(G{}, typename G::Nodes{}, List<>{});
+        }
+
+        template <typename G, typename... Ss>
+        constexpr auto topologicalSort(G, List<>, List<Ss...>) noexcept {
+            // All Nodes have been sorted.
+            return List<Ss...>{};
+        }
+
+        template <typename G, typename R, typename... Rs, typename... Ss>
+        constexpr auto topologicalSort(G, List<R, Rs...>, List<Ss...>) noexcept {
+            constexpr auto ready = findReadyNode(G{}, List<R, Rs...>{}, List<Ss...>{});
+            if constexpr (list::empty(ready)) {
+                // Every remaining Node waits on another remaining Node.
+                return path::DNE;
+            } else {
+                using Next = std::remove_const_t<decltype(list::front(ready))>;
+                constexpr auto rest = list::remove(Next{}, List<R, Rs...>{});
+                return topologicalSort(G{}, rest, List<Ss..., Next>{});
+            }
+        }
+
         template <typename G>
         constexpr bool hasCycle(G) noexcept {
             constexpr auto nodes = typename G::Nodes{};
@@ -171,6 +284,29 @@ namespace ctgl {
             return false;
         }
 
+        template <typename G>
+        constexpr auto getBackEdges(G) noexcept {
+            return getBackEdges(G{}, typename G::Edges{});
+        }
+
+        template <typename G, typename E, typename... Es>
+        constexpr auto getBackEdges(G, List<E, Es...>) noexcept {
+            constexpr auto nodes = typename G::Nodes{};
+            constexpr bool behind = list::indexOf(typename E::Head{}, nodes) <= list::indexOf(typename E::Tail{}, nodes);
+            constexpr bool back = behind && isConnected(G{}, typename E::Head{}, typename E::Tail{});
+            constexpr auto after = getBackEdges(G{}, List<Es...>{});
+            if constexpr (back) {
+                return E{} + after;
+            } else {
+                return after;
+            }
+        }
+
+        template <typename G>
+        constexpr auto getBackEdges(G, List<>) noexcept {
+            return List<>{};
+        }
+
         template <typename G>
         constexpr bool hasNegativeCycle(G) noexcept {
             constexpr auto nodes = typename G::Nodes{};
@@ -191,23 +327,23 @@ namespace ctgl {
             return false;
         }
 
-        template <typename G, typename N, typename T, typename H, int W, typename... Es, typename... Ps>
-        constexpr bool hasNegativeCycle(G, N, List<Edge<T, H, W>, Es...>, Path<Ps...>) noexcept {
+        template <typename G, typename N, typename T, typename H, int W, bool F, typename... Es, typename... Ps>
+        constexpr bool hasNegativeCycle(G, N, List<Edge<T, H, W, F>, Es...>, Path<Ps...>) noexcept {
             constexpr bool cycle = list::contains(H{}, path::nodes(List<Ps...>{}));
             if constexpr (cycle) {
                 return false;
             } else {
                 constexpr auto edges = getOutgoingEdges(G{}, H{});
-                constexpr bool take = hasNegativeCycle(G{}, N{}, edges, Path<Ps..., Edge<T, H, W>>{});
+                constexpr bool take = hasNegativeCycle(G{}, N{}, edges, Path<Ps..., Edge<T, H, W, F>>{});
                 constexpr bool skip = hasNegativeCycle(G{}, N{}, List<Es...>{}, Path<Ps...>{});
                 return take || skip;
             }
         }
 
-        template <typename G, typename N, typename T, int W, typename... Es, typename... Ps>
-        constexpr bool hasNegativeCycle(G, N, List<Edge<T, N, W>, Es...>, Path<Ps...>) noexcept {
+        template <typename G, typename N, typename T, int W, bool F, typename... Es, typename... Ps>
+        constexpr bool hasNegativeCycle(G, N, List<Edge<T, N, W, F>, Es...>, Path<Ps...>) noexcept {
             // The current Edge brings the Path back to the starting Node.
-            constexpr bool done = path::length(List<Edge<T, N, W>, Ps...>{}) < 0;
+            constexpr bool done = path::length(List<Edge<T, N, W, F>, Ps...>{}) < 0;
             return done || hasNegativeCycle(G{}, N{}, List<Es...>{}, Path<Ps...>{});
         }
 
@@ -279,8 +415,11 @@ namespace ctgl {
     template <typename T>
     using Node = ctgl::graph::Node<T>;
 
+    template<typename T, typename H, int W, bool F = false>
+    using Edge = ctgl::graph::Edge<T, H, W, F>;
+
     template<typename T, typename H, int W>
-    using Edge = ctgl::graph::Edge<T, H, W>;
+    using FeedbackEdge = ctgl::graph::FeedbackEdge<T, H, W>;
 
     template <typename N, typename E>
     using Graph = ctgl::graph::Graph<N, E>;
@@ -31,10 +31,19 @@ namespace ctgl {
         template <typename T, typename... Ts>
         constexpr auto front(List<T, Ts...>) noexcept;
 
+        // Returns the element at position |I| of the given List.
+        template <int I, typename T, typename... Ts>
+        constexpr auto at(List<T, Ts...>) noexcept;
+
         // Reports whether the given element exists in the provided List.
         template <typename T, typename... Ts>
         constexpr bool contains(T, List<Ts...>) noexcept;
 
+        // Returns the position of the first occurrence of the given element in
+        // the provided List, or -1 if the element does not exist.
+        template <typename T, typename... Ts>
+        constexpr int indexOf(T, List<Ts...>) noexcept;
+
         // Removes all duplicate elements from the given List.
         template <typename T, typename... Ts>
         constexpr auto unique(List<T, Ts...>) noexcept;
@@ -105,6 +114,15 @@ namespace ctgl {
             return T{};
         }
 
+        template <int I, typename T, typename... Ts>
+        constexpr auto at(List<T, Ts...>) noexcept {
+            if constexpr (I == 0) {
+                return T{};
+            } else {
+                return at<I - 1>(List<Ts...>{});
+            }
+        }
+
         template <typename T, typename... Ts>
         constexpr bool contains(T, List<T, Ts...>) noexcept {
             return true;
@@ -120,6 +138,22 @@ namespace ctgl {
             return false;
         }
 
+        template <typename T, typename... Ts>
+        constexpr int indexOf(T, List<T, Ts...>) noexcept {
+            return 0;
+        }
+
+        template <typename T, typename F, typename... Ts>
+        constexpr int indexOf(T, List<F, Ts...>) noexcept {
+            constexpr int after = indexOf(T{}, List<Ts...>{});
+            return after < 0 ? after : after + 1;
+        }
+
+        template <typename T>
+        constexpr int indexOf(T, List<>) noexcept {
+            return -1;
+        }
+
         template <typename T, typename... Ts>
         constexpr auto unique(List<T, Ts...>) noexcept {
             constexpr bool found = contains(T{}, List<Ts...>{});
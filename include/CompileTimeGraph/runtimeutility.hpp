@@ -15,8 +15,8 @@ namespace ctgl {
             return ctgl::list::List<ListTypes...>{};
         }
 
-        template<typename... ListTypes, typename... L2, int... I>
-        constexpr auto edgeListToTailList([[maybe_unused]]ctgl::List<ctgl::Edge<ctgl::Node<ListTypes>,ctgl::Node<L2>,I>...> listOfEdges)
+        template<typename... ListTypes, typename... L2, int... I, bool... F>
+        constexpr auto edgeListToTailList([[maybe_unused]]ctgl::List<ctgl::Edge<ctgl::Node<ListTypes>,ctgl::Node<L2>,I,F>...> listOfEdges)
         {
             return ctgl::list::List<ListTypes...>{};
         }
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Field access for plain aggregates without reflection: the number of fields
+// is found by probing brace initialisation and the fields are reached through
+// structured bindings. Nested aggregates (e.g. C arrays) count as several
+// fields through brace elision, so records should only hold scalar-like or
+// class type members.
+namespace hbreukers::aggregate
+{
+
+inline constexpr std::size_t maxFields = 24;
+
+namespace detail
+{
+
+struct AnyField
+{
+    template<typename T>
+    operator T() const;
+};
+
+template<typename T, std::size_t... I>
+constexpr bool initializableWith(std::index_sequence<I...>)
+{
+    return requires { T{ (void(I), AnyField{})... }; };
+}
+
+template<typename T, std::size_t N>
+constexpr std::size_t fieldCount()
+{
+    if constexpr(N == 0)
+    {
+        return 0;
+    }
+    else if constexpr(initializableWith<T>(std::make_index_sequence<N>{}))
+    {
+        return N;
+    }
+    else
+    {
+        return fieldCount<T, N - 1>();
+    }
+}
+
+}
+
+template<typename T>
+concept Aggregate = std::is_aggregate_v<T> && !std::is_array_v<T>;
+
+template<Aggregate T>
+inline constexpr std::size_t fieldCount = detail::fieldCount<T, maxFields>();
+
+// Returns a tuple of references to the fields of the given aggregate
+template<typename T>
+    requires Aggregate<std::remove_const_t<T>>
+constexpr auto tie(T& record)
+{
+    constexpr auto Count = fieldCount<std::remove_const_t<T>>;
+    static_assert(Count > 0 && Count <= maxFields, "Unsupported number of aggregate fields");
+    if constexpr(Count == 1)
+    {
+        auto& [f0] = record;
+        return std::tie(f0);
+    }
+    else if constexpr(Count == 2)
+    {
+        auto& [f0, f1] = record;
+        return std::tie(f0, f1);
+    }
+    else if constexpr(Count == 3)
+    {
+        auto& [f0, f1, f2] = record;
+        return std::tie(f0, f1, f2);
+    }
+    else if constexpr(Count == 4)
+    {
+        auto& [f0, f1, f2, f3] = record;
+        return std::tie(f0, f1, f2, f3);
+    }
+    else if constexpr(Count == 5)
+    {
+        auto& [f0, f1, f2, f3, f4] = record;
+        return std::tie(f0, f1, f2, f3, f4);
+    }
+    else if constexpr(Count == 6)
+    {
+        auto& [f0, f1, f2, f3, f4, f5] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5);
+    }
+    else if constexpr(Count == 7)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6);
+    }
+    else if constexpr(Count == 8)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7);
+    }
+    else if constexpr(Count == 9)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8);
+    }
+    else if constexpr(Count == 10)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9);
+    }
+    else if constexpr(Count == 11)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10);
+    }
+    else if constexpr(Count == 12)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11);
+    }
+    else if constexpr(Count == 13)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12);
+    }
+    else if constexpr(Count == 14)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13);
+    }
+    else if constexpr(Count == 15)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14);
+    }
+    else if constexpr(Count == 16)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15);
+    }
+    else if constexpr(Count == 17)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16);
+    }
+    else if constexpr(Count == 18)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17);
+    }
+    else if constexpr(Count == 19)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18);
+    }
+    else if constexpr(Count == 20)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19);
+    }
+    else if constexpr(Count == 21)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20);
+    }
+    else if constexpr(Count == 22)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21);
+    }
+    else if constexpr(Count == 23)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22);
+    }
+    else if constexpr(Count == 24)
+    {
+        auto& [f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23] = record;
+        return std::tie(f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15, f16, f17, f18, f19, f20, f21, f22, f23);
+    }
+}
+
+// std::tuple<Field0, Field1, ...> of the given aggregate
+template<Aggregate T>
+using Fields = std::remove_cvref_t<decltype(std::apply(
+    []<typename... Fs>(Fs&...){ return std::tuple<std::remove_cvref_t<Fs>...>{}; },
+    tie(std::declval<T&>())))>;
+
+template<Aggregate T, std::size_t I>
+using FieldType = std::tuple_element_t<I, Fields<T>>;
+
+}
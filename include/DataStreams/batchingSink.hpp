@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hbreukers
+{
+
+struct BatchStats
+{
+    std::uint64_t batches = 0;
+    std::uint64_t records = 0;
+    // Batches handed on because they were full; the others left on a timeout or flush()
+    std::uint64_t full = 0;
+    std::size_t largest = 0;
+
+    double averageSize() const
+    {
+        return batches == 0 ? 0.0 : static_cast<double>(records) / static_cast<double>(batches);
+    }
+};
+
+// Sink adapter collecting records into a reused buffer and handing them to
+// sink as a std::span<const T>, once capacity records arrived or, when Timed,
+// at the latest latency after a record came in, so per-call costs (syscalls,
+// compression, inserts) are paid once per batch. The latency is kept by a
+// timer of the manager, which also hands on the last partial batch as the run
+// ends. Every copy batches on its own, so each sink edge keeps its own
+// stats(); read them from the component the manager holds.
+template<typename T, typename Sink, bool Timed = true>
+class BatchingSink
+{
+public:
+    BatchingSink(Sink sink, std::size_t capacity, std::chrono::microseconds latency = {}):
+    mSink(std::move(sink)),
+    mCapacity(std::max<std::size_t>(capacity, 1)),
+    mLatency(latency)
+    {
+        mBuffer.reserve(mCapacity);
+    }
+
+    void operator()(const T& in)
+    {
+        mBuffer.push_back(in);
+        if(mBuffer.size() == mCapacity)
+        {
+            ++mStats.full;
+            flush();
+        }
+    }
+
+    std::chrono::microseconds timerInterval() const
+        requires Timed
+    {
+        return mLatency;
+    }
+
+    void onTimer(std::chrono::steady_clock::time_point)
+        requires Timed
+    {
+        flush();
+    }
+
+    // Hands on the records collected so far, if any
+    void flush()
+    {
+        if(mBuffer.empty())
+        {
+            return;
+        }
+        ++mStats.batches;
+        mStats.records += mBuffer.size();
+        mStats.largest = std::max(mStats.largest, mBuffer.size());
+        mSink(std::span<const T>(mBuffer));
+        mBuffer.clear();
+    }
+
+    void finish()
+    {
+        flush();
+    }
+
+    const BatchStats& stats() const
+    {
+        return mStats;
+    }
+
+private:
+    Sink mSink;
+    std::size_t mCapacity;
+    std::chrono::microseconds mLatency;
+    std::vector<T> mBuffer;
+    BatchStats mStats;
+};
+
+template<typename T, typename Sink>
+auto batched(Sink&& sink, std::size_t capacity, std::chrono::microseconds latency)
+{
+    return BatchingSink<T, std::decay_t<Sink>>{std::forward<Sink>(sink), capacity, latency};
+}
+
+// Hands on full batches only (and the partial one as the run ends), for
+// managers or sinks that do without timers
+template<typename T, typename Sink>
+auto batched(Sink&& sink, std::size_t capacity)
+{
+    return BatchingSink<T, std::decay_t<Sink>, false>{std::forward<Sink>(sink), capacity};
+}
+
+}
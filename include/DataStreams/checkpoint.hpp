@@ -0,0 +1,366 @@
+#pragma once
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "codec.hpp"
+#include "mappedFileSource.hpp"
+
+namespace hbreukers
+{
+
+namespace detail
+{
+
+// Vectors, strings, ... of fixed size values, stored with their length
+template<typename T>
+concept EncodableRange = std::ranges::contiguous_range<T> && std::ranges::sized_range<T>
+    && codec::Encodable<std::ranges::range_value_t<T>>;
+
+}
+
+// Serialises operator state for a checkpoint. Values use the codec layout and
+// ranges are prefixed by their length.
+class CheckpointWriter
+{
+public:
+    template<typename T>
+    void write(const T& value)
+    {
+        if constexpr(codec::Encodable<T>)
+        {
+            const auto offset = grow(codec::encodedSize<T>);
+            codec::encode(value, std::span<std::byte>(mBytes).subspan(offset));
+        }
+        else
+        {
+            static_assert(detail::EncodableRange<T>, "Checkpointed state must be encodable or a range of encodable values");
+            write(static_cast<std::uint64_t>(std::ranges::size(value)));
+            for(const auto& element : value)
+            {
+                write(element);
+            }
+        }
+    }
+
+    // Opens a length prefixed block, closed by the matching endBlock
+    std::size_t beginBlock()
+    {
+        return grow(sizeof(std::uint64_t));
+    }
+
+    void endBlock(std::size_t block)
+    {
+        const auto length = static_cast<std::uint64_t>(mBytes.size() - block - sizeof(std::uint64_t));
+        codec::encode(length, std::span<std::byte>(mBytes).subspan(block));
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+        return mBytes;
+    }
+
+    void clear()
+    {
+        mBytes.clear();
+    }
+
+private:
+    std::size_t grow(std::size_t size)
+    {
+        const auto offset = mBytes.size();
+        mBytes.resize(offset + size);
+        return offset;
+    }
+
+    std::vector<std::byte> mBytes;
+};
+
+// Reads state back in the order it was written, straight from the (mapped)
+// checkpoint bytes
+class CheckpointReader
+{
+public:
+    explicit CheckpointReader(std::span<const std::byte> bytes):
+    mBytes(bytes)
+    {}
+
+    template<typename T>
+    void read(T& value)
+    {
+        if constexpr(codec::Encodable<T>)
+        {
+            value = codec::decode<T>(take(codec::encodedSize<T>));
+        }
+        else
+        {
+            static_assert(detail::EncodableRange<T>, "Checkpointed state must be encodable or a range of encodable values");
+            const auto size = read<std::uint64_t>();
+            value.resize(static_cast<std::size_t>(size));
+            for(auto& element : value)
+            {
+                read(element);
+            }
+        }
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value{};
+        read(value);
+        return value;
+    }
+
+    // The contents of a block written between beginBlock and endBlock
+    CheckpointReader block()
+    {
+        return CheckpointReader(take(static_cast<std::size_t>(read<std::uint64_t>())));
+    }
+
+    bool empty() const
+    {
+        return mBytes.empty();
+    }
+
+private:
+    std::span<const std::byte> take(std::size_t size)
+    {
+        if(size > mBytes.size())
+        {
+            throw std::runtime_error("Checkpoint is truncated");
+        }
+        const auto bytes = mBytes.first(size);
+        mBytes = mBytes.subspan(size);
+        return bytes;
+    }
+
+    std::span<const std::byte> mBytes;
+};
+
+struct CheckpointOptions
+{
+    // Time between checkpoints taken by DataStreamManager::run
+    std::chrono::milliseconds interval{1000};
+};
+
+// Takes periodic snapshots of a manager and writes them from a background
+// thread, so the pipeline only pays for serialising its state. Each checkpoint
+// goes to a temporary file that is synced and renamed over the previous one,
+// after which the directory is synced too; a crash mid-write leaves the last
+// complete checkpoint in place. Snapshots arriving while a write is in flight
+// replace any still waiting.
+class Checkpointer
+{
+public:
+    explicit Checkpointer(std::string path, const CheckpointOptions& options = {}):
+    mPath(std::move(path)),
+    mOptions(options),
+    mDue(std::chrono::steady_clock::now() + options.interval),
+    mThread([this]{ writeLoop(); })
+    {}
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    ~Checkpointer()
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mClosing = true;
+        }
+        mWake.notify_one();
+        mThread.join();
+    }
+
+    // Snapshots the manager once the interval has passed. Called between
+    // events, when no record is in flight in the graph.
+    template<typename Manager>
+    void tick(Manager& manager)
+    {
+        if(std::chrono::steady_clock::now() >= mDue)
+        {
+            checkpoint(manager);
+        }
+    }
+
+    template<typename Manager>
+    void checkpoint(Manager& manager)
+    {
+        rethrow();
+        mWriter.clear();
+        manager.snapshot(mWriter);
+        {
+            std::lock_guard lock(mMutex);
+            mPending.assign(mWriter.bytes().begin(), mWriter.bytes().end());
+            mHasPending = true;
+        }
+        mWake.notify_one();
+        mDue = std::chrono::steady_clock::now() + mOptions.interval;
+    }
+
+    // Blocks until every snapshot taken so far is on disk
+    void wait()
+    {
+        std::unique_lock lock(mMutex);
+        mIdle.wait(lock, [this]{ return !mHasPending && !mWriting; });
+        lock.unlock();
+        rethrow();
+    }
+
+    // Restores the manager from the last checkpoint, if there is one
+    template<typename Manager>
+    bool restore(Manager& manager) const
+    {
+        if(!std::filesystem::exists(mPath))
+        {
+            return false;
+        }
+        const MappedFile file(mPath);
+        CheckpointReader reader(file.bytes());
+        manager.restore(reader);
+        return true;
+    }
+
+    const std::string& path() const
+    {
+        return mPath;
+    }
+
+private:
+    void writeLoop()
+    {
+        std::vector<std::byte> bytes;
+        while(true)
+        {
+            {
+                std::unique_lock lock(mMutex);
+                mWake.wait(lock, [this]{ return mHasPending || mClosing; });
+                if(!mHasPending)
+                {
+                    return;
+                }
+                bytes.swap(mPending);
+                mHasPending = false;
+                mWriting = true;
+            }
+            try
+            {
+                writeFile(bytes);
+            }
+            catch(...)
+            {
+                std::lock_guard lock(mMutex);
+                mError = std::current_exception();
+            }
+            {
+                std::lock_guard lock(mMutex);
+                mWriting = false;
+            }
+            mIdle.notify_all();
+        }
+    }
+
+    void writeFile(std::span<const std::byte> bytes) const
+    {
+        const auto temporary = mPath + ".tmp";
+        const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "open " + temporary);
+        }
+        while(!bytes.empty())
+        {
+            const auto written = ::write(fd, bytes.data(), bytes.size());
+            if(written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(written < 0)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "write " + temporary);
+            }
+            bytes = bytes.subspan(static_cast<std::size_t>(written));
+        }
+        if(::fsync(fd) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fsync " + temporary);
+        }
+        ::close(fd);
+        std::filesystem::rename(temporary, mPath);
+        syncDirectory();
+    }
+
+    // Makes the rename itself durable
+    void syncDirectory() const
+    {
+        auto directory = std::filesystem::path(mPath).parent_path();
+        if(directory.empty())
+        {
+            directory = ".";
+        }
+        const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "open " + directory.string());
+        }
+        if(::fsync(fd) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fsync " + directory.string());
+        }
+        ::close(fd);
+    }
+
+    void rethrow()
+    {
+        std::exception_ptr error;
+        {
+            std::lock_guard lock(mMutex);
+            error = std::exchange(mError, nullptr);
+        }
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::string mPath;
+    CheckpointOptions mOptions;
+    std::chrono::steady_clock::time_point mDue;
+    CheckpointWriter mWriter;
+
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mIdle;
+    std::vector<std::byte> mPending;
+    bool mHasPending = false;
+    bool mWriting = false;
+    bool mClosing = false;
+    std::exception_ptr mError;
+    std::thread mThread;
+};
+
+}
@@ -0,0 +1,372 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "aggregate.hpp"
+
+// Binary encoding of records with a layout fixed at compile time: fields in
+// declaration order, little-endian, without padding. Arithmetic and enum
+// fields, std::arrays and nested aggregates are supported. On little-endian
+// hosts a record whose in-memory layout already matches is copied in one go.
+namespace hbreukers::codec
+{
+
+namespace detail
+{
+
+template<typename T>
+struct isStdArray : std::false_type
+{};
+
+template<typename T, std::size_t N>
+struct isStdArray<std::array<T, N>> : std::true_type
+{};
+
+}
+
+template<typename T>
+concept Scalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+template<typename T>
+concept Array = detail::isStdArray<T>::value;
+
+template<typename T>
+concept Record = !Scalar<T> && !Array<T> && aggregate::Aggregate<T>;
+
+namespace detail
+{
+
+template<typename T>
+constexpr bool encodable()
+{
+    if constexpr(Scalar<T>)
+    {
+        return true;
+    }
+    else if constexpr(Array<T>)
+    {
+        return encodable<typename T::value_type>();
+    }
+    else if constexpr(Record<T>)
+    {
+        return []<std::size_t... I>(std::index_sequence<I...>)
+        {
+            return (encodable<aggregate::FieldType<T, I>>() && ...);
+        }(std::make_index_sequence<aggregate::fieldCount<T>>{});
+    }
+    else
+    {
+        return false;
+    }
+}
+
+// Only the bytes 0 and 1 are valid bools, so types holding one are never
+// copied from encoded bytes as they are
+template<typename T>
+constexpr bool holdsBool()
+{
+    if constexpr(Array<T>)
+    {
+        return holdsBool<typename T::value_type>();
+    }
+    else if constexpr(Record<T>)
+    {
+        return []<std::size_t... I>(std::index_sequence<I...>)
+        {
+            return (holdsBool<aggregate::FieldType<T, I>>() || ...);
+        }(std::make_index_sequence<aggregate::fieldCount<T>>{});
+    }
+    else
+    {
+        return std::is_same_v<T, bool>;
+    }
+}
+
+}
+
+// Types with a fixed size encoding
+template<typename T>
+concept Encodable = detail::encodable<T>();
+
+template<typename T>
+constexpr std::size_t encodedSizeOf()
+{
+    if constexpr(Scalar<T>)
+    {
+        return sizeof(T);
+    }
+    else if constexpr(Array<T>)
+    {
+        return std::tuple_size_v<T> * encodedSizeOf<typename T::value_type>();
+    }
+    else if constexpr(Record<T>)
+    {
+        return []<std::size_t... I>(std::index_sequence<I...>)
+        {
+            return (std::size_t{0} + ... + encodedSizeOf<aggregate::FieldType<T, I>>());
+        }(std::make_index_sequence<aggregate::fieldCount<T>>{});
+    }
+    else
+    {
+        static_assert(!sizeof(T), "Type has no fixed size encoding");
+    }
+}
+
+// Bytes taken by an encoded T
+template<typename T>
+inline constexpr std::size_t encodedSize = encodedSizeOf<T>();
+
+// Offset of the I-th field within an encoded T
+template<Record T, std::size_t I>
+inline constexpr std::size_t fieldOffset = []<std::size_t... J>(std::index_sequence<J...>)
+{
+    return (std::size_t{0} + ... + encodedSize<aggregate::FieldType<T, J>>);
+}(std::make_index_sequence<I>{});
+
+// T is stored exactly as it is encoded. Padding anywhere would make sizeof
+// exceed the sum of the field sizes.
+template<typename T>
+inline constexpr bool bitwise = std::endian::native == std::endian::little
+    && std::is_trivially_copyable_v<T> && sizeof(T) == encodedSize<T> && !detail::holdsBool<T>();
+
+namespace detail
+{
+
+template<Scalar T>
+auto toUnsigned(T value)
+{
+    if constexpr(sizeof(T) == 1)
+    {
+        return std::bit_cast<std::uint8_t>(value);
+    }
+    else if constexpr(sizeof(T) == 2)
+    {
+        return std::bit_cast<std::uint16_t>(value);
+    }
+    else if constexpr(sizeof(T) == 4)
+    {
+        return std::bit_cast<std::uint32_t>(value);
+    }
+    else
+    {
+        static_assert(sizeof(T) == 8, "Unsupported scalar size");
+        return std::bit_cast<std::uint64_t>(value);
+    }
+}
+
+template<std::unsigned_integral U>
+constexpr U byteSwap(U value)
+{
+    U result = 0;
+    for(std::size_t i = 0; i < sizeof(U); ++i)
+    {
+        result = static_cast<U>((result << 8) | ((value >> (8 * i)) & 0xff));
+    }
+    return result;
+}
+
+template<typename T>
+void store(const T& value, std::byte* out)
+{
+    if constexpr(bitwise<T>)
+    {
+        std::memcpy(out, &value, sizeof(T));
+    }
+    else if constexpr(Scalar<T>)
+    {
+        const auto swapped = byteSwap(toUnsigned(value));
+        std::memcpy(out, &swapped, sizeof(T));
+    }
+    else if constexpr(Array<T>)
+    {
+        for(const auto& element : value)
+        {
+            store(element, out);
+            out += encodedSize<typename T::value_type>;
+        }
+    }
+    else
+    {
+        std::apply([&](const auto&... fields)
+        {
+            ((store(fields, out), out += encodedSize<std::remove_cvref_t<decltype(fields)>>), ...);
+        }, aggregate::tie(value));
+    }
+}
+
+template<typename T>
+void load(T& value, const std::byte* in)
+{
+    if constexpr(bitwise<T>)
+    {
+        std::memcpy(&value, in, sizeof(T));
+    }
+    else if constexpr(std::is_same_v<T, bool>)
+    {
+        // Any byte other than 0 reads as true
+        value = *in != std::byte{0};
+    }
+    else if constexpr(Scalar<T>)
+    {
+        decltype(toUnsigned(value)) swapped;
+        std::memcpy(&swapped, in, sizeof(T));
+        value = std::bit_cast<T>(byteSwap(swapped));
+    }
+    else if constexpr(Array<T>)
+    {
+        for(auto& element : value)
+        {
+            load(element, in);
+            in += encodedSize<typename T::value_type>;
+        }
+    }
+    else
+    {
+        std::apply([&](auto&... fields)
+        {
+            ((load(fields, in), in += encodedSize<std::remove_cvref_t<decltype(fields)>>), ...);
+        }, aggregate::tie(value));
+    }
+}
+
+inline void checkSize(std::size_t available, std::size_t needed)
+{
+    if(available < needed)
+    {
+        throw std::length_error("Buffer of " + std::to_string(available) + " bytes is too small for a "
+                                + std::to_string(needed) + " byte record");
+    }
+}
+
+}
+
+// Writes the encoding of record to the front of out
+template<typename T>
+void encode(const T& record, std::span<std::byte> out)
+{
+    detail::checkSize(out.size(), encodedSize<T>);
+    detail::store(record, out.data());
+}
+
+template<typename T>
+std::array<std::byte, encodedSize<T>> encode(const T& record)
+{
+    std::array<std::byte, encodedSize<T>> out;
+    detail::store(record, out.data());
+    return out;
+}
+
+template<typename T>
+T decode(std::span<const std::byte> in)
+{
+    detail::checkSize(in.size(), encodedSize<T>);
+    T record{};
+    detail::load(record, in.data());
+    return record;
+}
+
+// Reads fields of an encoded record in place (e.g. straight out of a mapped
+// file) without decoding the rest of it
+template<Record T>
+class View
+{
+public:
+    explicit View(std::span<const std::byte> bytes):
+    mData(bytes.data())
+    {
+        detail::checkSize(bytes.size(), encodedSize<T>);
+    }
+
+    // A nested record comes back as a View of its own
+    template<std::size_t I>
+    auto get() const
+    {
+        using Field = aggregate::FieldType<T, I>;
+        const auto* data = mData + fieldOffset<T, I>;
+        if constexpr(Record<Field>)
+        {
+            return View<Field>(std::span<const std::byte>(data, encodedSize<Field>));
+        }
+        else
+        {
+            Field value{};
+            detail::load(value, data);
+            return value;
+        }
+    }
+
+    T value() const
+    {
+        T record{};
+        detail::load(record, mData);
+        return record;
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+        return {mData, encodedSize<T>};
+    }
+
+private:
+    const std::byte* mData;
+};
+
+// Encoded records stored back to back; a trailing partial record is ignored
+template<Record T>
+class Views
+{
+public:
+    explicit Views(std::span<const std::byte> bytes):
+    mBytes(bytes)
+    {}
+
+    std::size_t size() const
+    {
+        return mBytes.size() / encodedSize<T>;
+    }
+
+    View<T> operator[](std::size_t i) const
+    {
+        return View<T>(mBytes.subspan(i * encodedSize<T>, encodedSize<T>));
+    }
+
+private:
+    std::span<const std::byte> mBytes;
+};
+
+// Process encoding each record into a buffer reused between calls
+template<typename T>
+class Encoder
+{
+public:
+    std::span<const std::byte> operator()(const T& record)
+    {
+        detail::store(record, mOut.data());
+        return mOut;
+    }
+
+private:
+    std::array<std::byte, encodedSize<T>> mOut;
+};
+
+template<typename T>
+auto encoder()
+{
+    return Encoder<T>{};
+}
+
+template<typename T>
+auto decoder()
+{
+    return [](std::span<const std::byte> in){ return decode<T>(in); };
+}
+
+}
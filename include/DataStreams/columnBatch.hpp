@@ -0,0 +1,240 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "aggregate.hpp"
+
+namespace hbreukers
+{
+
+// Struct-of-arrays batch of Record values. The schema (one column per field) is
+// derived at compile time from the fields of the aggregate Record, so stages
+// that read a single field only stream that field's column through the cache.
+template<aggregate::Aggregate Record>
+class ColumnBatch
+{
+    using Schema = aggregate::Fields<Record>;
+    static constexpr std::size_t Width = std::tuple_size_v<Schema>;
+
+    template<typename Seq>
+    struct ColumnsOf;
+
+    template<std::size_t... I>
+    struct ColumnsOf<std::index_sequence<I...>>
+    {
+        using type = std::tuple<std::vector<aggregate::FieldType<Record, I>>...>;
+    };
+
+    using Columns = typename ColumnsOf<std::make_index_sequence<Width>>::type;
+
+public:
+    using RecordType = Record;
+
+    template<std::size_t I>
+    using ColumnType = aggregate::FieldType<Record, I>;
+
+    static constexpr std::size_t columns() { return Width; }
+
+    [[nodiscard]] std::size_t size() const { return std::get<0>(mColumns).size(); }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    void reserve(std::size_t n)
+    {
+        forEachColumn([n](auto& column){ column.reserve(n); });
+    }
+
+    // Keeps the column capacity so a batch can be refilled without allocating
+    void clear()
+    {
+        forEachColumn([](auto& column){ column.clear(); });
+    }
+
+    void push_back(const Record& record)
+    {
+        pushFields(aggregate::tie(record), std::make_index_sequence<Width>{});
+    }
+
+    template<std::size_t I>
+    std::span<const ColumnType<I>> column() const
+    {
+        return std::get<I>(mColumns);
+    }
+
+    template<std::size_t I>
+    std::span<ColumnType<I>> column()
+    {
+        return std::get<I>(mColumns);
+    }
+
+    // Gathers the fields of row i back into a Record
+    Record record(std::size_t i) const
+    {
+        return std::apply([i](const auto&... column){ return Record{column[i]...}; }, mColumns);
+    }
+
+    // Appends the rows of other selected by the given row indices
+    void gather(const ColumnBatch& other, std::span<const std::size_t> rows)
+    {
+        gatherColumns(other, rows, std::make_index_sequence<Width>{});
+    }
+
+private:
+    template<typename F>
+    void forEachColumn(F&& f)
+    {
+        std::apply([&](auto&... column){ (f(column), ...); }, mColumns);
+    }
+
+    template<typename Fields, std::size_t... I>
+    void pushFields(const Fields& fields, std::index_sequence<I...>)
+    {
+        (std::get<I>(mColumns).push_back(std::get<I>(fields)), ...);
+    }
+
+    template<std::size_t... I>
+    void gatherColumns(const ColumnBatch& other, std::span<const std::size_t> rows, std::index_sequence<I...>)
+    {
+        ([&]
+        {
+            auto& to = std::get<I>(mColumns);
+            const auto& from = std::get<I>(other.mColumns);
+            for(const auto row : rows)
+            {
+                to.push_back(from[row]);
+            }
+        }(), ...);
+    }
+
+    Columns mColumns;
+};
+
+// Rows of a ColumnBatch selected by index, viewed in place rather than copied.
+// Valid as long as the batch and the row indices it refers to.
+template<aggregate::Aggregate Record>
+class SelectedRows
+{
+public:
+    using RecordType = Record;
+
+    template<std::size_t I>
+    using ColumnType = typename ColumnBatch<Record>::template ColumnType<I>;
+
+    SelectedRows(const ColumnBatch<Record>& batch, std::span<const std::size_t> rows):
+    mBatch(&batch),
+    mRows(rows)
+    {}
+
+    [[nodiscard]] std::size_t size() const { return mRows.size(); }
+    [[nodiscard]] bool empty() const { return mRows.empty(); }
+
+    const ColumnBatch<Record>& batch() const { return *mBatch; }
+    std::span<const std::size_t> rows() const { return mRows; }
+
+    // Field I of the i-th selected row
+    template<std::size_t I>
+    const ColumnType<I>& value(std::size_t i) const
+    {
+        return mBatch->template column<I>()[mRows[i]];
+    }
+
+    Record record(std::size_t i) const
+    {
+        return mBatch->record(mRows[i]);
+    }
+
+    // Appends the selected rows, all columns of them, to out
+    void materialize(ColumnBatch<Record>& out) const
+    {
+        out.gather(*mBatch, mRows);
+    }
+
+private:
+    const ColumnBatch<Record>* mBatch;
+    std::span<const std::size_t> mRows;
+};
+
+namespace columnar
+{
+
+// Operator returning a view of column I, touching no other column
+template<std::size_t I>
+auto project()
+{
+    return []<typename Record>(const ColumnBatch<Record>& batch){ return batch.template column<I>(); };
+}
+
+// Projection of column I that also takes SelectedRows, copying column I of the
+// selected rows (and no other column) into a buffer reused between invocations
+template<std::size_t I, typename Record>
+class ProjectColumn
+{
+public:
+    using ValueType = typename ColumnBatch<Record>::template ColumnType<I>;
+
+    std::span<const ValueType> operator()(const ColumnBatch<Record>& batch) const
+    {
+        return batch.template column<I>();
+    }
+
+    std::span<const ValueType> operator()(const SelectedRows<Record>& selection)
+    {
+        const auto values = selection.batch().template column<I>();
+        mValues.clear();
+        for(const auto row : selection.rows())
+        {
+            mValues.push_back(values[row]);
+        }
+        return mValues;
+    }
+
+private:
+    std::vector<ValueType> mValues;
+};
+
+template<std::size_t I, typename Record>
+auto project()
+{
+    return ProjectColumn<I, Record>{};
+}
+
+// Operator keeping the rows whose column I satisfies the predicate. Only column
+// I is read; the result views the selected rows of the input batch, so no
+// column is copied until a downstream operator reads it.
+template<std::size_t I, typename Record, typename Predicate>
+class FilterColumn
+{
+public:
+    explicit FilterColumn(const Predicate& predicate):
+    mPredicate(predicate)
+    {}
+
+    SelectedRows<Record> operator()(const ColumnBatch<Record>& batch)
+    {
+        mRows.clear();
+        const auto values = batch.template column<I>();
+        for(std::size_t row = 0; row < values.size(); ++row)
+        {
+            if(mPredicate(values[row]))
+            {
+                mRows.push_back(row);
+            }
+        }
+        return SelectedRows<Record>(batch, mRows);
+    }
+
+private:
+    Predicate mPredicate;
+    std::vector<std::size_t> mRows;
+};
+
+template<std::size_t I, typename Record, typename Predicate>
+auto filter(Predicate&& predicate)
+{
+    return FilterColumn<I, Record, std::decay_t<Predicate>>(std::forward<Predicate>(predicate));
+}
+
+}
+
+}
@@ -1,7 +1,16 @@
 #pragma once
+#include <chrono>
 #include <type_traits>
 #include <utility>
 #include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <bitset>
+#include <concepts>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include "smallBuffer.hpp"
 
 namespace hbreukers
 {
@@ -9,6 +18,278 @@ namespace hbreukers
 template<typename OutType, typename InType>
 class DataStream;
 
+template<typename T>
+class Task;
+
+// Sources may return std::optional<T>; an empty optional means nothing was
+// produced and the manager skips the step for that source
+template<typename T>
+struct SourceValue
+{
+    using type = T;
+};
+
+template<typename T>
+struct SourceValue<std::optional<T>>
+{
+    using type = T;
+};
+
+template<typename T>
+using SourceValueType = typename SourceValue<std::remove_cvref_t<T>>::type;
+
+template<typename T>
+inline constexpr bool isOptional = false;
+
+template<typename T>
+inline constexpr bool isOptional<std::optional<T>> = true;
+
+// Tags telling the manager how the result of a node is propagated
+struct MapNodeTag {};
+struct FilterNodeTag {};
+struct FlatMapNodeTag {};
+struct RouterNodeTag {};
+
+template<typename T>
+inline constexpr bool isBitset = false;
+
+template<std::size_t N>
+inline constexpr bool isBitset<std::bitset<N>> = true;
+
+// What a router selects: the index of one branch, or a bit per branch
+template<typename T>
+concept RouteSelection = std::integral<T> || isBitset<T>;
+
+// Sources that resume at a recorded offset: position() tells where they are
+// and seek() goes back there, so one is no use without the other
+template<typename Process>
+concept Seekable = requires(const Process& process) { { process.position() } -> std::convertible_to<std::size_t>; }
+    && requires(Process& process, std::size_t position) { process.seek(position); };
+
+// Operator state taking part in checkpoints: processes with snapshot(writer)
+// and restore(reader) members, or Seekable sources
+template<typename Process, typename Writer>
+concept Snapshottable = requires(const Process& process, Writer& writer) { process.snapshot(writer); } || Seekable<Process>;
+
+template<typename Process, typename Reader>
+concept Restorable = requires(Process& process, Reader& reader) { process.restore(reader); } || Seekable<Process>;
+
+namespace detail
+{
+
+template<typename Process, typename Writer>
+void snapshotState(const Process& process, Writer& writer)
+{
+    if constexpr(requires { process.snapshot(writer); })
+    {
+        process.snapshot(writer);
+    }
+    else
+    {
+        writer.write(static_cast<std::uint64_t>(process.position()));
+    }
+}
+
+template<typename Process, typename Reader>
+void restoreState(Process& process, Reader& reader)
+{
+    if constexpr(requires { process.restore(reader); })
+    {
+        process.restore(reader);
+    }
+    else
+    {
+        process.seek(static_cast<std::size_t>(reader.template read<std::uint64_t>()));
+    }
+}
+
+// Calls update on a stream, handing processes that take a
+// std::pmr::memory_resource* the given resource
+template<typename Stream, typename... Data>
+decltype(auto) invokeUpdate(Stream& stream, std::pmr::memory_resource* resource, Data&&... input)
+{
+    if constexpr(requires { stream.update(std::forward<Data>(input)..., resource); })
+    {
+        return stream.update(std::forward<Data>(input)..., resource);
+    }
+    else
+    {
+        return stream.update(std::forward<Data>(input)...);
+    }
+}
+
+template<typename F>
+struct FirstParameter
+{
+    using type = void;
+};
+
+template<typename R, typename A, typename... As>
+struct FirstParameter<R(*)(A, As...)>
+{
+    using type = A;
+};
+
+template<typename R, typename C, typename A, typename... As>
+struct FirstParameter<R(C::*)(A, As...)>
+{
+    using type = A;
+};
+
+template<typename R, typename C, typename A, typename... As>
+struct FirstParameter<R(C::*)(A, As...) const>
+{
+    using type = A;
+};
+
+template<typename R, typename C, typename A, typename... As>
+struct FirstParameter<R(C::*)(A, As...) noexcept>
+{
+    using type = A;
+};
+
+template<typename R, typename C, typename A, typename... As>
+struct FirstParameter<R(C::*)(A, As...) const noexcept>
+{
+    using type = A;
+};
+
+// The parameter type through which Process takes an In, void where
+// overloads leave it open
+template<typename Process, typename In>
+auto inputParameter()
+{
+    if constexpr(requires { &Process::operator(); })
+    {
+        return std::type_identity<typename FirstParameter<decltype(&Process::operator())>::type>{};
+    }
+    else if constexpr(requires { &Process::template operator()<In>; })
+    {
+        return std::type_identity<typename FirstParameter<decltype(&Process::template operator()<In>)>::type>{};
+    }
+    else
+    {
+        return std::type_identity<typename FirstParameter<Process>::type>{};
+    }
+}
+
+template<typename Process, typename In>
+using InputParameter = typename decltype(inputParameter<Process, In>())::type;
+
+template<typename T>
+struct TaskValue
+{
+    using type = T;
+};
+
+template<typename T>
+struct TaskValue<Task<T>>
+{
+    using type = T;
+};
+
+// Type of the values Stream passes on when handed an In, void In for sources
+template<typename Stream, typename In>
+constexpr auto outputOf()
+{
+    if constexpr(std::is_void_v<In>)
+    {
+        using Result = decltype(invokeUpdate(std::declval<Stream&>(), nullptr));
+        return std::type_identity<std::decay_t<SourceValueType<Result>>>{};
+    }
+    else if constexpr(std::is_same_v<typename Stream::NodeTag, FilterNodeTag> || std::is_same_v<typename Stream::NodeTag, RouterNodeTag>)
+    {
+        return std::type_identity<In>{};
+    }
+    else
+    {
+        using Result = std::remove_cvref_t<decltype(invokeUpdate(std::declval<Stream&>(), nullptr, std::declval<const In&>()))>;
+        if constexpr(std::is_same_v<typename Stream::NodeTag, FlatMapNodeTag>)
+        {
+            return std::type_identity<std::ranges::range_value_t<Result>>{};
+        }
+        else
+        {
+            return std::type_identity<std::decay_t<typename TaskValue<Result>::type>>{};
+        }
+    }
+}
+
+template<typename Stream, typename In>
+using OutputType = typename decltype(outputOf<Stream, In>())::type;
+
+// Type of the values Stream emits. Its ValueType is what it is handed, or for
+// sources what they produce, so chained stages follow the actual output.
+template<typename Stream>
+using EmittedBy = OutputType<Stream, std::conditional_t<std::is_void_v<typename Stream::Upstream>, void, typename Stream::ValueType>>;
+
+// Calls f.template operator()<I>() for every branch I of Branches that
+// selection picks. An index is compared against every branch in turn, which
+// the compiler turns into a switch; an index past the last branch picks none.
+template<std::size_t Branches, typename Selection, typename F>
+void forEachSelected(const Selection& selection, F&& f)
+{
+    [&]<std::size_t... Is>(std::index_sequence<Is...>)
+    {
+        if constexpr(std::is_integral_v<Selection>)
+        {
+            (void)((static_cast<std::size_t>(selection) == Is && (f.template operator()<Is>(), true)) || ...);
+        }
+        else
+        {
+            static_assert(Selection{}.size() >= Branches, "The bitset of a router needs a bit per outgoing edge");
+            ((selection.test(Is) ? f.template operator()<Is>() : void()), ...);
+        }
+    }(std::make_index_sequence<Branches>{});
+}
+
+}
+
+// Streams derived from a node record the node as their Upstream, so the
+// topology of a pipeline can be read back from its types (see pipeline.hpp).
+// process, filter, flatMap and route take what the node emits as their input;
+// addDataStream<T>() names the type instead.
+template<typename Derived>
+class DataStreamBase
+{
+public:
+    template<typename OutType>
+    auto addDataStream()
+    {
+        return DataStream<OutType,Derived>{};
+    }
+
+    template<typename SinkFunc>
+    auto addDataSink(SinkFunc&& sinkFunc)
+    {
+        return DataStream<void,Derived>{}.process(std::forward<SinkFunc>(sinkFunc));
+    }
+
+    template<typename Process>
+    auto process(Process&& process)
+    {
+        return DataStream<detail::EmittedBy<Derived>,Derived>{}.process(std::forward<Process>(process));
+    }
+
+    template<typename Predicate>
+    auto filter(Predicate&& predicate)
+    {
+        return DataStream<detail::EmittedBy<Derived>,Derived>{}.filter(std::forward<Predicate>(predicate));
+    }
+
+    template<std::size_t Capacity = 8, typename Process>
+    auto flatMap(Process&& process)
+    {
+        return DataStream<detail::EmittedBy<Derived>,Derived>{}.template flatMap<Capacity>(std::forward<Process>(process));
+    }
+
+    template<typename Selector>
+    auto route(Selector&& selector)
+    {
+        return DataStream<detail::EmittedBy<Derived>,Derived>{}.route(std::forward<Selector>(selector));
+    }
+};
+
 // template<typename T>
 // class DataStreamInfo
 // {
@@ -17,41 +298,274 @@ class DataStream;
 // };
 
 template<typename T, typename Process, typename MixinBase>
-class DataStreamProcess : public MixinBase
+class DataStreamProcess : public MixinBase, public DataStreamBase<DataStreamProcess<T, Process, MixinBase>>
 {
-    using ThisType = DataStreamProcess<T, Process, MixinBase>;
 public:
-    DataStreamProcess(const MixinBase& base, const Process& process):
+    // Chaining on a node makes it the upstream of the new one
+    using DataStreamBase<DataStreamProcess<T, Process, MixinBase>>::process;
+    using DataStreamBase<DataStreamProcess<T, Process, MixinBase>>::filter;
+    using DataStreamBase<DataStreamProcess<T, Process, MixinBase>>::flatMap;
+    using DataStreamBase<DataStreamProcess<T, Process, MixinBase>>::route;
+
+    using NodeTag = MapNodeTag;
+
+    static_assert(Seekable<Process>
+                  || !(requires(const Process& process) { process.position(); } || requires(Process& process) { process.seek(std::size_t{}); }),
+                  "A source has to have both position() and seek() to be checkpointed");
+
+    DataStreamProcess(const MixinBase& base, const Process& func):
     MixinBase(base),
-    mProcess(process)
+    mProcess(func)
     {}    
 
-    template<typename OutType>
-    auto addDataStream()
+    decltype(auto) update(auto&& in)
+        requires std::invocable<Process&, decltype(in)>
     {
-        return DataStream<OutType,ThisType>{};
+        return std::invoke(mProcess,std::forward<decltype(in)>(in));
     }
 
-    template<typename SinkFunc>
-    auto addDataSink(SinkFunc&& sinkFunc)
+    decltype(auto) update()
+        requires std::invocable<Process&>
     {
-        return DataStream<void,ThisType>{}.process(std::forward<SinkFunc>(sinkFunc));
+        return std::invoke(mProcess);
     }
-    
 
-    auto update(auto&& in)
+    // Processes taking a trailing std::pmr::memory_resource* get the per-event
+    // arena of the manager, released once the event has left the graph
+    decltype(auto) update(auto&& in, std::pmr::memory_resource* resource)
+        requires std::invocable<Process&, decltype(in), std::pmr::memory_resource*>
     {
-        return std::invoke(mProcess,std::forward<decltype(in)>(in));
+        return std::invoke(mProcess,std::forward<decltype(in)>(in),resource);
     }
 
-    auto update()
+    // Sources that can run dry report it through an exhausted() member
+    bool exhausted() const
+        requires requires(const Process& process) { { process.exhausted() } -> std::convertible_to<bool>; }
     {
-        return std::invoke(mProcess);
+        return mProcess.exhausted();
+    }
+
+    // Event driven sources block in waitReady(timeout) until their next call
+    // would produce something, instead of being polled while they have nothing
+    bool waitReady(std::chrono::nanoseconds timeout)
+        requires requires(Process& process) { { process.waitReady(timeout) } -> std::convertible_to<bool>; }
+    {
+        return mProcess.waitReady(timeout);
+    }
+
+    // Processes acting on time passing, say to flush a buffer or expire idle
+    // keys, have onTimer(now) called every timerInterval() by the manager.
+    // What it returns goes downstream like a result of update, so a source
+    // returning an empty optional or a void onTimer sends nothing.
+    auto timerInterval() const
+        requires requires(const Process& process) { { process.timerInterval() } -> std::convertible_to<std::chrono::nanoseconds>; }
+    {
+        return mProcess.timerInterval();
+    }
+
+    decltype(auto) onTimer(std::chrono::steady_clock::time_point now)
+        requires requires(Process& process) { process.onTimer(now); }
+    {
+        return mProcess.onTimer(now);
+    }
+
+    // Processes holding records back, such as batching sinks, hand them on
+    // in finish(), called by the manager once a run ends
+    void finish()
+        requires requires(Process& process) { process.finish(); }
+    {
+        mProcess.finish();
+    }
+
+    template<std::same_as<std::pmr::memory_resource*> Resource>
+    decltype(auto) update(Resource resource)
+        requires std::invocable<Process&, Resource>
+    {
+        return std::invoke(mProcess,resource);
+    }
+
+    // The wrapped process, say to read the statistics it keeps
+    Process& function()
+    {
+        return mProcess;
+    }
+
+    const Process& function() const
+    {
+        return mProcess;
+    }
+
+    template<typename Writer>
+    void snapshot(Writer& writer) const
+        requires Snapshottable<Process, Writer>
+    {
+        detail::snapshotState(mProcess, writer);
+    }
+
+    template<typename Reader>
+    void restore(Reader& reader)
+        requires Restorable<Process, Reader>
+    {
+        detail::restoreState(mProcess, reader);
+    }
+
+private:
+
+Process mProcess;
+};
+
+// Forwards its input unchanged when the predicate holds, otherwise the rest of
+// the subtree is skipped
+template<typename T, typename Predicate, typename MixinBase>
+class DataStreamFilter : public MixinBase, public DataStreamBase<DataStreamFilter<T, Predicate, MixinBase>>
+{
+public:
+    // Chaining on a node makes it the upstream of the new one
+    using DataStreamBase<DataStreamFilter<T, Predicate, MixinBase>>::process;
+    using DataStreamBase<DataStreamFilter<T, Predicate, MixinBase>>::filter;
+    using DataStreamBase<DataStreamFilter<T, Predicate, MixinBase>>::flatMap;
+    using DataStreamBase<DataStreamFilter<T, Predicate, MixinBase>>::route;
+
+    using NodeTag = FilterNodeTag;
+
+    DataStreamFilter(const MixinBase& base, const Predicate& predicate):
+    MixinBase(base),
+    mPredicate(predicate)
+    {}
+
+    bool test(const auto& in)
+        requires std::predicate<Predicate&, decltype(in)>
+    {
+        return std::invoke(mPredicate, in);
+    }
+
+    template<typename Writer>
+    void snapshot(Writer& writer) const
+        requires Snapshottable<Predicate, Writer>
+    {
+        detail::snapshotState(mPredicate, writer);
+    }
+
+    template<typename Reader>
+    void restore(Reader& reader)
+        requires Restorable<Predicate, Reader>
+    {
+        detail::restoreState(mPredicate, reader);
+    }
+
+private:
+
+Predicate mPredicate;
+};
+
+// Passes its input on unchanged to the branches its selector picks, numbered
+// in the order of the outgoing edges of the node. The selector returns the
+// index of a branch or a std::bitset with a bit per branch, so content based
+// routing evaluates only the selected subgraphs.
+template<typename T, typename Selector, typename MixinBase>
+class DataStreamRouter : public MixinBase, public DataStreamBase<DataStreamRouter<T, Selector, MixinBase>>
+{
+public:
+    // Chaining on a node makes it the upstream of the new one
+    using DataStreamBase<DataStreamRouter<T, Selector, MixinBase>>::process;
+    using DataStreamBase<DataStreamRouter<T, Selector, MixinBase>>::filter;
+    using DataStreamBase<DataStreamRouter<T, Selector, MixinBase>>::flatMap;
+    using DataStreamBase<DataStreamRouter<T, Selector, MixinBase>>::route;
+
+    using NodeTag = RouterNodeTag;
+
+    DataStreamRouter(const MixinBase& base, const Selector& selector):
+    MixinBase(base),
+    mSelector(selector)
+    {}
+
+    auto select(const auto& in)
+        requires std::invocable<Selector&, decltype(in)>
+              && RouteSelection<std::remove_cvref_t<std::invoke_result_t<Selector&, decltype(in)>>>
+    {
+        return std::invoke(mSelector, in);
+    }
+
+    template<typename Writer>
+    void snapshot(Writer& writer) const
+        requires Snapshottable<Selector, Writer>
+    {
+        detail::snapshotState(mSelector, writer);
+    }
+
+    template<typename Reader>
+    void restore(Reader& reader)
+        requires Restorable<Selector, Reader>
+    {
+        detail::restoreState(mSelector, reader);
+    }
+
+private:
+
+Selector mSelector;
+};
+
+// Emits 0..Capacity values per input; the process is invoked with the input
+// and a SmallBuffer<T,Capacity>& to push its outputs into. Outputs beyond
+// Capacity are dropped and counted in overflowed().
+template<typename T, typename Process, typename MixinBase, std::size_t Capacity>
+class DataStreamFlatMap : public MixinBase, public DataStreamBase<DataStreamFlatMap<T, Process, MixinBase, Capacity>>
+{
+public:
+    // Chaining on a node makes it the upstream of the new one
+    using DataStreamBase<DataStreamFlatMap<T, Process, MixinBase, Capacity>>::process;
+    using DataStreamBase<DataStreamFlatMap<T, Process, MixinBase, Capacity>>::filter;
+    using DataStreamBase<DataStreamFlatMap<T, Process, MixinBase, Capacity>>::flatMap;
+    using DataStreamBase<DataStreamFlatMap<T, Process, MixinBase, Capacity>>::route;
+
+    using NodeTag = FlatMapNodeTag;
+    using Buffer = SmallBuffer<T, Capacity>;
+
+    DataStreamFlatMap(const MixinBase& base, const Process& func):
+    MixinBase(base),
+    mProcess(func)
+    {}
+
+    const Buffer& update(auto&& in)
+        requires std::invocable<Process&, decltype(in), Buffer&>
+    {
+        mBuffer.clear();
+        std::invoke(mProcess, std::forward<decltype(in)>(in), mBuffer);
+        return mBuffer;
+    }
+
+    const Buffer& update(auto&& in, std::pmr::memory_resource* resource)
+        requires std::invocable<Process&, decltype(in), Buffer&, std::pmr::memory_resource*>
+    {
+        mBuffer.clear();
+        std::invoke(mProcess, std::forward<decltype(in)>(in), mBuffer, resource);
+        return mBuffer;
+    }
+
+    // Outputs dropped because they did not fit in Capacity
+    std::size_t overflowed() const
+    {
+        return mBuffer.overflowed();
+    }
+
+    template<typename Writer>
+    void snapshot(Writer& writer) const
+        requires Snapshottable<Process, Writer>
+    {
+        detail::snapshotState(mProcess, writer);
+    }
+
+    template<typename Reader>
+    void restore(Reader& reader)
+        requires Restorable<Process, Reader>
+    {
+        detail::restoreState(mProcess, reader);
     }
 
 private:
 
 Process mProcess;
+Buffer mBuffer;
 };
 
 
@@ -60,6 +574,10 @@ class DataStream
 {
     using ThisType = DataStream<OutType,InStreamType>;
 public:
+    using ValueType = OutType;
+    // The node this stream was derived from, void for sources
+    using Upstream = InStreamType;
+
     // explicit DataStream(const DataStreamInfo<InStreamType>& dsi):
     // mDataStreamInfo(dsi)
     // {}
@@ -67,7 +585,25 @@ public:
     template<typename Process>
     auto process([[maybe_unused]] Process&& process)
     {
-        return DataStreamProcess<OutType,Process,ThisType>(*this,std::forward<Process>(process));
+        return DataStreamProcess<OutType,std::decay_t<Process>,ThisType>(*this,std::forward<Process>(process));
+    }
+
+    template<typename Predicate>
+    auto filter(Predicate&& predicate)
+    {
+        return DataStreamFilter<OutType,std::decay_t<Predicate>,ThisType>(*this,std::forward<Predicate>(predicate));
+    }
+
+    template<std::size_t Capacity = 8, typename Process>
+    auto flatMap(Process&& process)
+    {
+        return DataStreamFlatMap<OutType,std::decay_t<Process>,ThisType,Capacity>(*this,std::forward<Process>(process));
+    }
+
+    template<typename Selector>
+    auto route(Selector&& selector)
+    {
+        return DataStreamRouter<OutType,std::decay_t<Selector>,ThisType>(*this,std::forward<Selector>(selector));
     }
 
 private:
@@ -78,7 +614,10 @@ private:
 template<typename SourceFunc>
 auto makeSource(SourceFunc&& sourceFunc)
 {
-    using RetType = std::invoke_result_t<SourceFunc>;
+    using Result = std::conditional_t<std::is_invocable_v<SourceFunc&>,
+                                      std::invoke_result<SourceFunc&>,
+                                      std::invoke_result<SourceFunc&, std::pmr::memory_resource*>>;
+    using RetType = SourceValueType<typename Result::type>;
     return DataStream<RetType,void>{}.process(std::forward<SourceFunc>(sourceFunc));
 }
 
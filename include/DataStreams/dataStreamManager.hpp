@@ -1,65 +1,1010 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <source_location>
+#include <stdexcept>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include "../CompileTimeGraph/ctgl.hpp"
+#include "dataStream.hpp"
+#include "eventArena.hpp"
+#include "feedbackQueue.hpp"
+#include "programValidation.hpp"
+#include "task.hpp"
+#include "timer.hpp"
+#include "virtualClock.hpp"
 
+namespace hbreukers
+{
+
+namespace detail
+{
+
+// Stores its elements back to back in declaration order (std::tuple does not
+// guarantee any order)
+template<typename... Ts>
+struct ComponentLayout
+{};
+
+template<typename T, typename... Ts>
+struct ComponentLayout<T, Ts...>
+{
+    template<typename U, typename... Us>
+    explicit ComponentLayout(U&& head, Us&&... tail):
+    mHead(std::forward<U>(head)),
+    mTail(std::forward<Us>(tail)...)
+    {}
+
+    T mHead;
+    [[no_unique_address]] ComponentLayout<Ts...> mTail;
+};
+
+template<std::size_t I, typename Layout>
+constexpr auto& get(Layout& layout)
+{
+    if constexpr(I == 0)
+    {
+        return layout.mHead;
+    }
+    else
+    {
+        return get<I - 1>(layout.mTail);
+    }
+}
+
+// Components may still be handed over as pointers to objects owned elsewhere
+template<typename T>
+T& deref(T& component)
+{
+    return component;
+}
+
+template<typename T>
+T& deref(T* component)
+{
+    return *component;
+}
+
+// Owns the stream components of program graph P. The i-th component belongs to
+// the i-th Node of P::Nodes, so node identifiers are free to be any tag and
+// several components may share a C++ type. Components are laid out in
+// topological order (ignoring feedback edges), which is also the order in
+// which an event visits them.
 template<typename P, typename... StreamTypes>
+class ComponentStore
+{
+    using Nodes = typename P::Nodes;
+
+public:
+    static_assert(validProgram<P, StreamTypes...>, "Invalid program graph, see the diagnostics above");
+
+    // Falls back to the listed order for invalid graphs, so that the
+    // diagnostics above are not buried under follow-up errors
+    static constexpr auto order = []
+    {
+        if constexpr(validProgram<P, StreamTypes...>)
+        {
+            return ctgl::graph::topologicalSort(ForwardProgram<P>{});
+        }
+        else
+        {
+            return Nodes{};
+        }
+    }();
+
+    explicit ComponentStore(StreamTypes... streams):
+    ComponentStore(std::forward_as_tuple(std::move(streams)...), order)
+    {}
+
+    template<typename Node>
+    auto& component()
+    {
+        constexpr int slot = ctgl::list::indexOf(Node{}, order);
+        static_assert(slot >= 0, "Node is not part of the program graph");
+        return deref(get<static_cast<std::size_t>(slot)>(mStreamComponents));
+    }
+
+private:
+    template<typename... OrderedNodes>
+    static auto layoutOf(ctgl::List<OrderedNodes...>)
+        -> ComponentLayout<std::tuple_element_t<ctgl::list::indexOf(OrderedNodes{}, Nodes{}), std::tuple<StreamTypes...>>...>;
+
+    using Layout = decltype(layoutOf(order));
+
+    template<typename Args, typename... OrderedNodes>
+    ComponentStore(Args&& streams, ctgl::List<OrderedNodes...>):
+    mStreamComponents(std::get<ctgl::list::indexOf(OrderedNodes{}, Nodes{})>(std::move(streams))...)
+    {}
+
+    Layout mStreamComponents;
+};
+
+// The stream component type of Node
+template<typename Store, typename Node>
+using ComponentType = std::remove_reference_t<decltype(std::declval<Store&>().template component<Node>())>;
+
+// The nodes of Store with a timer (see DataStreamProcess::onTimer), in topological order
+template<typename Store>
+constexpr auto timedNodesOf()
+{
+    return []<typename... Nodes>(ctgl::List<Nodes...>)
+    {
+        using ctgl::list::operator+;
+        return (ctgl::List<>{} + ... + std::conditional_t<TimedStream<ComponentType<Store, ctgl::Node<Nodes>>>,
+                                                          ctgl::List<ctgl::Node<Nodes>>, ctgl::List<>>{});
+    }(ctgl::rtutil::nodeListToList(Store::order));
+}
+
+template<typename T>
+constexpr std::string_view typeName()
+{
+    return std::source_location::current().function_name();
+}
+
+// FNV-1a over the names of the component types in topological order, written
+// with every snapshot so that a checkpoint is only restored into the graph
+// that took it
+template<typename Store>
+constexpr std::uint64_t fingerprintOf()
+{
+    return []<typename... Nodes>(ctgl::List<Nodes...>)
+    {
+        std::uint64_t hash = 0xcbf29ce484222325;
+        const auto add = [&](std::string_view name)
+        {
+            for(const char c : name)
+            {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+            }
+        };
+        (add(typeName<ComponentType<Store, ctgl::Node<Nodes>>>()), ...);
+        return hash;
+    }(ctgl::rtutil::nodeListToList(Store::order));
+}
+
+}
+
+// Runs program graph P on the calling thread: every step polls the sources
+// and pushes each result depth first through the graph before the next one.
+// Components are passed in the order of P::Nodes (see detail::ComponentStore).
+//
+// A process may return a Task instead of a value. The task is spawned on the
+// scheduler of the manager and its result continues through the graph once
+// it completes, while later events keep flowing. The input has moved on and
+// the per-event arena is reset by then, so such processes take their input by
+// value and no std::pmr::memory_resource*.
+//
+// A cycle is run when one of its edges is marked as a ctgl::FeedbackEdge; any
+// other cycle fails to compile. What the tail of a feedback edge emits is
+// queued and handed to its head at the start of the next step, before the
+// sources are polled, so loops such as adaptive thresholds stay inside the
+// graph. Feedback is bounded as set by Feedback (see FeedbackLimits).
+//
+// Nodes with an onTimer(now) hook are called every timerInterval() from a
+// TimingWheel, on the clock of the scheduler: the wall clock, or the
+// VirtualClock of a simulation.
+template<typename P, typename Feedback, typename... StreamTypes>
 class DataStreamManager
 {
+    using Store = detail::ComponentStore<P, StreamTypes...>;
+    using Forward = detail::ForwardProgram<P>;
+    static constexpr auto order = Store::order;
+    static constexpr auto sources = ctgl::graph::getSourceNodes(P{});
+    static constexpr auto feedbackEdges = detail::FeedbackEdges<P>{};
+
+    template<typename Edge>
+    static auto feedbackQueueOf()
+    {
+        using T = detail::EmittedType<P, std::tuple<StreamTypes...>, typename Edge::Tail>;
+        static_assert(!std::ranges::view<T>, "Values on a feedback edge are kept until the next step; a view would dangle");
+        return std::type_identity<FeedbackQueue<T, Feedback::capacity>>{};
+    }
+
+    template<typename... Es>
+    static auto feedbackQueuesOf(ctgl::List<Es...>) -> std::tuple<typename decltype(feedbackQueueOf<Es>())::type...>;
+
+    using FeedbackQueues = decltype(feedbackQueuesOf(feedbackEdges));
+
+    // The next record of Source, held back by simulate() until its turn
+    template<typename Source>
+    static auto headOf()
+    {
+        using Polled = std::remove_cvref_t<decltype(detail::invokeUpdate(
+            std::declval<detail::ComponentType<Store, Source>&>(), std::declval<std::pmr::memory_resource*>()))>;
+        if constexpr(isOptional<Polled>)
+        {
+            return std::type_identity<Polled>{};
+        }
+        else
+        {
+            return std::type_identity<std::optional<Polled>>{};
+        }
+    }
+
+    template<typename... Sources>
+    static auto headsOf(ctgl::List<Sources...>) -> std::tuple<typename decltype(headOf<ctgl::Node<Sources>>())::type...>;
+    using FeedbackGraph = ctgl::Graph<typename P::Nodes, decltype(feedbackEdges)>;
+
+    static constexpr auto timedNodes = detail::timedNodesOf<Store>();
+    static constexpr bool hasTimers = !ctgl::list::empty(timedNodes);
+
+    using Timers = std::conditional_t<hasTimers, TimingWheel<std::uint32_t>, std::monostate>;
+
+    static constexpr std::uint64_t checkpointMagic = 0x32544e504b43524b; // "KRCKPNT2"
+    static constexpr std::uint64_t fingerprint = detail::fingerprintOf<Store>();
+
+    // Longest a step producing nothing blocks in the sources (see idle())
+    static constexpr std::chrono::milliseconds idleWait{1};
+
 public:
-    DataStreamManager(const StreamTypes&... streams ):
-    mStreamComponents(streams...)
+    explicit DataStreamManager(StreamTypes... streams):
+    mStreamComponents(std::move(streams)...),
+    mTimers(makeTimers())
     {}
 
+    DataStreamManager(const DataStreamManager&) = delete;
+    DataStreamManager& operator=(const DataStreamManager&) = delete;
+
+    // Runs until stop() is called or every source is exhausted and the tasks
+    // and feedback still in flight completed, then has the nodes with a
+    // finish() member hand on what they held back
     void run()
     {
-        using Nodes = typename P::Nodes;
-        constexpr auto frontNode = ctgl::list::front(Nodes{});
-        constexpr auto adjs = ctgl::graph::getAdjacentNodes(P{},frontNode);
-        auto front = std::get<typename decltype(frontNode)::underlying>(mStreamComponents);
+        while(!mStopped.load(std::memory_order_relaxed) && !(exhausted() && feedbackDrained()))
+        {
+            if(!step())
+            {
+                idle(idleTimeout());
+            }
+        }
+        drain();
+        finish();
+    }
 
-        while(1)
+    // Like run(), additionally handing the checkpointer the chance to snapshot
+    // the graph between events in which no task or feedback record is in
+    // flight, and once more when the run ends that way
+    template<typename Checkpointer>
+    void run(Checkpointer& checkpointer)
+    {
+        while(!mStopped.load(std::memory_order_relaxed) && !(exhausted() && feedbackDrained()))
         {
-            const auto val = front->update();
+            if(!step())
+            {
+                idle(idleTimeout());
+            }
+            if(settled())
+            {
+                checkpointer.tick(*this);
+            }
+        }
+        drain();
+        finish();
+        if(settled())
+        {
+            checkpointer.checkpoint(*this);
+        }
+    }
 
-            ctgl::rtutil::transformList( 
-                [&]<typename AdjacentNode>()
+    // Replays the sources on clock for reproducible backtests. Of the records
+    // the sources hold next, the one with the earliest timeOf(record) goes
+    // through the graph first (on ties the source listed first), after clock
+    // moved to its time. Tasks sleeping with sleepFor() wake in between at the
+    // virtual time they are due and feedback settles before the next record,
+    // so a run never waits on the wall clock and comes out the same every
+    // time. timeOf returns a std::chrono::duration since the epoch of the
+    // recording. A source without a record is polled until it has one or is
+    // exhausted, as that record could be the earliest, so this is meant for
+    // recorded rather than live sources. Timers of nodes start with the first
+    // record and stop with the last one. A source with a timer is polled like
+    // the others, but does not hold the others back while it has no record,
+    // as it may emit from its timer instead; one whose records timeOf cannot
+    // date, such as a TimerSource, runs on its timer alone. The scheduler
+    // keeps time by clock from then on.
+    template<typename TimeOf>
+    void simulate(VirtualClock& clock, TimeOf timeOf)
+    {
+        mScheduler.useClock(clock);
+        decltype(headsOf(ctgl::rtutil::nodeListToList(sources))) heads;
+        while(!mStopped.load(std::memory_order_relaxed))
+        {
+            bool waiting = false;
+            int earliest = -1;
+            VirtualClock::time_point next{};
+            ctgl::rtutil::transformList(
+                [&]<typename Source>()
+                {
+                    collectHead(ctgl::Node<Source>{}, heads, waiting, earliest, next, timeOf);
+                },
+                ctgl::rtutil::nodeListToList(sources)
+            );
+            if(waiting)
+            {
+                idle(idleWait);
+                continue;
+            }
+            if(earliest < 0)
+            {
+                break;
+            }
+            advanceTo(clock, next);
+            if constexpr(hasTimers)
+            {
+                // Arms the timers at the first record
+                fireTimers(clock.now());
+            }
+            ctgl::rtutil::transformList(
+                [&]<typename Source>()
                 {
-                    processNode(ctgl::Node<AdjacentNode>{}, P{}, val);
+                    constexpr int slot = ctgl::list::indexOf(ctgl::Node<Source>{}, sources);
+                    if(slot == earliest)
+                    {
+                        auto& head = std::get<slot>(heads);
+                        mDepth = 0;
+                        if constexpr(emits<ctgl::Node<Source>, Forward>)
+                        {
+                            emit(ctgl::Node<Source>{}, Forward{}, *head);
+                        }
+                        head.reset();
+                        mArena.reset();
+                    }
                 },
-                ctgl::rtutil::nodeListToList(adjs)
+                ctgl::rtutil::nodeListToList(sources)
             );
+            while(runFeedback())
+            {}
+            resumeTasks();
+        }
+        // Every record went through; tasks still asleep wake at their time
+        while(!mStopped.load(std::memory_order_relaxed) && !settled())
+        {
+            if(runFeedback())
+            {
+                continue;
+            }
+            if(const auto timer = mScheduler.nextTimer())
+            {
+                clock.advanceTo(*timer);
+            }
+            else
+            {
+                mScheduler.waitForWork();
+            }
+            resumeTasks();
         }
+        finish();
+    }
+
+    // Reports whether all sources ran dry; sources without an exhausted()
+    // member never do
+    bool exhausted()
+    {
+        bool result = true;
+        ctgl::rtutil::transformList(
+            [&]<typename Source>()
+            {
+                result = result && exhausted(ctgl::Node<Source>{});
+            },
+            ctgl::rtutil::nodeListToList(sources)
+        );
+        return result;
+    }
+
+    void stop()
+    {
+        mStopped.store(true, std::memory_order_relaxed);
+        mScheduler.wake();
+    }
+
+    // Hands the records queued on feedback edges to their heads, runs the
+    // timers that expired, polls every source once and pushes the results
+    // through the graph, then continues the tasks that became ready. Returns
+    // whether anything happened.
+    bool step()
+    {
+        bool produced = runFeedback();
+        if constexpr(hasTimers)
+        {
+            produced = fireTimers(mScheduler.now()) || produced;
+        }
+        ctgl::rtutil::transformList(
+            [&]<typename Source>()
+            {
+                produced = processSource(ctgl::Node<Source>{}) || produced;
+            },
+            ctgl::rtutil::nodeListToList(sources)
+        );
+        return resumeTasks() || produced;
     }
 
     template<typename Node, typename Graph, typename Data>
     void processNode([[maybe_unused]]Node node, [[maybe_unused]] Graph graph, Data&& input)
     {
-        constexpr auto adjs = ctgl::graph::getAdjacentNodes(Graph{},Node{});
-        auto stream = std::get<typename Node::underlying>(mStreamComponents);
-        if constexpr(ctgl::list::size(adjs)>0)
+        auto& stream = component<Node>();
+        using Tag = typename std::remove_cvref_t<decltype(stream)>::NodeTag;
+        if constexpr(std::is_same_v<Tag, FilterNodeTag>)
+        {
+            // A rejected record never reaches (nor constructs anything in) the subtree
+            if(!stream.test(input))
+            {
+                return;
+            }
+            if constexpr(emits<Node, Graph>)
+            {
+                emit(Node{}, Graph{}, input);
+            }
+        }
+        else if constexpr(std::is_same_v<Tag, RouterNodeTag>)
         {
-            const auto val = stream->update(std::forward<Data>(input));
+            constexpr auto adjs = ctgl::graph::getAdjacentNodes(Graph{}, Node{});
+            static_assert(ctgl::list::empty(ctgl::graph::getOutgoingEdges(FeedbackGraph{}, Node{})),
+                          "A router selects among its adjacent nodes, it cannot have a feedback edge");
+            // Only the selected subgraphs run
+            detail::forEachSelected<ctgl::list::size(adjs)>(stream.select(input), [&]<std::size_t I>()
+            {
+                processNode(ctgl::list::at<I>(adjs), Graph{}, input);
+            });
+        }
+        else if constexpr(std::is_same_v<Tag, FlatMapNodeTag>)
+        {
+            const auto& vals = update(stream, std::forward<Data>(input));
+            if constexpr(emits<Node, Graph>)
+            {
+                for(const auto& val : vals)
+                {
+                    emit(Node{}, Graph{}, val);
+                }
+            }
+        }
+        else if constexpr(isTask<std::remove_cvref_t<decltype(update(stream, std::forward<Data>(input)))>>)
+        {
+            using Process = std::remove_cvref_t<decltype(stream.function())>;
+            static_assert(!std::is_reference_v<detail::InputParameter<Process, std::remove_cvref_t<Data>>>,
+                          "A process returning a Task runs after its input moved on, so it has to take it by value");
+            static_assert(!requires { stream.update(std::declval<Data>(), std::declval<std::pmr::memory_resource*>()); },
+                          "A process returning a Task outlives the per-event arena, so it cannot take a std::pmr::memory_resource*");
+            mScheduler.spawn(continueWith(Node{}, Graph{}, update(stream, std::forward<Data>(input)), mDepth));
+        }
+        else if constexpr(emits<Node, Graph>)
+        {
+            decltype(auto) val = update(stream, std::forward<Data>(input));
+            emit(Node{}, Graph{}, val);
+        }
+        else
+        {
+            update(stream, std::forward<Data>(input));
+        }
+    }
 
-            ctgl::rtutil::transformList( 
-                [&]<typename AdjacentNode>()
+    // Writes the state of every component in topological order, each in a
+    // block of its own; components without state leave their block empty.
+    // Only call between events while no task or feedback record is in flight,
+    // as those are not part of the snapshot.
+    template<typename Writer>
+    void snapshot(Writer& writer)
+    {
+        if(!settled())
+        {
+            throw std::logic_error("Cannot snapshot while tasks or feedback records are in flight");
+        }
+        writer.write(checkpointMagic);
+        writer.write(fingerprint);
+        ctgl::rtutil::transformList(
+            [&]<typename Node>()
+            {
+                const auto block = writer.beginBlock();
+                auto& stream = component<ctgl::Node<Node>>();
+                if constexpr(requires { stream.snapshot(writer); })
                 {
-                    processNode(ctgl::Node<AdjacentNode>{}, Graph{}, val);
+                    stream.snapshot(writer);
+                }
+                writer.endBlock(block);
+            },
+            ctgl::rtutil::nodeListToList(order)
+        );
+    }
+
+    template<typename Reader>
+    void restore(Reader& reader)
+    {
+        if(reader.template read<std::uint64_t>() != checkpointMagic
+           || reader.template read<std::uint64_t>() != fingerprint)
+        {
+            throw std::runtime_error("Checkpoint does not belong to this program graph");
+        }
+        ctgl::rtutil::transformList(
+            [&]<typename Node>()
+            {
+                auto block = reader.block();
+                auto& stream = component<ctgl::Node<Node>>();
+                if constexpr(requires { stream.restore(block); })
+                {
+                    stream.restore(block);
+                }
+                // A component reading less than it wrote restores the wrong state
+                if(!block.empty())
+                {
+                    throw std::runtime_error("Checkpoint state of a component was not fully restored");
+                }
+            },
+            ctgl::rtutil::nodeListToList(order)
+        );
+        if(!reader.empty())
+        {
+            throw std::runtime_error("Checkpoint has trailing bytes");
+        }
+    }
+
+    // The stream component belonging to Node
+    template<typename Node>
+    auto& component()
+    {
+        return mStreamComponents.template component<Node>();
+    }
+
+    // Per-event arena handed to processes taking a std::pmr::memory_resource*
+    EventArena& arena()
+    {
+        return mArena;
+    }
+
+    // Runs the tasks returned by processes
+    Scheduler& scheduler()
+    {
+        return mScheduler;
+    }
+
+    const FeedbackStats& feedbackStats() const
+    {
+        return mFeedbackStats;
+    }
+
+private:
+    template<typename Source>
+    bool exhausted(Source)
+    {
+        auto& source = component<Source>();
+        if constexpr(requires { source.exhausted(); })
+        {
+            return source.exhausted();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // Lets the nodes holding records back hand them on, in topological order
+    void finish()
+    {
+        ctgl::rtutil::transformList(
+            [&]<typename Node>()
+            {
+                auto& stream = component<ctgl::Node<Node>>();
+                if constexpr(requires { stream.finish(); })
+                {
+                    stream.finish();
+                }
+            },
+            ctgl::rtutil::nodeListToList(order)
+        );
+    }
+
+    // Polls Source unless it holds a record already, and keeps track of the
+    // earliest record and whether a source may still produce an earlier one
+    template<typename Source, typename Heads, typename TimeOf>
+    void collectHead(Source, Heads& heads, bool& waiting, int& earliest, VirtualClock::time_point& next, TimeOf& timeOf)
+    {
+        constexpr int slot = ctgl::list::indexOf(Source{}, sources);
+        constexpr bool timed = detail::TimedStream<detail::ComponentType<Store, Source>>;
+        auto& head = std::get<slot>(heads);
+        using Record = typename std::remove_cvref_t<decltype(head)>::value_type;
+        if constexpr(!std::invocable<TimeOf&, const Record&>)
+        {
+            // Such as a TimerSource, with nothing recorded to merge
+            static_assert(timed, "timeOf has to date the records of every source without a timer");
+            return;
+        }
+        else
+        {
+            if(!head)
+            {
+                pollInto(component<Source>(), head);
+            }
+            if(!head)
+            {
+                // Virtual time only moves with the records, so waiting for a
+                // timer to emit would never end
+                waiting = waiting || (!timed && !exhausted(Source{}));
+                return;
+            }
+            const VirtualClock::time_point when{std::chrono::duration_cast<VirtualClock::duration>(timeOf(*head))};
+            if(earliest < 0 || when < next)
+            {
+                earliest = slot;
+                next = when;
+            }
+        }
+    }
+
+    // Polls with the default resource rather than the arena, as the record
+    // outlives the events that go through the graph before its turn
+    template<typename Stream, typename Head>
+    static void pollInto(Stream& stream, Head& head)
+    {
+        decltype(auto) val = detail::invokeUpdate(stream, std::pmr::get_default_resource());
+        if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>)
+        {
+            if(val)
+            {
+                head.emplace(*std::forward<decltype(val)>(val));
+            }
+        }
+        else
+        {
+            head.emplace(std::forward<decltype(val)>(val));
+        }
+    }
+
+    // Wakes the tasks sleeping until when and runs the timers expiring by
+    // then, each at the time it is due
+    void advanceTo(VirtualClock& clock, VirtualClock::time_point when)
+    {
+        for(auto due = nextDue(); due && *due <= when; due = nextDue())
+        {
+            clock.advanceTo(*due);
+            resumeTasks();
+            if constexpr(hasTimers)
+            {
+                fireTimers(clock.now());
+            }
+            while(runFeedback())
+            {}
+        }
+        clock.advanceTo(when);
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> nextDue() const
+    {
+        auto due = mScheduler.nextTimer();
+        if constexpr(hasTimers)
+        {
+            if(const auto expiry = mTimers.nextExpiry(); expiry && (!due || *expiry < *due))
+            {
+                due = expiry;
+            }
+        }
+        return due;
+    }
+
+    static Timers makeTimers()
+    {
+        if constexpr(hasTimers)
+        {
+            return Timers(detail::timerResolution);
+        }
+        else
+        {
+            return {};
+        }
+    }
+
+    // Arms the timers on the first call. Returns whether any expired.
+    bool fireTimers(std::chrono::steady_clock::time_point now)
+    {
+        if(!mTimersArmed)
+        {
+            mTimersArmed = true;
+            [&]<typename... Nodes>(ctgl::List<Nodes...>)
+            {
+                (mTimers.schedule(now + intervalOf<ctgl::Node<Nodes>>(),
+                                  static_cast<std::uint32_t>(ctgl::list::indexOf(ctgl::Node<Nodes>{}, timedNodes))), ...);
+            }(ctgl::rtutil::nodeListToList(timedNodes));
+            return false;
+        }
+        bool fired = false;
+        mTimers.advance(now, [&](std::uint32_t slot, std::chrono::steady_clock::time_point expiry)
+        {
+            fired = true;
+            ctgl::rtutil::transformList(
+                [&]<typename Node>()
+                {
+                    if(ctgl::list::indexOf(ctgl::Node<Node>{}, timedNodes) == static_cast<int>(slot))
+                    {
+                        runTimer(ctgl::Node<Node>{}, now);
+                        // Keeps to the period unless the timer fell behind by more than one
+                        auto next = expiry + intervalOf<ctgl::Node<Node>>();
+                        if(next <= now)
+                        {
+                            next = now + intervalOf<ctgl::Node<Node>>();
+                        }
+                        mTimers.schedule(next, slot);
+                    }
                 },
-                ctgl::rtutil::nodeListToList(adjs)
+                ctgl::rtutil::nodeListToList(timedNodes)
             );
+        });
+        return fired;
+    }
+
+    template<typename Node>
+    std::chrono::steady_clock::duration intervalOf()
+    {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::nanoseconds(component<Node>().timerInterval()));
+    }
+
+    template<typename Node>
+    void runTimer(Node, std::chrono::steady_clock::time_point now)
+    {
+        auto& stream = component<Node>();
+        mDepth = 0;
+        if constexpr(std::is_void_v<decltype(stream.onTimer(now))>)
+        {
+            stream.onTimer(now);
         }
-        else 
+        else
         {
-            stream->update(std::forward<Data>(input));
+            decltype(auto) val = stream.onTimer(now);
+            if constexpr(emits<Node, Forward>)
+            {
+                // Like the result of update, an optional is only unwrapped for sources
+                if constexpr(isOptional<std::remove_cvref_t<decltype(val)>> && ctgl::list::contains(Node{}, sources))
+                {
+                    if(val)
+                    {
+                        emit(Node{}, Forward{}, *val);
+                    }
+                }
+                else
+                {
+                    emit(Node{}, Forward{}, val);
+                }
+            }
         }
+        mArena.reset();
     }
 
-private:
-    std::tuple<StreamTypes...> mStreamComponents;
+    // Returns whether the source produced a value
+    template<typename Source>
+    bool processSource(Source)
+    {
+        bool produced = true;
+        mDepth = 0;
+        {
+            [[maybe_unused]] decltype(auto) val = update(component<Source>());
+            if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>)
+            {
+                produced = val.has_value();
+            }
+            if constexpr(emits<Source, Forward>)
+            {
+                if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>)
+                {
+                    if(val)
+                    {
+                        emit(Source{}, Forward{}, *val);
+                    }
+                }
+                else
+                {
+                    emit(Source{}, Forward{}, val);
+                }
+            }
+        }
+        mArena.reset();
+        return produced;
+    }
+
+    template<typename Source>
+    static constexpr bool canWait = requires(detail::ComponentType<Store, Source>& source) { source.waitReady(std::chrono::nanoseconds{}); };
+
+    // How long idle() may block without running a timer or task late
+    std::chrono::nanoseconds idleTimeout() const
+    {
+        std::chrono::nanoseconds timeout = idleWait;
+        if(const auto due = nextDue())
+        {
+            timeout = std::clamp(std::chrono::duration_cast<std::chrono::nanoseconds>(*due - mScheduler.now()),
+                                 std::chrono::nanoseconds::zero(), timeout);
+        }
+        return timeout;
+    }
+
+    // After a step in which nothing happened, blocks in the sources for up to
+    // timeout until one of them has data, when all of them can wait for it.
+    // Other sources are polled again right away, as they give no way to tell
+    // when they are ready.
+    void idle([[maybe_unused]] std::chrono::nanoseconds timeout)
+    {
+        constexpr bool waitable = []<typename... Sources>(ctgl::List<Sources...>)
+        {
+            return (canWait<ctgl::Node<Sources>> && ...);
+        }(ctgl::rtutil::nodeListToList(sources));
+        if constexpr(waitable)
+        {
+            if(timeout == std::chrono::nanoseconds::zero())
+            {
+                return;
+            }
+            const auto slice = timeout / ctgl::list::size(sources);
+            bool ready = false;
+            ctgl::rtutil::transformList(
+                [&]<typename Source>()
+                {
+                    ready = ready || component<ctgl::Node<Source>>().waitReady(slice);
+                },
+                ctgl::rtutil::nodeListToList(sources)
+            );
+        }
+    }
+
+    // Awaits the task of Node and pushes its result through the rest of the
+    // graph, at the feedback depth of the record it was spawned for
+    template<typename Node, typename Graph, typename T>
+    Task<void> continueWith(Node, Graph, Task<T> task, std::uint32_t depth)
+    {
+        if constexpr(std::is_void_v<T>)
+        {
+            co_await std::move(task);
+        }
+        else
+        {
+            const auto val = co_await std::move(task);
+            if constexpr(emits<Node, Graph>)
+            {
+                mDepth = depth;
+                emit(Node{}, Graph{}, val);
+            }
+        }
+    }
+
+    bool resumeTasks()
+    {
+        if(mScheduler.runReady())
+        {
+            mArena.reset();
+            return true;
+        }
+        return false;
+    }
+
+    void drain()
+    {
+        while(!mStopped.load(std::memory_order_relaxed))
+        {
+            if(runFeedback())
+            {
+                continue;
+            }
+            if(mScheduler.pending() == 0)
+            {
+                break;
+            }
+            mScheduler.waitForWork();
+            resumeTasks();
+        }
+    }
+
+    // Whether Node passes its output on, over a normal or a feedback edge
+    template<typename Node, typename Graph>
+    static constexpr bool emits = ctgl::list::size(ctgl::graph::getAdjacentNodes(Graph{}, Node{})) > 0
+        || ctgl::list::size(ctgl::graph::getOutgoingEdges(FeedbackGraph{}, Node{})) > 0;
+
+    template<typename Node, typename Graph, typename Data>
+    void emit(Node, Graph, const Data& val)
+    {
+        constexpr auto adjs = ctgl::graph::getAdjacentNodes(Graph{}, Node{});
+        if constexpr(ctgl::list::size(adjs)>0)
+        {
+            processAdjacent(adjs, Graph{}, val);
+        }
+        feedBack(Node{}, val, feedbackEdges);
+    }
+
+    // Queues the output of Node on the feedback edges leaving it, unless the
+    // record went around MaxDepth times already
+    template<typename Node, typename Data, typename... Es>
+    void feedBack(Node, [[maybe_unused]] const Data& val, ctgl::List<Es...>)
+    {
+        ([&]
+        {
+            if constexpr(std::is_same_v<typename Es::Tail, Node>)
+            {
+                constexpr auto slot = static_cast<std::size_t>(ctgl::list::indexOf(Es{}, feedbackEdges));
+                if(mDepth >= Feedback::maxDepth)
+                {
+                    ++mFeedbackStats.cutOff;
+                }
+                else if(!std::get<slot>(mFeedbackQueues).push(val, mDepth + 1))
+                {
+                    ++mFeedbackStats.overflowed;
+                }
+            }
+        }(), ...);
+    }
+
+    // Hands the records queued before this call to the heads of their
+    // feedback edges; records fed back meanwhile wait for the next call
+    bool runFeedback()
+    {
+        return [&]<typename... Es>(ctgl::List<Es...>)
+        {
+            bool ran = false;
+            ([&]
+            {
+                constexpr auto slot = static_cast<std::size_t>(ctgl::list::indexOf(Es{}, feedbackEdges));
+                auto& queue = std::get<slot>(mFeedbackQueues);
+                for(auto n = queue.size(); n > 0; --n)
+                {
+                    auto entry = std::move(queue.front());
+                    queue.pop();
+                    mDepth = entry.mDepth;
+                    processNode(typename Es::Head{}, Forward{}, std::move(entry.mValue));
+                    mArena.reset();
+                    ran = true;
+                }
+            }(), ...);
+            return ran;
+        }(feedbackEdges);
+    }
+
+    bool feedbackDrained() const
+    {
+        return std::apply([](const auto&... queues) { return (queues.empty() && ...); }, mFeedbackQueues);
+    }
+
+    // Whether every record that went in came out, the state a snapshot needs
+    bool settled() const
+    {
+        return feedbackDrained() && mScheduler.pending() == 0;
+    }
+
+    template<typename Stream, typename... Data>
+    decltype(auto) update(Stream& stream, Data&&... input)
+    {
+        return detail::invokeUpdate(stream, mArena.resource(), std::forward<Data>(input)...);
+    }
+
+    template<typename Adjacent, typename Graph, typename Data>
+    void processAdjacent(Adjacent adjs, Graph, const Data& val)
+    {
+        ctgl::rtutil::transformList(
+            [&]<typename AdjacentNode>()
+            {
+                processNode(ctgl::Node<AdjacentNode>{}, Graph{}, val);
+            },
+            ctgl::rtutil::nodeListToList(adjs)
+        );
+    }
+
+    Store mStreamComponents;
+    EventArena mArena;
+    Scheduler mScheduler;
+    FeedbackQueues mFeedbackQueues;
+    FeedbackStats mFeedbackStats;
+    [[no_unique_address]] Timers mTimers;
+    bool mTimersArmed = false;
+    // Times the record travelling through the graph was fed back
+    std::uint32_t mDepth = 0;
+    std::atomic<bool> mStopped{false};
 };
 
-template<typename P, typename... Vars>
-auto constructDataStreamManager([[maybe_unused]]P&& program, [[maybe_unused]]Vars&&... vars)
+// Takes the stream components by value (or as pointers to externally owned
+// components) in the order of the Nodes of the program graph
+template<typename Feedback = FeedbackLimits<>, typename P, typename... Vars>
+auto constructDataStreamManager([[maybe_unused]]P&& program, Vars&&... vars)
 {
-    return DataStreamManager<P, Vars...>{std::forward<Vars>(vars)...};
-}
\ No newline at end of file
+    return DataStreamManager<std::remove_cvref_t<P>, Feedback, std::decay_t<Vars>...>{std::forward<Vars>(vars)...};
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace hbreukers
+{
+
+// Monotonic arena for values that only live while one event traverses the
+// graph. Allocation is a pointer bump into a block reserved up front and
+// everything is released in bulk by reset(); an event outgrowing the block
+// falls back to the upstream resource until the next reset.
+class EventArena
+{
+public:
+    static constexpr std::size_t defaultSize = 64 * 1024;
+
+    explicit EventArena(std::size_t size = defaultSize,
+                        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()):
+    mSize(size),
+    mBuffer(std::make_unique<std::byte[]>(size)),
+    mResource(mBuffer.get(), mSize, upstream)
+    {}
+
+    EventArena(const EventArena&) = delete;
+    EventArena& operator=(const EventArena&) = delete;
+
+    std::pmr::memory_resource* resource()
+    {
+        return &mResource;
+    }
+
+    void reset()
+    {
+        mResource.release();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return mSize;
+    }
+
+private:
+    std::size_t mSize;
+    std::unique_ptr<std::byte[]> mBuffer;
+    std::pmr::monotonic_buffer_resource mResource;
+};
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace hbreukers
+{
+
+// Bounds of the feedback edges of a DataStreamManager: a record is fed back
+// at most MaxDepth times, and each feedback edge holds at most Capacity
+// records until the next round
+template<std::uint32_t MaxDepth = 8, std::size_t Capacity = 64>
+struct FeedbackLimits
+{
+    static_assert(Capacity > 0, "A feedback edge needs room for at least one record");
+
+    static constexpr std::uint32_t maxDepth = MaxDepth;
+    static constexpr std::size_t capacity = Capacity;
+};
+
+// Records that were not fed back, as they had gone around MaxDepth times
+// already (cutOff) or the queue of their edge was full (overflowed)
+struct FeedbackStats
+{
+    std::size_t cutOff = 0;
+    std::size_t overflowed = 0;
+};
+
+// Fixed capacity FIFO with inline storage holding the records on one feedback
+// edge, each with the number of times it went around the loop
+template<typename T, std::size_t Capacity>
+class FeedbackQueue
+{
+public:
+    struct Entry
+    {
+        T mValue;
+        std::uint32_t mDepth;
+    };
+
+    FeedbackQueue() = default;
+
+    FeedbackQueue(const FeedbackQueue&) = delete;
+    FeedbackQueue& operator=(const FeedbackQueue&) = delete;
+
+    ~FeedbackQueue()
+    {
+        while(!empty())
+        {
+            pop();
+        }
+    }
+
+    // Returns false (and drops the value) when the queue is full
+    bool push(const T& value, std::uint32_t depth)
+    {
+        if(mSize == Capacity)
+        {
+            return false;
+        }
+        std::construct_at(slot((mHead + mSize) % Capacity), value, depth);
+        ++mSize;
+        return true;
+    }
+
+    Entry& front()
+    {
+        return *slot(mHead);
+    }
+
+    void pop()
+    {
+        std::destroy_at(slot(mHead));
+        mHead = (mHead + 1) % Capacity;
+        --mSize;
+    }
+
+    [[nodiscard]] std::size_t size() const { return mSize; }
+    [[nodiscard]] bool empty() const { return mSize == 0; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    Entry* slot(std::size_t i)
+    {
+        return std::launder(reinterpret_cast<Entry*>(mStorage) + i);
+    }
+
+    alignas(Entry) std::byte mStorage[sizeof(Entry) * Capacity];
+    std::size_t mHead = 0;
+    std::size_t mSize = 0;
+};
+
+}
@@ -0,0 +1,724 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "recordBytes.hpp"
+
+namespace hbreukers
+{
+
+enum class FsyncPolicy
+{
+    Never,
+    // fdatasync after every flushed buffer
+    OnFlush,
+    // fsync once when the sink is closed
+    OnClose
+};
+
+enum class WriteBackend
+{
+    // io_uring when the kernel allows it, a writer thread otherwise
+    Auto,
+    IoUring,
+    Thread
+};
+
+struct FileSinkOptions
+{
+    // A buffer is submitted once it holds this many bytes...
+    std::size_t flushSize = 1 << 20;
+    // ...or at the latest this long after a record came in, kept by a timer
+    // of the manager (see DataStreamProcess::onTimer)
+    std::chrono::microseconds flushInterval = std::chrono::milliseconds(10);
+    FsyncPolicy fsync = FsyncPolicy::OnClose;
+    WriteBackend backend = WriteBackend::Auto;
+    // Prefix every record with its length as a little-endian uint32_t, the
+    // format read back by MappedFrameSource
+    bool framed = false;
+};
+
+namespace detail
+{
+
+inline constexpr std::size_t pageSize = 4096;
+
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(std::size_t capacity)
+    {
+        reserve(capacity);
+    }
+
+    void reserve(std::size_t capacity)
+    {
+        capacity = (capacity + pageSize - 1) / pageSize * pageSize;
+        if(capacity <= mCapacity)
+        {
+            return;
+        }
+        auto* data = static_cast<std::byte*>(::operator new(capacity, std::align_val_t{pageSize}));
+        if(mSize > 0)
+        {
+            std::memcpy(data, mData.get(), mSize);
+        }
+        mData.reset(data);
+        mCapacity = capacity;
+    }
+
+    void append(std::span<const std::byte> bytes)
+    {
+        std::memcpy(mData.get() + mSize, bytes.data(), bytes.size());
+        mSize += bytes.size();
+    }
+
+    void clear() { mSize = 0; }
+    std::span<const std::byte> bytes() const { return {mData.get(), mSize}; }
+    [[nodiscard]] std::size_t size() const { return mSize; }
+    [[nodiscard]] std::size_t capacity() const { return mCapacity; }
+    [[nodiscard]] bool empty() const { return mSize == 0; }
+
+private:
+    struct Free
+    {
+        void operator()(std::byte* data) const
+        {
+            ::operator delete(data, std::align_val_t{pageSize});
+        }
+    };
+
+    std::unique_ptr<std::byte, Free> mData;
+    std::size_t mSize = 0;
+    std::size_t mCapacity = 0;
+};
+
+// Positional writes completing in the background. Each buffer slot has at most
+// one write in flight; wait(slot) blocks until it (and its sync) completed.
+class AsyncWriter
+{
+public:
+    virtual ~AsyncWriter() = default;
+    virtual void submit(std::size_t slot, std::span<const std::byte> bytes, std::uint64_t offset, bool sync) = 0;
+    virtual void wait(std::size_t slot) = 0;
+};
+
+inline constexpr std::size_t bufferSlots = 2;
+
+class IoUringWriter final : public AsyncWriter
+{
+public:
+    // Throws std::system_error when the kernel refuses io_uring
+    explicit IoUringWriter(int fd):
+    mFd(fd)
+    {
+        io_uring_params params{};
+        mRing = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if(mRing < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+        mSqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        mCqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        if(params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            mSqSize = mCqSize = std::max(mSqSize, mCqSize);
+        }
+        mSq = map(mSqSize, IORING_OFF_SQ_RING);
+        mCq = (params.features & IORING_FEAT_SINGLE_MMAP) ? mSq : map(mCqSize, IORING_OFF_CQ_RING);
+        mSqes = static_cast<io_uring_sqe*>(static_cast<void*>(map(mSqesSize, IORING_OFF_SQES)));
+
+        mSqTail = at<unsigned>(mSq, params.sq_off.tail);
+        mSqMask = *at<unsigned>(mSq, params.sq_off.ring_mask);
+        mSqArray = at<unsigned>(mSq, params.sq_off.array);
+        mCqHead = at<unsigned>(mCq, params.cq_off.head);
+        mCqTail = at<unsigned>(mCq, params.cq_off.tail);
+        mCqMask = *at<unsigned>(mCq, params.cq_off.ring_mask);
+        mCqes = at<io_uring_cqe>(mCq, params.cq_off.cqes);
+    }
+
+    IoUringWriter(const IoUringWriter&) = delete;
+    IoUringWriter& operator=(const IoUringWriter&) = delete;
+
+    ~IoUringWriter() override
+    {
+        try
+        {
+            for(std::size_t slot = 0; slot < bufferSlots; ++slot)
+            {
+                drain(slot);
+            }
+        }
+        catch(const std::system_error&)
+        {
+            // Writes still in flight complete or fail on their own once the
+            // ring is closed; FileSink::close() is the place to see the error
+        }
+        unmap();
+    }
+
+    void submit(std::size_t slot, std::span<const std::byte> bytes, std::uint64_t offset, bool sync) override
+    {
+        mSlots[slot] = Slot{bytes, offset, sync, true, 0};
+        pushWrite(slot);
+        enter(1, 0);
+    }
+
+    void wait(std::size_t slot) override
+    {
+        drain(slot);
+        if(const int error = std::exchange(mSlots[slot].error, 0))
+        {
+            throw std::system_error(error, std::generic_category(), "io_uring write");
+        }
+    }
+
+private:
+    static constexpr unsigned entries = 8;
+
+    struct Slot
+    {
+        std::span<const std::byte> remaining;
+        std::uint64_t offset = 0;
+        bool sync = false;
+        bool busy = false;
+        int error = 0;
+    };
+
+    template<typename T>
+    static T* at(std::byte* base, std::uint32_t offset)
+    {
+        return static_cast<T*>(static_cast<void*>(base + offset));
+    }
+
+    std::byte* map(std::size_t size, std::uint64_t offset)
+    {
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, static_cast<off_t>(offset));
+        if(data == MAP_FAILED)
+        {
+            const int error = errno;
+            unmap();
+            throw std::system_error(error, std::generic_category(), "io_uring mmap");
+        }
+        return static_cast<std::byte*>(data);
+    }
+
+    void unmap()
+    {
+        if(mSqes)
+        {
+            ::munmap(mSqes, mSqesSize);
+        }
+        if(mCq && mCq != mSq)
+        {
+            ::munmap(mCq, mCqSize);
+        }
+        if(mSq)
+        {
+            ::munmap(mSq, mSqSize);
+        }
+        ::close(mRing);
+    }
+
+    io_uring_sqe* nextSqe()
+    {
+        const unsigned tail = *mSqTail;
+        const unsigned index = tail & mSqMask;
+        mSqArray[index] = index;
+        io_uring_sqe* sqe = &mSqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // Publishes the entry filled in after nextSqe() to the kernel
+    void commitSqe()
+    {
+        std::atomic_ref<unsigned>(*mSqTail).store(*mSqTail + 1, std::memory_order_release);
+    }
+
+    void pushWrite(std::size_t slot)
+    {
+        const auto& state = mSlots[slot];
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = mFd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(state.remaining.data());
+        sqe->len = static_cast<std::uint32_t>(state.remaining.size());
+        sqe->off = state.offset;
+        sqe->user_data = slot << 1;
+        commitSqe();
+    }
+
+    void pushSync(std::size_t slot)
+    {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = mFd;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = (slot << 1) | 1;
+        commitSqe();
+    }
+
+    void enter(unsigned submit, unsigned wait)
+    {
+        const unsigned flags = wait > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while(::syscall(__NR_io_uring_enter, mRing, submit, wait, flags, nullptr, 0) < 0)
+        {
+            if(errno != EINTR)
+            {
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+        }
+    }
+
+    // Handles completions until the given slot is idle
+    void drain(std::size_t slot)
+    {
+        while(mSlots[slot].busy)
+        {
+            unsigned head = *mCqHead;
+            if(head == std::atomic_ref<unsigned>(*mCqTail).load(std::memory_order_acquire))
+            {
+                enter(0, 1);
+                continue;
+            }
+            const io_uring_cqe& cqe = mCqes[head & mCqMask];
+            complete(cqe.user_data, cqe.res);
+            std::atomic_ref<unsigned>(*mCqHead).store(++head, std::memory_order_release);
+        }
+    }
+
+    void complete(std::uint64_t userData, int result)
+    {
+        auto& state = mSlots[userData >> 1];
+        const bool syncDone = userData & 1;
+        if(result < 0)
+        {
+            state.error = -result;
+            state.busy = false;
+        }
+        else if(syncDone)
+        {
+            state.busy = false;
+        }
+        else if(result == 0 && !state.remaining.empty())
+        {
+            // Retrying would make no progress either
+            state.error = EIO;
+            state.busy = false;
+        }
+        else if(static_cast<std::size_t>(result) < state.remaining.size())
+        {
+            // Short write, continue with the rest
+            state.remaining = state.remaining.subspan(static_cast<std::size_t>(result));
+            state.offset += static_cast<std::uint64_t>(result);
+            pushWrite(userData >> 1);
+            enter(1, 0);
+        }
+        else if(state.sync)
+        {
+            pushSync(userData >> 1);
+            enter(1, 0);
+        }
+        else
+        {
+            state.busy = false;
+        }
+    }
+
+    int mFd;
+    int mRing = -1;
+    std::size_t mSqSize = 0;
+    std::size_t mCqSize = 0;
+    std::size_t mSqesSize = 0;
+    std::byte* mSq = nullptr;
+    std::byte* mCq = nullptr;
+    io_uring_sqe* mSqes = nullptr;
+    unsigned* mSqTail = nullptr;
+    unsigned* mSqArray = nullptr;
+    unsigned mSqMask = 0;
+    unsigned* mCqHead = nullptr;
+    unsigned* mCqTail = nullptr;
+    unsigned mCqMask = 0;
+    io_uring_cqe* mCqes = nullptr;
+    std::array<Slot, bufferSlots> mSlots{};
+};
+
+// Fallback issuing pwrite from a dedicated thread
+class ThreadWriter final : public AsyncWriter
+{
+public:
+    explicit ThreadWriter(int fd):
+    mFd(fd),
+    mThread([this]{ work(); })
+    {}
+
+    ThreadWriter(const ThreadWriter&) = delete;
+    ThreadWriter& operator=(const ThreadWriter&) = delete;
+
+    ~ThreadWriter() override
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        mThread.join();
+    }
+
+    void submit(std::size_t slot, std::span<const std::byte> bytes, std::uint64_t offset, bool sync) override
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mBusy[slot] = true;
+            mJobs.push_back(Job{slot, bytes, offset, sync});
+        }
+        mWake.notify_all();
+    }
+
+    void wait(std::size_t slot) override
+    {
+        std::unique_lock lock(mMutex);
+        mWake.wait(lock, [&]{ return !mBusy[slot]; });
+        if(const int error = std::exchange(mErrors[slot], 0))
+        {
+            throw std::system_error(error, std::generic_category(), "pwrite");
+        }
+    }
+
+private:
+    struct Job
+    {
+        std::size_t slot;
+        std::span<const std::byte> bytes;
+        std::uint64_t offset;
+        bool sync;
+    };
+
+    void work()
+    {
+        std::unique_lock lock(mMutex);
+        while(true)
+        {
+            mWake.wait(lock, [&]{ return mStopping || !mJobs.empty(); });
+            if(mJobs.empty())
+            {
+                return;
+            }
+            const Job job = mJobs.front();
+            mJobs.pop_front();
+            lock.unlock();
+            const int error = write(job);
+            lock.lock();
+            mErrors[job.slot] = error;
+            mBusy[job.slot] = false;
+            mWake.notify_all();
+        }
+    }
+
+    int write(Job job) const
+    {
+        while(!job.bytes.empty())
+        {
+            const auto written = ::pwrite(mFd, job.bytes.data(), job.bytes.size(), static_cast<off_t>(job.offset));
+            if(written < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                return errno;
+            }
+            if(written == 0)
+            {
+                return EIO;
+            }
+            job.bytes = job.bytes.subspan(static_cast<std::size_t>(written));
+            job.offset += static_cast<std::uint64_t>(written);
+        }
+        if(job.sync && ::fdatasync(mFd) != 0)
+        {
+            return errno;
+        }
+        return 0;
+    }
+
+    int mFd;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::deque<Job> mJobs;
+    std::array<bool, bufferSlots> mBusy{};
+    std::array<int, bufferSlots> mErrors{};
+    bool mStopping = false;
+    std::thread mThread;
+};
+
+}
+
+// Sink appending records to a file through two page-aligned buffers: one is
+// filled on the processing thread while the other is written in the
+// background, so the graph only blocks when the disk falls a full buffer
+// behind. Records are written as their recordBytes(). Copies append to the
+// same file. close() reports write errors; closing on destruction swallows
+// them.
+class FileSink
+{
+public:
+    explicit FileSink(const std::string& path, const FileSinkOptions& options = {}):
+    mState(std::make_shared<State>(path, options))
+    {}
+
+    template<typename Record>
+    void operator()(const Record& record)
+    {
+        mState->append(recordBytes(record));
+    }
+
+    // Submits the partially filled buffer
+    void flush()
+    {
+        mState->flush();
+    }
+
+    std::chrono::microseconds timerInterval() const
+    {
+        return mState->flushInterval();
+    }
+
+    void onTimer(std::chrono::steady_clock::time_point)
+    {
+        mState->flush();
+    }
+
+    // Writes out what is buffered, syncs as the FsyncPolicy asks and closes
+    // the file, throwing std::system_error if any of it failed. Records
+    // appended afterwards throw std::logic_error.
+    void close()
+    {
+        mState->close();
+    }
+
+    // Whether writes go through io_uring rather than the writer thread
+    bool usesIoUring() const
+    {
+        return mState->usesIoUring();
+    }
+
+private:
+    class State
+    {
+    public:
+        State(const std::string& path, const FileSinkOptions& options):
+        mOptions(options),
+        mBuffers{detail::AlignedBuffer(options.flushSize), detail::AlignedBuffer(options.flushSize)},
+        mLastFlush(std::chrono::steady_clock::now())
+        {
+            mFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if(mFd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "open " + path);
+            }
+            try
+            {
+                mWriter = makeWriter();
+            }
+            catch(...)
+            {
+                ::close(mFd);
+                throw;
+            }
+        }
+
+        State(const State&) = delete;
+        State& operator=(const State&) = delete;
+
+        ~State()
+        {
+            try
+            {
+                close();
+            }
+            catch(...)
+            {
+                // Nothing left to report the failure to
+            }
+        }
+
+        void close()
+        {
+            if(mFd < 0)
+            {
+                return;
+            }
+            std::exception_ptr failure;
+            try
+            {
+                flush();
+                for(std::size_t slot = 0; slot < detail::bufferSlots; ++slot)
+                {
+                    mWriter->wait(slot);
+                }
+            }
+            catch(...)
+            {
+                failure = std::current_exception();
+            }
+            mWriter.reset();
+            if(mOptions.fsync != FsyncPolicy::Never && ::fsync(mFd) != 0 && !failure)
+            {
+                failure = std::make_exception_ptr(std::system_error(errno, std::generic_category(), "fsync"));
+            }
+            if(::close(mFd) != 0 && !failure)
+            {
+                failure = std::make_exception_ptr(std::system_error(errno, std::generic_category(), "close"));
+            }
+            mFd = -1;
+            if(failure)
+            {
+                std::rethrow_exception(failure);
+            }
+        }
+
+        std::chrono::microseconds flushInterval() const
+        {
+            return mOptions.flushInterval;
+        }
+
+        void append(std::span<const std::byte> bytes)
+        {
+            if(mFd < 0)
+            {
+                throw std::logic_error("FileSink is closed");
+            }
+            rethrowFailure();
+            const std::size_t prefix = mOptions.framed ? sizeof(std::uint32_t) : 0;
+            auto* buffer = &mBuffers[mCurrent];
+            if(buffer->size() + prefix + bytes.size() > buffer->capacity())
+            {
+                flush();
+                buffer = &mBuffers[mCurrent];
+                buffer->reserve(prefix + bytes.size());
+            }
+            if(mOptions.framed && bytes.size() > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::length_error("A framed record has to be shorter than 4 GiB");
+            }
+            if(mOptions.framed)
+            {
+                const auto length = static_cast<std::uint32_t>(bytes.size());
+                const std::array<std::byte, sizeof(std::uint32_t)> le{
+                    std::byte(length & 0xff), std::byte((length >> 8) & 0xff),
+                    std::byte((length >> 16) & 0xff), std::byte((length >> 24) & 0xff)};
+                buffer->append(le);
+            }
+            buffer->append(bytes);
+            if(buffer->size() >= mOptions.flushSize || std::chrono::steady_clock::now() - mLastFlush >= mOptions.flushInterval)
+            {
+                flush();
+            }
+        }
+
+        void flush()
+        {
+            rethrowFailure();
+            mLastFlush = std::chrono::steady_clock::now();
+            auto& buffer = mBuffers[mCurrent];
+            if(buffer.empty() || mFd < 0)
+            {
+                return;
+            }
+            try
+            {
+                mWriter->submit(mCurrent, buffer.bytes(), mOffset, mOptions.fsync == FsyncPolicy::OnFlush);
+                mOffset += buffer.size();
+                mCurrent = (mCurrent + 1) % detail::bufferSlots;
+                // The next buffer may still be on its way to disk
+                mWriter->wait(mCurrent);
+            }
+            catch(...)
+            {
+                // The file has a hole now; writing on would only hide it
+                mFailure = std::current_exception();
+                mBuffers[mCurrent].clear();
+                throw;
+            }
+            mBuffers[mCurrent].clear();
+        }
+
+        bool usesIoUring() const
+        {
+            return dynamic_cast<const detail::IoUringWriter*>(mWriter.get()) != nullptr;
+        }
+
+    private:
+        // A failed write fails every later append, flush and close
+        void rethrowFailure() const
+        {
+            if(mFailure)
+            {
+                std::rethrow_exception(mFailure);
+            }
+        }
+
+        std::unique_ptr<detail::AsyncWriter> makeWriter() const
+        {
+            switch(mOptions.backend)
+            {
+            case WriteBackend::IoUring:
+                return std::make_unique<detail::IoUringWriter>(mFd);
+            case WriteBackend::Thread:
+                return std::make_unique<detail::ThreadWriter>(mFd);
+            case WriteBackend::Auto:
+                break;
+            }
+            try
+            {
+                return std::make_unique<detail::IoUringWriter>(mFd);
+            }
+            catch(const std::system_error&)
+            {
+                return std::make_unique<detail::ThreadWriter>(mFd);
+            }
+        }
+
+        FileSinkOptions mOptions;
+        int mFd = -1;
+        std::array<detail::AlignedBuffer, detail::bufferSlots> mBuffers;
+        std::size_t mCurrent = 0;
+        std::uint64_t mOffset = 0;
+        std::chrono::steady_clock::time_point mLastFlush;
+        std::unique_ptr<detail::AsyncWriter> mWriter;
+        std::exception_ptr mFailure;
+    };
+
+    std::shared_ptr<State> mState;
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace hbreukers::detail
+{
+
+// Words in memory shared between processes need the shared variant; the
+// private one skips the lookup of the backing mapping
+enum class FutexScope
+{
+    Private,
+    Shared
+};
+
+inline int futexOperation(int operation, FutexScope scope)
+{
+    return scope == FutexScope::Private ? operation | FUTEX_PRIVATE_FLAG : operation;
+}
+
+// Sleeps while word still holds expected, until woken or the timeout passes.
+// Spurious wake ups happen, callers re-check their condition.
+inline void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected, std::chrono::nanoseconds timeout,
+                      FutexScope scope = FutexScope::Private)
+{
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec time{static_cast<time_t>(seconds.count()), static_cast<long>((timeout - seconds).count())};
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), futexOperation(FUTEX_WAIT, scope), expected, &time, nullptr, 0);
+}
+
+inline void futexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected, FutexScope scope = FutexScope::Private)
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), futexOperation(FUTEX_WAIT, scope), expected, nullptr, nullptr, 0);
+}
+
+inline void futexWake(std::atomic<std::uint32_t>& word, FutexScope scope = FutexScope::Private)
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), futexOperation(FUTEX_WAKE, scope), INT_MAX, nullptr, nullptr, 0);
+}
+
+}
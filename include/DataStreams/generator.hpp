@@ -0,0 +1,130 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace hbreukers
+{
+
+template<typename T>
+class Generator;
+
+namespace detail
+{
+
+template<typename T>
+class GeneratorPromise
+{
+public:
+    Generator<T> get_return_object();
+
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    std::suspend_always final_suspend() noexcept
+    {
+        return {};
+    }
+
+    template<typename U>
+    std::suspend_always yield_value(U&& value)
+    {
+        mValue.emplace(std::forward<U>(value));
+        return {};
+    }
+
+    void return_void()
+    {}
+
+    void unhandled_exception()
+    {
+        mError = std::current_exception();
+    }
+
+    // Resumes up to the next co_yield
+    std::optional<T> next(std::coroutine_handle<GeneratorPromise> handle)
+    {
+        mValue.reset();
+        handle.resume();
+        if(mError)
+        {
+            std::rethrow_exception(std::exchange(mError, {}));
+        }
+        return std::move(mValue);
+    }
+
+private:
+    std::optional<T> mValue;
+    std::exception_ptr mError;
+};
+
+}
+
+// Source written as a coroutine that co_yields its records. The body only runs
+// when the manager asks for the next record, so it is suspended (not spinning
+// or sleeping) while downstream has no room. Copies share the coroutine.
+template<typename T>
+class Generator
+{
+public:
+    using promise_type = detail::GeneratorPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Generator(Handle handle):
+    mFrame(std::make_shared<Frame>(handle))
+    {}
+
+    // The next record; empty once the body returned
+    std::optional<T> operator()()
+    {
+        auto handle = mFrame->mHandle;
+        if(handle.done())
+        {
+            return std::nullopt;
+        }
+        return handle.promise().next(handle);
+    }
+
+    bool exhausted() const
+    {
+        return mFrame->mHandle.done();
+    }
+
+private:
+    struct Frame
+    {
+        explicit Frame(Handle handle):
+        mHandle(handle)
+        {}
+
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        ~Frame()
+        {
+            mHandle.destroy();
+        }
+
+        Handle mHandle;
+    };
+
+    std::shared_ptr<Frame> mFrame;
+};
+
+namespace detail
+{
+
+template<typename T>
+Generator<T> GeneratorPromise<T>::get_return_object()
+{
+    return Generator<T>{std::coroutine_handle<GeneratorPromise<T>>::from_promise(*this)};
+}
+
+}
+
+}
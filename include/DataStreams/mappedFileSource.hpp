@@ -0,0 +1,222 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataStream.hpp"
+
+namespace hbreukers
+{
+
+struct MapOptions
+{
+    // madvise(MADV_SEQUENTIAL): aggressive read-ahead, pages dropped behind
+    bool sequential = true;
+    // madvise(MADV_HUGEPAGE): transparent huge pages where the file system supports them
+    bool hugePages = false;
+    // MAP_POPULATE: fault the whole file in up front
+    bool populate = false;
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string& path, const MapOptions& options = {})
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "open " + path);
+        }
+        struct stat info{};
+        if(::fstat(fd, &info) != 0)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "fstat " + path);
+        }
+        mSize = static_cast<std::size_t>(info.st_size);
+        if(mSize > 0)
+        {
+            const int flags = MAP_PRIVATE | (options.populate ? MAP_POPULATE : 0);
+            void* data = ::mmap(nullptr, mSize, PROT_READ, flags, fd, 0);
+            if(data == MAP_FAILED)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "mmap " + path);
+            }
+            mData = static_cast<const std::byte*>(data);
+            // Advice is best effort, an unsupported hint is not an error
+            if(options.sequential)
+            {
+                ::madvise(data, mSize, MADV_SEQUENTIAL);
+            }
+            if(options.hugePages)
+            {
+                ::madvise(data, mSize, MADV_HUGEPAGE);
+            }
+        }
+        ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+        if(mData)
+        {
+            ::munmap(const_cast<std::byte*>(mData), mSize);
+        }
+    }
+
+    std::span<const std::byte> bytes() const
+    {
+        return {mData, mSize};
+    }
+
+private:
+    const std::byte* mData = nullptr;
+    std::size_t mSize = 0;
+};
+
+// Emits batches of up to batchSize fixed-size records as views into the mapping.
+// Copies share the mapping but keep their own read position.
+template<typename Record>
+class MappedRecordSource
+{
+    static_assert(std::is_trivially_copyable_v<Record>, "Mapped records must be trivially copyable");
+
+public:
+    MappedRecordSource(const std::string& path, std::size_t batchSize = 1, const MapOptions& options = {}):
+    mFile(std::make_shared<const MappedFile>(path, options)),
+    mBatchSize(batchSize)
+    {
+        if(batchSize == 0)
+        {
+            throw std::invalid_argument("MappedRecordSource needs a batch size of at least 1");
+        }
+        // Mappings are page aligned, so any record type is suitably aligned
+        const auto bytes = mFile->bytes();
+        mRecords = std::span<const Record>(reinterpret_cast<const Record*>(bytes.data()), bytes.size() / sizeof(Record));
+    }
+
+    std::optional<std::span<const Record>> operator()()
+    {
+        if(exhausted())
+        {
+            return std::nullopt;
+        }
+        const auto count = std::min(mBatchSize, mRecords.size() - mPosition);
+        const auto batch = mRecords.subspan(mPosition, count);
+        mPosition += count;
+        return batch;
+    }
+
+    bool exhausted() const
+    {
+        return mPosition == mRecords.size();
+    }
+
+    // Index of the next record to emit
+    std::size_t position() const
+    {
+        return mPosition;
+    }
+
+    void seek(std::size_t position)
+    {
+        mPosition = std::min(position, mRecords.size());
+    }
+
+private:
+    std::shared_ptr<const MappedFile> mFile;
+    std::span<const Record> mRecords;
+    std::size_t mBatchSize;
+    std::size_t mPosition = 0;
+};
+
+// Emits the payload of each frame as a view into the mapping. Frames are a
+// little-endian uint32_t length followed by that many bytes; a truncated
+// trailing frame is ignored.
+class MappedFrameSource
+{
+public:
+    explicit MappedFrameSource(const std::string& path, const MapOptions& options = {}):
+    mFile(std::make_shared<const MappedFile>(path, options))
+    {}
+
+    std::optional<std::span<const std::byte>> operator()()
+    {
+        if(exhausted())
+        {
+            return std::nullopt;
+        }
+        const auto bytes = mFile->bytes();
+        const auto length = frameLength(bytes);
+        const auto frame = bytes.subspan(mPosition + sizeof(std::uint32_t), length);
+        mPosition += sizeof(std::uint32_t) + length;
+        return frame;
+    }
+
+    bool exhausted() const
+    {
+        const auto bytes = mFile->bytes();
+        return bytes.size() - mPosition < sizeof(std::uint32_t)
+            || bytes.size() - mPosition - sizeof(std::uint32_t) < frameLength(bytes);
+    }
+
+    // Byte offset of the next frame
+    std::size_t position() const
+    {
+        return mPosition;
+    }
+
+    void seek(std::size_t position)
+    {
+        mPosition = std::min(position, mFile->bytes().size());
+    }
+
+private:
+    std::size_t frameLength(std::span<const std::byte> bytes) const
+    {
+        unsigned char prefix[sizeof(std::uint32_t)];
+        std::memcpy(prefix, bytes.data() + mPosition, sizeof(prefix));
+        return static_cast<std::size_t>(prefix[0])
+            | static_cast<std::size_t>(prefix[1]) << 8
+            | static_cast<std::size_t>(prefix[2]) << 16
+            | static_cast<std::size_t>(prefix[3]) << 24;
+    }
+
+    std::shared_ptr<const MappedFile> mFile;
+    std::size_t mPosition = 0;
+};
+
+template<typename Record>
+auto makeMappedRecordSource(const std::string& path, std::size_t batchSize = 1, const MapOptions& options = {})
+{
+    return makeSource(MappedRecordSource<Record>(path, batchSize, options));
+}
+
+inline auto makeMappedFrameSource(const std::string& path, const MapOptions& options = {})
+{
+    return makeSource(MappedFrameSource(path, options));
+}
+
+}
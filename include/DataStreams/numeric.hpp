@@ -0,0 +1,295 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#if __has_include(<experimental/simd>) && !defined(HBREUKERS_NO_SIMD)
+#include <experimental/simd>
+#define HBREUKERS_HAS_SIMD 1
+#endif
+
+// Built-in numeric operators working on contiguous batches of values, e.g.
+//   source.addDataStream<std::span<const float>>().process(numeric::mapAffine(2.f, 1.f))
+// Batch results are views into a buffer owned by the operator, valid until its
+// next invocation, so no allocation happens once the buffer has grown.
+// Kernels use std::experimental::simd (native width, so build with -march to
+// get AVX2/AVX-512) and fall back to scalar loops with HBREUKERS_NO_SIMD.
+namespace hbreukers::numeric
+{
+
+template<typename T>
+concept Arithmetic = std::is_arithmetic_v<T>;
+
+namespace kernel
+{
+
+#ifdef HBREUKERS_HAS_SIMD
+namespace stdx = std::experimental;
+
+template<typename T>
+using Vec = stdx::native_simd<T>;
+#endif
+
+// out[i] = a * in[i] + b
+template<Arithmetic T>
+void affine(const T* in, T* out, std::size_t n, T a, T b)
+{
+    std::size_t i = 0;
+#ifdef HBREUKERS_HAS_SIMD
+    constexpr std::size_t width = Vec<T>::size();
+    const Vec<T> va = a;
+    const Vec<T> vb = b;
+    for(; i + width <= n; i += width)
+    {
+        Vec<T> v(in + i, stdx::element_aligned);
+        v = v * va + vb;
+        v.copy_to(out + i, stdx::element_aligned);
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        out[i] = static_cast<T>(a * in[i] + b);
+    }
+}
+
+// Copies the values within [lo, hi] to out, returns the number copied
+template<Arithmetic T>
+std::size_t filterRange(const T* in, T* out, std::size_t n, T lo, T hi)
+{
+    std::size_t i = 0;
+    std::size_t count = 0;
+#ifdef HBREUKERS_HAS_SIMD
+    constexpr std::size_t width = Vec<T>::size();
+    const Vec<T> vlo = lo;
+    const Vec<T> vhi = hi;
+    for(; i + width <= n; i += width)
+    {
+        Vec<T> v(in + i, stdx::element_aligned);
+        const auto mask = (v >= vlo) && (v <= vhi);
+        if(stdx::all_of(mask))
+        {
+            v.copy_to(out + count, stdx::element_aligned);
+            count += width;
+        }
+        else if(stdx::any_of(mask))
+        {
+            for(std::size_t j = 0; j < width; ++j)
+            {
+                out[count] = in[i + j];
+                count += static_cast<std::size_t>(static_cast<bool>(mask[j]));
+            }
+        }
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        out[count] = in[i];
+        count += static_cast<std::size_t>(in[i] >= lo && in[i] <= hi);
+    }
+    return count;
+}
+
+template<Arithmetic T>
+T sum(const T* in, std::size_t n)
+{
+    std::size_t i = 0;
+    T result{};
+#ifdef HBREUKERS_HAS_SIMD
+    constexpr std::size_t width = Vec<T>::size();
+    Vec<T> acc = T{};
+    for(; i + width <= n; i += width)
+    {
+        acc += Vec<T>(in + i, stdx::element_aligned);
+    }
+    result = stdx::reduce(acc);
+#endif
+    for(; i < n; ++i)
+    {
+        result = static_cast<T>(result + in[i]);
+    }
+    return result;
+}
+
+// Smallest of the n values; infinity (or the largest T) when n is 0
+template<Arithmetic T>
+T min(const T* in, std::size_t n)
+{
+    std::size_t i = 0;
+    T result = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+#ifdef HBREUKERS_HAS_SIMD
+    constexpr std::size_t width = Vec<T>::size();
+    if(n >= width)
+    {
+        Vec<T> acc(in, stdx::element_aligned);
+        for(i = width; i + width <= n; i += width)
+        {
+            acc = stdx::min(acc, Vec<T>(in + i, stdx::element_aligned));
+        }
+        result = stdx::hmin(acc);
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        result = std::min(result, in[i]);
+    }
+    return result;
+}
+
+// Largest of the n values; minus infinity (or the lowest T) when n is 0
+template<Arithmetic T>
+T max(const T* in, std::size_t n)
+{
+    std::size_t i = 0;
+    T result = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+#ifdef HBREUKERS_HAS_SIMD
+    constexpr std::size_t width = Vec<T>::size();
+    if(n >= width)
+    {
+        Vec<T> acc(in, stdx::element_aligned);
+        for(i = width; i + width <= n; i += width)
+        {
+            acc = stdx::max(acc, Vec<T>(in + i, stdx::element_aligned));
+        }
+        result = stdx::hmax(acc);
+    }
+#endif
+    for(; i < n; ++i)
+    {
+        result = std::max(result, in[i]);
+    }
+    return result;
+}
+
+// Inclusive prefix sum. The loop carried dependency keeps this scalar; it is
+// still a single streaming pass over the batch.
+template<Arithmetic T>
+void inclusiveScan(const T* in, T* out, std::size_t n)
+{
+    T acc{};
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        acc = static_cast<T>(acc + in[i]);
+        out[i] = acc;
+    }
+}
+
+}
+
+// Operators plugging the kernels into DataStream::process
+
+template<Arithmetic T>
+class MapAffine
+{
+public:
+    MapAffine(T a, T b):
+    mA(a),
+    mB(b)
+    {}
+
+    std::span<const T> operator()(std::span<const T> in)
+    {
+        mOut.resize(in.size());
+        kernel::affine(in.data(), mOut.data(), in.size(), mA, mB);
+        return mOut;
+    }
+
+private:
+    T mA;
+    T mB;
+    std::vector<T> mOut;
+};
+
+template<Arithmetic T>
+class FilterRange
+{
+public:
+    FilterRange(T lo, T hi):
+    mLo(lo),
+    mHi(hi)
+    {}
+
+    std::span<const T> operator()(std::span<const T> in)
+    {
+        mOut.resize(in.size());
+        const auto count = kernel::filterRange(in.data(), mOut.data(), in.size(), mLo, mHi);
+        return std::span<const T>(mOut.data(), count);
+    }
+
+private:
+    T mLo;
+    T mHi;
+    std::vector<T> mOut;
+};
+
+template<Arithmetic T>
+class PrefixScan
+{
+public:
+    std::span<const T> operator()(std::span<const T> in)
+    {
+        mOut.resize(in.size());
+        kernel::inclusiveScan(in.data(), mOut.data(), in.size());
+        return mOut;
+    }
+
+private:
+    std::vector<T> mOut;
+};
+
+template<Arithmetic T>
+auto mapAffine(T a, T b)
+{
+    return MapAffine<T>(a, b);
+}
+
+template<Arithmetic T>
+auto filterRange(T lo, T hi)
+{
+    return FilterRange<T>(lo, hi);
+}
+
+template<Arithmetic T>
+auto prefixScan()
+{
+    return PrefixScan<T>{};
+}
+
+template<Arithmetic T>
+auto reduceSum()
+{
+    return [](std::span<const T> in){ return kernel::sum(in.data(), in.size()); };
+}
+
+// An empty batch has no minimum or maximum, so these yield std::nullopt for it
+// rather than the seed of the kernel
+template<Arithmetic T>
+auto reduceMin()
+{
+    return [](std::span<const T> in) -> std::optional<T>
+    {
+        if(in.empty())
+        {
+            return std::nullopt;
+        }
+        return kernel::min(in.data(), in.size());
+    };
+}
+
+template<Arithmetic T>
+auto reduceMax()
+{
+    return [](std::span<const T> in) -> std::optional<T>
+    {
+        if(in.empty())
+        {
+            return std::nullopt;
+        }
+        return kernel::max(in.data(), in.size());
+    };
+}
+
+}
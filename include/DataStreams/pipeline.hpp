@@ -0,0 +1,277 @@
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "../CompileTimeGraph/ctgl.hpp"
+#include "dataStreamManager.hpp"
+#include "shuffle.hpp"
+#include "threadedDataStreamManager.hpp"
+
+namespace hbreukers
+{
+
+namespace detail
+{
+
+template<typename Stream>
+inline constexpr bool isReplicated = false;
+
+template<std::size_t Replicas, typename Stream>
+inline constexpr bool isReplicated<Replicated<Replicas, Stream>> = true;
+
+// The stream itself, or the stream a Replicated copies
+template<typename Stream>
+struct Base
+{
+    using type = Stream;
+};
+
+template<std::size_t Replicas, typename Stream>
+struct Base<Replicated<Replicas, Stream>>
+{
+    using type = Stream;
+};
+
+template<typename Stream>
+using BaseOf = typename Base<Stream>::type;
+
+template<typename Stream, typename... Streams>
+inline constexpr std::size_t occurrences = (std::size_t{0} + ... + std::is_same_v<Stream, Streams>);
+
+template<typename Stream, typename Added>
+inline constexpr std::size_t copiesIn = 0;
+
+template<typename Stream, std::size_t Replicas>
+inline constexpr std::size_t copiesIn<Stream, Replicated<Replicas, Stream>> = Replicas;
+
+// Copies made of Stream, 0 unless it was added through replicated()
+template<typename Stream, typename... Streams>
+inline constexpr std::size_t replicaCount = (std::size_t{0} + ... + copiesIn<Stream, Streams>);
+
+template<typename T, std::size_t>
+using Repeat = T;
+
+template<typename Stream, std::size_t... I>
+constexpr auto replicaNodes(std::index_sequence<I...>)
+{
+    return ctgl::List<ReplicaNode<Stream, I>...>{};
+}
+
+// The Nodes standing for Stream, the stream added to the pipeline as is
+template<typename Stream, std::size_t Replicas>
+constexpr auto nodesFor()
+{
+    if constexpr(Replicas == 0)
+    {
+        return ctgl::List<ctgl::Node<Stream>>{};
+    }
+    else
+    {
+        return replicaNodes<Stream>(std::make_index_sequence<Replicas>{});
+    }
+}
+
+template<typename Stream>
+constexpr auto nodesOf()
+{
+    if constexpr(isReplicated<Stream>)
+    {
+        return nodesFor<BaseOf<Stream>, Stream::count>();
+    }
+    else
+    {
+        return nodesFor<Stream, 0>();
+    }
+}
+
+template<typename Tail, typename... Heads>
+constexpr auto fanOut(ctgl::List<Tail>, ctgl::List<Heads...>)
+{
+    return ctgl::List<ctgl::Edge<Tail, Heads, 1>...>{};
+}
+
+template<typename... Tails, typename Head>
+constexpr auto fanIn(ctgl::List<Tails...>, ctgl::List<Head>)
+{
+    return ctgl::List<ctgl::Edge<Tails, Head, 1>...>{};
+}
+
+// A single stream fans out to replicas and replicas fan in to a single
+// stream; chained replicated streams connect replica to replica
+template<typename... Tails, typename... Heads>
+constexpr auto connectNodes(ctgl::List<Tails...> tails, ctgl::List<Heads...> heads)
+{
+    if constexpr(sizeof...(Tails) == sizeof...(Heads))
+    {
+        return ctgl::List<ctgl::Edge<Tails, Heads, 1>...>{};
+    }
+    else if constexpr(sizeof...(Tails) == 1)
+    {
+        return fanOut(tails, heads);
+    }
+    else
+    {
+        static_assert(sizeof...(Heads) == 1, "Chained replicated streams need the same number of replicas");
+        return fanIn(tails, heads);
+    }
+}
+
+// Branches a router spreads over, 0 where its selector does not tell
+template<typename Stream>
+inline constexpr std::size_t routerBranches = 0;
+
+template<typename T, typename Selector, typename MixinBase>
+    requires requires { Selector::branches; }
+inline constexpr std::size_t routerBranches<DataStreamRouter<T, Selector, MixinBase>> = Selector::branches;
+
+// The edges from the stream Stream was derived from, none for sources
+template<typename Stream, typename... Streams>
+constexpr auto edgesInto()
+{
+    using Upstream = typename Stream::Upstream;
+    if constexpr(std::is_void_v<Upstream>)
+    {
+        return ctgl::List<>{};
+    }
+    else
+    {
+        // Replicas under any other stream would each get every record
+        if constexpr(isReplicated<Stream> && replicaCount<Upstream, Streams...> == 0)
+        {
+            static_assert(routerBranches<Upstream> > 0,
+                          "replicated<N> has to follow a partitionBy<N> router or another replicated<N> stream");
+        }
+        if constexpr(isReplicated<Stream> && routerBranches<Upstream> > 0)
+        {
+            static_assert(routerBranches<Upstream> == Stream::count,
+                          "partitionBy<N> has to spread over as many branches as replicated<N> makes replicas");
+        }
+        return connectNodes(nodesFor<Upstream, replicaCount<Upstream, Streams...>>(), nodesOf<Stream>());
+    }
+}
+
+template<typename... Streams>
+constexpr auto edgesOf()
+{
+    using ctgl::list::operator+;
+    return (ctgl::List<>{} + ... + edgesInto<Streams, Streams...>());
+}
+
+template<typename... Streams>
+constexpr auto nodeListOf()
+{
+    using ctgl::list::operator+;
+    return (ctgl::List<>{} + ... + nodesOf<Streams>());
+}
+
+template<typename Stream, typename... Streams>
+constexpr bool hasUpstreamIn()
+{
+    using Upstream = typename Stream::Upstream;
+    if constexpr(std::is_void_v<Upstream>)
+    {
+        return true;
+    }
+    else
+    {
+        return occurrences<Upstream, Streams...> > 0 || replicaCount<Upstream, Streams...> > 0;
+    }
+}
+
+// The components of Stream, one per replica
+template<typename Stream>
+auto componentsOf(Stream& stream)
+{
+    if constexpr(isReplicated<Stream>)
+    {
+        return [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            return std::tuple<Repeat<typename Stream::StreamType, I>...>{(void(I), stream.mStream)...};
+        }(std::make_index_sequence<Stream::count>{});
+    }
+    else
+    {
+        return std::tuple<Stream>{std::move(stream)};
+    }
+}
+
+}
+
+// Program graph of the given streams, read from the Upstream each stream was
+// derived from (addDataStream, addDataSink, process, filter, flatMap). A
+// Replicated stream stands for a Node per replica, see shuffle.hpp.
+template<typename... Streams>
+using ProgramOf = ctgl::Graph<decltype(detail::nodeListOf<Streams...>()), decltype(detail::edgesOf<Streams...>())>;
+
+// Collects the streams of a pipeline and builds a manager for them, deriving
+// the program graph instead of having it restated by hand. A stream whose
+// upstream was not added fails to compile rather than being left out. Streams
+// are told apart by type, so graphs where one type appears at several places,
+// or a stream has more than one input, still need an explicit ctgl::Graph;
+// the exception are the replicas of a replicated() stream and the streams
+// gathering from them.
+template<typename... Streams>
+class PipelineBuilder
+{
+    static_assert(((detail::occurrences<detail::BaseOf<Streams>, detail::BaseOf<Streams>...> == 1) && ...),
+                  "A stream was added twice, or two streams share a type; build this graph explicitly");
+
+    // Checked once complete, so streams may be added in any order
+    static constexpr bool complete = (detail::hasUpstreamIn<Streams, Streams...>() && ...);
+
+public:
+    using Program = ProgramOf<Streams...>;
+
+    explicit PipelineBuilder(Streams... streams):
+    mStreams(std::move(streams)...)
+    {}
+
+    template<typename... More>
+    auto add(More&&... more) &&
+    {
+        return std::apply([&](auto&... streams)
+        {
+            return PipelineBuilder<Streams..., std::decay_t<More>...>{std::move(streams)..., std::forward<More>(more)...};
+        }, mStreams);
+    }
+
+    auto build() &&
+    {
+        static_assert(complete, "The upstream of a stream was not added to the pipeline");
+        return std::apply([](auto&&... components)
+        {
+            return constructDataStreamManager(Program{}, std::move(components)...);
+        }, components());
+    }
+
+    template<typename Waits = WaitStrategies<wait::SpinThenPark<>>>
+    auto buildThreaded(const ExecutorOptions& options = {}) &&
+    {
+        static_assert(complete, "The upstream of a stream was not added to the pipeline");
+        return std::apply([&](auto&&... components)
+        {
+            return constructThreadedDataStreamManager<Waits>(Program{}, options, std::move(components)...);
+        }, components());
+    }
+
+private:
+    // In the order of Program::Nodes
+    auto components()
+    {
+        return std::apply([](auto&... streams)
+        {
+            return std::tuple_cat(detail::componentsOf(streams)...);
+        }, mStreams);
+    }
+
+    std::tuple<Streams...> mStreams;
+};
+
+template<typename... Streams>
+auto pipeline(Streams&&... streams)
+{
+    return PipelineBuilder<std::decay_t<Streams>...>{std::forward<Streams>(streams)...};
+}
+
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <memory_resource>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace hbreukers
+{
+
+// Where the thread of one stage runs
+struct StagePlacement
+{
+    // CPUs the thread is pinned to; empty pins it to all CPUs of numaNode, or
+    // leaves placement to the OS when there is no numaNode either
+    std::vector<int> cpus;
+    // Node the stage's queues and allocations are placed on, -1 for no preference
+    int numaNode = -1;
+    // Thread name as shown by top and perf, cut to 15 characters; empty names
+    // the thread after the position of its node in the graph
+    std::string name;
+};
+
+// Placement is best effort: a request the kernel refuses (no NUMA support,
+// mempolicy calls denied in a container, CPUs outside the allowed set) leaves
+// the stage where the OS puts it and is reported as one of these
+struct PlacementFailure
+{
+    // Thread name of the stage, or "node N" for the queues placed on node N
+    std::string stage;
+    std::string what;
+    std::error_code error;
+};
+
+// Placement of stages, keyed by their ctgl::Node
+class Placement
+{
+public:
+    template<typename Node>
+    Placement& place(StagePlacement placement)
+    {
+        mStages[std::type_index(typeid(Node))] = std::move(placement);
+        return *this;
+    }
+
+    template<typename Node>
+    const StagePlacement& of() const
+    {
+        static const StagePlacement unplaced;
+        const auto found = mStages.find(std::type_index(typeid(Node)));
+        return found == mStages.end() ? unplaced : found->second;
+    }
+
+private:
+    std::unordered_map<std::type_index, StagePlacement> mStages;
+};
+
+namespace detail
+{
+
+// Parses a sysfs CPU list such as "0-3,8,10-11"
+inline std::vector<int> parseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::istringstream ranges(list);
+    std::string range;
+    while(std::getline(ranges, range, ','))
+    {
+        if(range.empty() || range == "\n")
+        {
+            continue;
+        }
+        const auto dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for(int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+}
+
+inline std::vector<int> numaNodeCpus(int node)
+{
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if(!file)
+    {
+        throw std::system_error(ENOENT, std::generic_category(), "NUMA node " + std::to_string(node));
+    }
+    std::string list;
+    std::getline(file, list);
+    return detail::parseCpuList(list);
+}
+
+namespace detail
+{
+
+inline constexpr std::size_t maskBits = sizeof(unsigned long) * 8;
+
+// Node mask for the mempolicy calls, as many words long as node needs
+inline std::vector<unsigned long> nodeMask(int node)
+{
+    const auto bit = static_cast<std::size_t>(node);
+    std::vector<unsigned long> mask(bit / maskBits + 1);
+    mask[bit / maskBits] = 1ul << (bit % maskBits);
+    return mask;
+}
+
+// The kernel reads one bit less than maxnode says, as libnuma accounts for too
+inline unsigned long maxNode(const std::vector<unsigned long>& mask)
+{
+    return static_cast<unsigned long>(mask.size() * maskBits + 1);
+}
+
+inline void bindMemory(void* address, std::size_t length, int node)
+{
+    const auto mask = nodeMask(node);
+    if(::syscall(SYS_mbind, address, length, MPOL_PREFERRED, mask.data(), maxNode(mask), 0) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "mbind");
+    }
+}
+
+// Later allocations of the calling thread prefer node; pages it already
+// touched stay where they are
+inline void preferNumaNode(int node)
+{
+    const auto mask = nodeMask(node);
+    if(::syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), maxNode(mask)) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "set_mempolicy");
+    }
+}
+
+inline void pinCurrentThread(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(const int cpu : cpus)
+    {
+        CPU_SET(static_cast<std::size_t>(cpu), &set);
+    }
+    if(const int error = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set))
+    {
+        throw std::system_error(error, std::generic_category(), "pthread_setaffinity_np");
+    }
+}
+
+inline void nameCurrentThread(const std::string& name)
+{
+    // The kernel keeps 15 characters and the terminator
+    ::pthread_setname_np(::pthread_self(), name.substr(0, 15).c_str());
+}
+
+// Applies placement to the calling thread, returning what could not be applied
+inline std::vector<PlacementFailure> placeCurrentThread(const StagePlacement& placement, const std::string& fallbackName)
+{
+    const auto& name = placement.name.empty() ? fallbackName : placement.name;
+    nameCurrentThread(name);
+    std::vector<PlacementFailure> failures;
+    const auto attempt = [&](auto&& apply)
+    {
+        try
+        {
+            apply();
+        }
+        catch(const std::system_error& error)
+        {
+            failures.push_back({name.substr(0, 15), error.what(), error.code()});
+        }
+    };
+    if(!placement.cpus.empty())
+    {
+        attempt([&]{ pinCurrentThread(placement.cpus); });
+    }
+    else if(placement.numaNode >= 0)
+    {
+        attempt([&]{ pinCurrentThread(numaNodeCpus(placement.numaNode)); });
+    }
+    if(placement.numaNode >= 0)
+    {
+        attempt([&]{ preferNumaNode(placement.numaNode); });
+    }
+    return failures;
+}
+
+}
+
+// Whole pages mapped for each allocation and bound to one NUMA node, for
+// memory set up by one thread but used by a stage running on that node. When
+// the kernel refuses the binding the pages are handed out unbound and
+// bindError() tells why.
+class NumaResource : public std::pmr::memory_resource
+{
+public:
+    explicit NumaResource(int node):
+    mNode(node)
+    {}
+
+    int node() const
+    {
+        return mNode;
+    }
+
+    // The first failure to bind an allocation, if any
+    const std::optional<std::system_error>& bindError() const
+    {
+        return mBindError;
+    }
+
+private:
+    static std::size_t mappedLength(std::size_t bytes)
+    {
+        const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t) override
+    {
+        const auto length = mappedLength(bytes);
+        void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(address == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap");
+        }
+        try
+        {
+            detail::bindMemory(address, length, mNode);
+        }
+        catch(const std::system_error& error)
+        {
+            if(!mBindError)
+            {
+                mBindError = error;
+            }
+        }
+        return address;
+    }
+
+    void do_deallocate(void* address, std::size_t bytes, std::size_t) override
+    {
+        ::munmap(address, mappedLength(bytes));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    int mNode;
+    std::optional<std::system_error> mBindError;
+};
+
+}
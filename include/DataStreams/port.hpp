@@ -0,0 +1,195 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace hbreukers
+{
+
+namespace detail
+{
+
+// Subscribers of a port, each in a slot of its own. The publishing thread
+// reads the slots without locking; a slot is only freed once no publish can
+// still be reading it.
+template<typename T, std::size_t Slots>
+class PortState
+{
+public:
+    using Subscriber = std::function<void(const T&)>;
+
+    PortState() = default;
+
+    PortState(const PortState&) = delete;
+    PortState& operator=(const PortState&) = delete;
+
+    ~PortState()
+    {
+        for(auto& slot : mSlots)
+        {
+            delete slot.load(std::memory_order_relaxed);
+        }
+    }
+
+    void publish(const T& value)
+    {
+        // Nothing attached: a single load and the record passes on
+        if(mAttached.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        const auto sequence = mSequence.load(std::memory_order_relaxed);
+        // Odd while publishing; ordered before reading the slots, see detach()
+        mSequence.store(sequence + 1, std::memory_order_seq_cst);
+        for(auto& slot : mSlots)
+        {
+            if(auto* subscriber = slot.load(std::memory_order_seq_cst))
+            {
+                (*subscriber)(value);
+            }
+        }
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    std::size_t attach(Subscriber subscriber)
+    {
+        auto owned = std::make_unique<Subscriber>(std::move(subscriber));
+        for(std::size_t i = 0; i < Slots; ++i)
+        {
+            Subscriber* expected = nullptr;
+            if(mSlots[i].compare_exchange_strong(expected, owned.get(), std::memory_order_seq_cst))
+            {
+                owned.release();
+                mAttached.fetch_add(1, std::memory_order_relaxed);
+                return i;
+            }
+        }
+        throw std::length_error("Every subscriber slot of the port is taken");
+    }
+
+    // Empties the slot, then waits for a publish that may have read it before
+    // freeing the subscriber. Not to be called from a subscriber of this port.
+    void detach(std::size_t slot)
+    {
+        auto* subscriber = mSlots[slot].exchange(nullptr, std::memory_order_seq_cst);
+        mAttached.fetch_sub(1, std::memory_order_relaxed);
+        const auto sequence = mSequence.load(std::memory_order_seq_cst);
+        if(sequence % 2 == 1)
+        {
+            while(mSequence.load(std::memory_order_acquire) == sequence)
+            {
+                std::this_thread::yield();
+            }
+        }
+        delete subscriber;
+    }
+
+    std::size_t attached() const
+    {
+        return mAttached.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<Subscriber*>, Slots> mSlots{};
+    std::atomic<std::size_t> mAttached{0};
+    std::atomic<std::uint64_t> mSequence{0};
+};
+
+}
+
+// Detaches its subscriber from the port when destroyed
+template<typename T, std::size_t Slots>
+class Subscription
+{
+public:
+    Subscription() = default;
+
+    Subscription(std::shared_ptr<detail::PortState<T, Slots>> state, std::size_t slot):
+    mState(std::move(state)),
+    mSlot(slot)
+    {}
+
+    Subscription(Subscription&& other) noexcept:
+    mState(std::move(other.mState)),
+    mSlot(other.mSlot)
+    {}
+
+    Subscription& operator=(Subscription&& other) noexcept
+    {
+        if(this != &other)
+        {
+            detach();
+            mState = std::move(other.mState);
+            mSlot = other.mSlot;
+        }
+        return *this;
+    }
+
+    ~Subscription()
+    {
+        detach();
+    }
+
+    void detach()
+    {
+        if(mState)
+        {
+            mState->detach(mSlot);
+            mState.reset();
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return mState != nullptr;
+    }
+
+private:
+    std::shared_ptr<detail::PortState<T, Slots>> mState;
+    std::size_t mSlot = 0;
+};
+
+// Process passing its input on unchanged, which sinks and branches can be
+// attached to while the pipeline runs, say a tap for a debugging session.
+// Subscribers run on the thread of the node, after it received a record and
+// before the rest of the graph does; without any the port costs one relaxed
+// load. Copies share their subscribers, so keep one to attach through after
+// handing the stream to a manager. Publish from a single node only.
+template<typename T, std::size_t Slots = 8>
+class Port
+{
+public:
+    Port():
+    mState(std::make_shared<detail::PortState<T, Slots>>())
+    {}
+
+    const T& operator()(const T& in)
+    {
+        mState->publish(in);
+        return in;
+    }
+
+    // Throws std::length_error once every slot is taken
+    template<typename Func>
+    [[nodiscard]] Subscription<T, Slots> subscribe(Func&& func)
+    {
+        const auto slot = mState->attach(std::function<void(const T&)>(std::forward<Func>(func)));
+        return Subscription<T, Slots>{mState, slot};
+    }
+
+    std::size_t subscribers() const
+    {
+        return mState->attached();
+    }
+
+private:
+    std::shared_ptr<detail::PortState<T, Slots>> mState;
+};
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "../CompileTimeGraph/ctgl.hpp"
+#include "dataStream.hpp"
+#include "task.hpp"
+
+// Compile time checks of a program graph against the stream components it is
+// run with, so that a misconfigured graph fails to compile with a diagnostic
+// naming the problem rather than deep inside the manager.
+namespace hbreukers::detail
+{
+
+template<bool Feedback, typename... Es>
+constexpr auto edgesMarked(ctgl::List<Es...>)
+{
+    using ctgl::list::operator+;
+    return (ctgl::List<>{} + ... + std::conditional_t<Es::feedback == Feedback, ctgl::List<Es>, ctgl::List<>>{});
+}
+
+// Edges marked as ctgl::FeedbackEdge. DataStreamManager queues what their tail
+// emits and hands it to their head in the next round.
+template<typename P>
+using FeedbackEdges = decltype(edgesMarked<true>(typename P::Edges{}));
+
+// P without its feedback edges, which has to be acyclic
+template<typename P>
+using ForwardProgram = ctgl::Graph<typename P::Nodes, decltype(edgesMarked<false>(typename P::Edges{}))>;
+
+// The component type of Node, with Components in the order of P::Nodes
+template<typename P, typename Components, typename Node>
+using StreamOf = std::remove_pointer_t<std::tuple_element_t<
+    static_cast<std::size_t>(ctgl::list::indexOf(Node{}, typename P::Nodes{})), Components>>;
+
+// Output of a node that cannot be worked out, as its own input was rejected
+struct UnknownOutput
+{};
+
+template<typename Stream>
+constexpr bool isSourceStream()
+{
+    return requires(Stream& stream) { stream.update(); }
+        || requires(Stream& stream, std::pmr::memory_resource* resource) { stream.update(resource); };
+}
+
+template<typename Stream, typename In>
+constexpr bool acceptsInput()
+{
+    if constexpr(std::is_same_v<typename Stream::NodeTag, FilterNodeTag>)
+    {
+        return requires(Stream& stream, const In& in) { stream.test(in); };
+    }
+    else if constexpr(std::is_same_v<typename Stream::NodeTag, RouterNodeTag>)
+    {
+        return requires(Stream& stream, const In& in) { stream.select(in); };
+    }
+    else
+    {
+        return requires(Stream& stream, const In& in, std::pmr::memory_resource* resource) { stream.update(in, resource); }
+            || requires(Stream& stream, const In& in) { stream.update(in); };
+    }
+}
+
+// Type of the values Node passes on to its adjacent nodes. A node with several
+// inputs is judged by its first input that is not a feedback edge.
+template<typename P, typename Components, typename Node>
+constexpr auto emittedOf()
+{
+    using Stream = StreamOf<P, Components, Node>;
+    constexpr auto incoming = ctgl::graph::getIncomingEdges(ForwardProgram<P>{}, Node{});
+    if constexpr(ctgl::list::size(incoming) == 0)
+    {
+        if constexpr(isSourceStream<Stream>())
+        {
+            return std::type_identity<OutputType<Stream, void>>{};
+        }
+        else
+        {
+            return std::type_identity<UnknownOutput>{};
+        }
+    }
+    else
+    {
+        using First = typename decltype(ctgl::list::front(incoming))::Tail;
+        using In = typename decltype(emittedOf<P, Components, First>())::type;
+        if constexpr(std::is_same_v<In, UnknownOutput> || !acceptsInput<Stream, In>())
+        {
+            return std::type_identity<UnknownOutput>{};
+        }
+        else
+        {
+            return std::type_identity<OutputType<Stream, In>>{};
+        }
+    }
+}
+
+template<typename P, typename Components, typename Node>
+using EmittedType = typename decltype(emittedOf<P, Components, Node>())::type;
+
+// Instantiated per edge so that the diagnostic names the types involved
+template<typename Tail, typename Head, typename Output, bool Accepted>
+struct EdgeTypeCheck
+{
+    static_assert(Accepted, "A node does not accept the output of its predecessor; "
+                            "see Output, Tail and Head of this EdgeTypeCheck");
+    static constexpr bool value = Accepted;
+};
+
+template<typename Node, bool IsSource>
+struct NodeInputCheck
+{
+    static_assert(IsSource, "A node without incoming edges is not a source, it needs an input; is an Edge "
+                            "into this Node missing, or is a feedback edge its only input?");
+    static constexpr bool value = IsSource;
+};
+
+template<typename P, typename... StreamTypes>
+class ProgramValidation
+{
+    using Nodes = typename P::Nodes;
+    using Edges = typename P::Edges;
+    using Components = std::tuple<StreamTypes...>;
+
+    template<typename... Es>
+    static constexpr bool edgesKnown(ctgl::List<Es...>)
+    {
+        return ((ctgl::list::contains(typename Es::Tail{}, Nodes{}) && ctgl::list::contains(typename Es::Head{}, Nodes{})) && ...);
+    }
+
+    static constexpr bool countMatches = ctgl::list::size(Nodes{}) == sizeof...(StreamTypes);
+    static constexpr bool nodesUnique = ctgl::list::size(ctgl::list::unique(Nodes{})) == ctgl::list::size(Nodes{});
+    static constexpr bool edgesValid = edgesKnown(Edges{});
+    // Cycles are only run when an edge on them is marked as a ctgl::FeedbackEdge
+    static constexpr bool acyclic = !ctgl::graph::hasCycle(ForwardProgram<P>{});
+
+    static_assert(countMatches, "Expected one stream component per Node of the program graph");
+    static_assert(nodesUnique, "A Node is listed more than once in the Nodes of the program graph");
+    static_assert(edgesValid, "An Edge of the program graph starts or ends at a Node missing from its Nodes");
+    static_assert(!edgesValid || acyclic, "The program graph has a cycle, which would recurse forever");
+
+    // Only nodes without inputs are probed as sources: probing a generic
+    // lambda instantiates its body, which need not compile for a resource.
+    // Feedback edges do not count as inputs, as nothing would ever enter a
+    // cycle reached through its feedback edge only.
+    template<typename Node>
+    static constexpr bool inputValid()
+    {
+        if constexpr(ctgl::list::size(ctgl::graph::getIncomingEdges(ForwardProgram<P>{}, Node{})) > 0)
+        {
+            return true;
+        }
+        else
+        {
+            return NodeInputCheck<Node, isSourceStream<StreamOf<P, Components, Node>>()>::value;
+        }
+    }
+
+    template<typename... Ns>
+    static constexpr bool inputsValid(ctgl::List<Ns...>)
+    {
+        return (inputValid<Ns>() && ...);
+    }
+
+    template<typename Edge>
+    static constexpr bool edgeTypeValid()
+    {
+        using Output = EmittedType<P, Components, typename Edge::Tail>;
+        using Head = StreamOf<P, Components, typename Edge::Head>;
+        // A rejected input further up has been reported already
+        constexpr bool accepted = std::is_same_v<Output, UnknownOutput> || acceptsInput<Head, Output>();
+        return EdgeTypeCheck<typename Edge::Tail, typename Edge::Head, Output, accepted>::value;
+    }
+
+    template<typename... Es>
+    static constexpr bool typesValid(ctgl::List<Es...>)
+    {
+        return (edgeTypeValid<Es>() && ...);
+    }
+
+public:
+    static constexpr bool checks()
+    {
+        if constexpr(countMatches && nodesUnique && edgesValid && acyclic)
+        {
+            return inputsValid(Nodes{}) && typesValid(Edges{});
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+template<typename P, typename... StreamTypes>
+inline constexpr bool validProgram = ProgramValidation<P, StreamTypes...>::checks();
+
+}
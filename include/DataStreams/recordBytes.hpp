@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <type_traits>
+
+namespace hbreukers
+{
+
+// The bytes written for a record by the file, socket and shared memory sinks:
+// a trivially copyable value, or the contents of a contiguous range of them
+// (byte spans, strings, vectors, ...)
+template<typename Record>
+std::span<const std::byte> recordBytes(const Record& record)
+{
+    if constexpr(std::ranges::contiguous_range<Record> && std::ranges::sized_range<Record>)
+    {
+        using Value = std::ranges::range_value_t<Record>;
+        static_assert(std::is_trivially_copyable_v<Value>, "Only trivially copyable records can be written as bytes");
+        return std::as_bytes(std::span<const Value>(std::ranges::data(record), std::ranges::size(record)));
+    }
+    else
+    {
+        static_assert(std::is_trivially_copyable_v<Record>, "Only trivially copyable records can be written as bytes");
+        return std::as_bytes(std::span<const Record, 1>(&record, 1));
+    }
+}
+
+}
@@ -0,0 +1,578 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "dataStream.hpp"
+#include "eventArena.hpp"
+#include "programValidation.hpp"
+#include "task.hpp"
+#include "timer.hpp"
+
+namespace hbreukers
+{
+
+// Handle to a node of a RuntimeDataStreamManager, carrying the type of the
+// stream component and of the values it receives (void for sources)
+template<typename Stream, typename In>
+struct RuntimeNode
+{
+    using StreamType = Stream;
+    using Input = In;
+    using Output = detail::OutputType<Stream, In>;
+
+    std::uint32_t mId;
+};
+
+// Runs the same stream components as DataStreamManager, with the topology
+// given at runtime instead of in a ctgl::Graph, for pipelines generated from
+// configuration that grow too large to compile as one type. Every node is
+// instantiated on its own for its input type; the graph is only known as an
+// adjacency array. Before the first step the nodes are put in topological
+// order, each with a function pointer running it and a slot in one buffer
+// holding its output while its successors run. Records visit the graph depth
+// first, as in DataStreamManager, and so do timers and finish().
+class RuntimeDataStreamManager
+{
+    struct Step;
+    using Clock = std::chrono::steady_clock;
+    using Run = void (*)(RuntimeDataStreamManager&, const Step&, const void*);
+    using Poll = bool (*)(RuntimeDataStreamManager&, const Step&);
+    using Fire = void (*)(RuntimeDataStreamManager&, const Step&, Clock::time_point);
+
+    // Layout of a node once the graph is built
+    struct Step
+    {
+        Run mRun;
+        void* mComponent;
+        std::byte* mSlot;
+        std::uint32_t mFirstSuccessor;
+        std::uint32_t mEndSuccessor;
+    };
+
+    struct NodeInfo
+    {
+        std::unique_ptr<void, void (*)(void*)> mComponent;
+        Run mRun;
+        Poll mPoll;
+        bool (*mExhausted)(void*);
+        Fire mFire;
+        Clock::duration mInterval;
+        void (*mFinish)(void*);
+        std::size_t mSlotSize;
+        std::size_t mSlotAlign;
+    };
+
+    struct Source
+    {
+        std::uint32_t mStep;
+        Poll mPoll;
+        bool (*mExhausted)(void*);
+    };
+
+    struct Timed
+    {
+        std::uint32_t mStep;
+        Fire mFire;
+        Clock::duration mInterval;
+    };
+
+public:
+    RuntimeDataStreamManager() = default;
+
+    RuntimeDataStreamManager(const RuntimeDataStreamManager&) = delete;
+    RuntimeDataStreamManager& operator=(const RuntimeDataStreamManager&) = delete;
+
+    template<typename Stream>
+    RuntimeNode<Stream, void> addSource(Stream stream)
+    {
+        static_assert(detail::isSourceStream<Stream>(), "addSource expects a source, use add(stream, from) for other nodes");
+        const auto id = addNode<Stream, void>(std::move(stream));
+        mNodes[id].mPoll = &pollSource<Stream>;
+        mNodes[id].mExhausted = &sourceExhausted<Stream>;
+        return {id};
+    }
+
+    // Adds stream fed by the node from
+    template<typename Stream, typename From>
+    RuntimeNode<Stream, typename From::Output> add(Stream stream, From from)
+    {
+        using In = typename From::Output;
+        static_assert(!std::is_void_v<In>, "A sink has no output to feed another node");
+        static_assert(detail::acceptsInput<Stream, In>(), "The node does not accept the output of the node it is added to");
+        const RuntimeNode<Stream, In> node{addNode<Stream, In>(std::move(stream))};
+        connect(from, node);
+        return node;
+    }
+
+    // Adds an edge, say a second input of a node
+    template<typename Tail, typename Head>
+    void connect(Tail from, Head to)
+    {
+        static_assert(!std::is_void_v<typename Tail::Output>, "A sink has no output to feed another node");
+        static_assert(std::is_same_v<typename Tail::Output, typename Head::Input>,
+                      "The head of an edge must have been added for the output type of its tail");
+        mEdges.emplace_back(from.mId, to.mId);
+        mBuilt = false;
+    }
+
+    template<typename Node>
+    typename Node::StreamType& component(Node node)
+    {
+        return *static_cast<typename Node::StreamType*>(mNodes[node.mId].mComponent.get());
+    }
+
+    // Runs until stop() is called or every source is exhausted, then has the
+    // nodes with a finish() member hand on what they held back
+    void run()
+    {
+        while(!mStopped.load(std::memory_order_relaxed) && !exhausted())
+        {
+            step();
+        }
+        for(const auto id : mOrder)
+        {
+            if(mNodes[id].mFinish)
+            {
+                mNodes[id].mFinish(mNodes[id].mComponent.get());
+            }
+        }
+    }
+
+    // Runs the timers that expired, then polls every source once and pushes
+    // the results through the graph. Returns whether anything happened.
+    bool step()
+    {
+        if(!mBuilt)
+        {
+            build();
+        }
+        bool produced = !mTimed.empty() && fireTimers(Clock::now());
+        for(const auto& source : mSources)
+        {
+            produced = source.mPoll(*this, mSteps[source.mStep]) || produced;
+            mArena.reset();
+        }
+        return produced;
+    }
+
+    // Reports whether all sources ran dry; sources without an exhausted()
+    // member never do
+    bool exhausted()
+    {
+        if(!mBuilt)
+        {
+            build();
+        }
+        for(const auto& source : mSources)
+        {
+            if(!source.mExhausted(mSteps[source.mStep].mComponent))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void stop()
+    {
+        mStopped.store(true, std::memory_order_relaxed);
+    }
+
+    EventArena& arena()
+    {
+        return mArena;
+    }
+
+private:
+    template<typename Stream, typename In>
+    std::uint32_t addNode(Stream stream)
+    {
+        using Out = detail::OutputType<Stream, In>;
+        if constexpr(!std::is_void_v<In> && std::is_same_v<typename Stream::NodeTag, MapNodeTag>)
+        {
+            using Result = decltype(detail::invokeUpdate(std::declval<Stream&>(), nullptr, std::declval<const In&>()));
+            static_assert(!isTask<std::remove_cvref_t<Result>>, "Processes returning a Task run on a DataStreamManager");
+        }
+        static_assert(alignof(std::conditional_t<std::is_void_v<Out>, char, Out>) <= alignof(std::max_align_t),
+                      "Over-aligned values do not fit the slot buffer");
+        auto* owned = new Stream(std::move(stream));
+        mNodes.push_back(NodeInfo{
+            {owned, [](void* component) { delete static_cast<Stream*>(component); }},
+            &runNode<Stream, In>,
+            nullptr,
+            nullptr,
+            nullptr,
+            {},
+            nullptr,
+            slotSize<Out>(),
+            slotAlign<Out>()
+        });
+        if constexpr(detail::TimedStream<Stream>)
+        {
+            mNodes.back().mFire = &fireTimer<Stream, In>;
+            mNodes.back().mInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(owned->timerInterval()));
+        }
+        if constexpr(requires { owned->finish(); })
+        {
+            mNodes.back().mFinish = [](void* component) { static_cast<Stream*>(component)->finish(); };
+        }
+        mBuilt = false;
+        return static_cast<std::uint32_t>(mNodes.size() - 1);
+    }
+
+    template<typename T>
+    static constexpr std::size_t slotSize()
+    {
+        if constexpr(std::is_void_v<T>)
+        {
+            return 0;
+        }
+        else
+        {
+            return sizeof(T);
+        }
+    }
+
+    template<typename T>
+    static constexpr std::size_t slotAlign()
+    {
+        if constexpr(std::is_void_v<T>)
+        {
+            return 1;
+        }
+        else
+        {
+            return alignof(T);
+        }
+    }
+
+    // Orders the nodes topologically (ties by the order they were added in),
+    // lays out the adjacency array and assigns the slots
+    void build()
+    {
+        const auto count = static_cast<std::uint32_t>(mNodes.size());
+        // Edges grouped by tail, in the order they were added
+        std::vector<std::uint32_t> firstEdge(count + 1, 0);
+        std::vector<std::uint32_t> inputs(count, 0);
+        for(const auto& [tail, head] : mEdges)
+        {
+            ++firstEdge[tail + 1];
+            ++inputs[head];
+        }
+        for(std::uint32_t id = 0; id < count; ++id)
+        {
+            firstEdge[id + 1] += firstEdge[id];
+        }
+        std::vector<std::uint32_t> heads(mEdges.size());
+        {
+            auto next = firstEdge;
+            for(const auto& [tail, head] : mEdges)
+            {
+                heads[next[tail]++] = head;
+            }
+        }
+
+        std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, std::greater<>> ready;
+        for(std::uint32_t id = 0; id < count; ++id)
+        {
+            if(inputs[id] == 0)
+            {
+                ready.push(id);
+            }
+        }
+        std::vector<std::uint32_t> order;
+        order.reserve(count);
+        while(!ready.empty())
+        {
+            const auto id = ready.top();
+            ready.pop();
+            order.push_back(id);
+            for(auto i = firstEdge[id]; i != firstEdge[id + 1]; ++i)
+            {
+                if(--inputs[heads[i]] == 0)
+                {
+                    ready.push(heads[i]);
+                }
+            }
+        }
+        if(order.size() != count)
+        {
+            throw std::logic_error("The runtime graph has a cycle");
+        }
+
+        std::vector<std::uint32_t> position(count);
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            position[order[i]] = i;
+        }
+
+        mSteps.clear();
+        mSuccessors.clear();
+        mSources.clear();
+        mTimed.clear();
+        mTimers = TimingWheel<std::uint32_t>(detail::timerResolution);
+        mTimersArmed = false;
+        std::vector<std::size_t> offsets;
+        std::size_t bufferSize = 0;
+        for(const auto id : order)
+        {
+            const auto& node = mNodes[id];
+            const auto first = static_cast<std::uint32_t>(mSuccessors.size());
+            for(auto i = firstEdge[id]; i != firstEdge[id + 1]; ++i)
+            {
+                mSuccessors.push_back(position[heads[i]]);
+            }
+            bufferSize = (bufferSize + node.mSlotAlign - 1) / node.mSlotAlign * node.mSlotAlign;
+            offsets.push_back(bufferSize);
+            bufferSize += node.mSlotSize;
+            mSteps.push_back(Step{node.mRun, node.mComponent.get(), nullptr, first, static_cast<std::uint32_t>(mSuccessors.size())});
+            if(node.mPoll)
+            {
+                mSources.push_back(Source{position[id], node.mPoll, node.mExhausted});
+            }
+            if(node.mFire)
+            {
+                mTimed.push_back(Timed{position[id], node.mFire, node.mInterval});
+            }
+        }
+        mOrder = std::move(order);
+
+        mSlots.assign((bufferSize + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t), std::max_align_t{});
+        auto* buffer = reinterpret_cast<std::byte*>(mSlots.data());
+        for(std::size_t i = 0; i < mSteps.size(); ++i)
+        {
+            mSteps[i].mSlot = buffer + offsets[i];
+        }
+        mBuilt = true;
+    }
+
+    template<typename Stream, typename... Data>
+    decltype(auto) update(Stream& stream, Data&&... input)
+    {
+        return detail::invokeUpdate(stream, mArena.resource(), std::forward<Data>(input)...);
+    }
+
+    void forward(const Step& step, const void* value)
+    {
+        // Chains end in a tail call rather than a frame per node
+        if(step.mEndSuccessor - step.mFirstSuccessor == 1)
+        {
+            const auto& successor = mSteps[mSuccessors[step.mFirstSuccessor]];
+            return successor.mRun(*this, successor, value);
+        }
+        for(auto i = step.mFirstSuccessor; i != step.mEndSuccessor; ++i)
+        {
+            const auto& successor = mSteps[mSuccessors[i]];
+            successor.mRun(*this, successor, value);
+        }
+    }
+
+    // Branches of a router are its successors in the order they were connected
+    template<typename Selection>
+    void forwardSelected(const Step& step, const Selection& selection, const void* value)
+    {
+        const std::size_t branches = step.mEndSuccessor - step.mFirstSuccessor;
+        if constexpr(std::is_integral_v<Selection>)
+        {
+            const auto branch = static_cast<std::size_t>(selection);
+            if(branch < branches)
+            {
+                const auto& successor = mSteps[mSuccessors[step.mFirstSuccessor + branch]];
+                successor.mRun(*this, successor, value);
+            }
+        }
+        else
+        {
+            for(std::size_t branch = 0; branch < branches && branch < selection.size(); ++branch)
+            {
+                if(selection.test(branch))
+                {
+                    const auto& successor = mSteps[mSuccessors[step.mFirstSuccessor + branch]];
+                    successor.mRun(*this, successor, value);
+                }
+            }
+        }
+    }
+
+    // Places the output of step in its slot while its successors run
+    template<typename Out, typename Value>
+    void emit(const Step& step, Value&& value)
+    {
+        if(step.mFirstSuccessor == step.mEndSuccessor)
+        {
+            return;
+        }
+        if constexpr(std::is_trivially_destructible_v<Out>)
+        {
+            forward(step, std::construct_at(reinterpret_cast<Out*>(step.mSlot), std::forward<Value>(value)));
+        }
+        else
+        {
+            struct Slot
+            {
+                ~Slot()
+                {
+                    std::destroy_at(mValue);
+                }
+
+                Out* mValue;
+            };
+            const Slot slot{std::construct_at(reinterpret_cast<Out*>(step.mSlot), std::forward<Value>(value))};
+            forward(step, slot.mValue);
+        }
+    }
+
+    template<typename Stream, typename In>
+    static void runNode(RuntimeDataStreamManager& self, const Step& step, const void* in)
+    {
+        if constexpr(!std::is_void_v<In>)
+        {
+            auto& stream = *static_cast<Stream*>(step.mComponent);
+            const auto& input = *static_cast<const In*>(in);
+            using Tag = typename Stream::NodeTag;
+            using Out = detail::OutputType<Stream, In>;
+            if constexpr(std::is_same_v<Tag, FilterNodeTag>)
+            {
+                if(stream.test(input))
+                {
+                    self.forward(step, in);
+                }
+            }
+            else if constexpr(std::is_same_v<Tag, RouterNodeTag>)
+            {
+                self.forwardSelected(step, stream.select(input), in);
+            }
+            else if constexpr(std::is_same_v<Tag, FlatMapNodeTag>)
+            {
+                for(const auto& val : self.update(stream, input))
+                {
+                    self.forward(step, &val);
+                }
+            }
+            else if constexpr(std::is_void_v<Out>)
+            {
+                self.update(stream, input);
+            }
+            else
+            {
+                self.emit<Out>(step, self.update(stream, input));
+            }
+        }
+    }
+
+    template<typename Stream>
+    static bool pollSource(RuntimeDataStreamManager& self, const Step& step)
+    {
+        using Out = detail::OutputType<Stream, void>;
+        decltype(auto) val = self.update(*static_cast<Stream*>(step.mComponent));
+        if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>)
+        {
+            if(!val)
+            {
+                return false;
+            }
+            self.emit<Out>(step, *std::move(val));
+        }
+        else
+        {
+            self.emit<Out>(step, std::forward<decltype(val)>(val));
+        }
+        return true;
+    }
+
+    // Arms the timers on the first call. Returns whether any expired.
+    bool fireTimers(Clock::time_point now)
+    {
+        if(!mTimersArmed)
+        {
+            mTimersArmed = true;
+            for(std::uint32_t i = 0; i < mTimed.size(); ++i)
+            {
+                mTimers.schedule(now + mTimed[i].mInterval, i);
+            }
+            return false;
+        }
+        bool fired = false;
+        mTimers.advance(now, [&](std::uint32_t i, Clock::time_point expiry)
+        {
+            fired = true;
+            const auto& timed = mTimed[i];
+            timed.mFire(*this, mSteps[timed.mStep], now);
+            mArena.reset();
+            // Keeps to the period unless the timer fell behind by more than one
+            auto next = expiry + timed.mInterval;
+            if(next <= now)
+            {
+                next = now + timed.mInterval;
+            }
+            mTimers.schedule(next, i);
+        });
+        return fired;
+    }
+
+    template<typename Stream, typename In>
+    static void fireTimer(RuntimeDataStreamManager& self, const Step& step, Clock::time_point now)
+    {
+        auto& stream = *static_cast<Stream*>(step.mComponent);
+        using Out = detail::OutputType<Stream, In>;
+        if constexpr(std::is_void_v<decltype(stream.onTimer(now))>)
+        {
+            stream.onTimer(now);
+        }
+        else
+        {
+            decltype(auto) val = stream.onTimer(now);
+            // Like the result of update, an optional is only unwrapped for sources
+            if constexpr(isOptional<std::remove_cvref_t<decltype(val)>> && std::is_void_v<In>)
+            {
+                if(val)
+                {
+                    self.emit<Out>(step, *std::move(val));
+                }
+            }
+            else if constexpr(!std::is_void_v<Out>)
+            {
+                self.emit<Out>(step, std::forward<decltype(val)>(val));
+            }
+        }
+    }
+
+    template<typename Stream>
+    static bool sourceExhausted(void* component)
+    {
+        auto& stream = *static_cast<Stream*>(component);
+        if constexpr(requires { stream.exhausted(); })
+        {
+            return stream.exhausted();
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    std::vector<NodeInfo> mNodes;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> mEdges;
+    std::vector<Step> mSteps;
+    std::vector<std::uint32_t> mSuccessors;
+    std::vector<Source> mSources;
+    std::vector<Timed> mTimed;
+    // Node identifiers in topological order
+    std::vector<std::uint32_t> mOrder;
+    std::vector<std::max_align_t> mSlots;
+    TimingWheel<std::uint32_t> mTimers{detail::timerResolution};
+    bool mTimersArmed = false;
+    bool mBuilt = false;
+    EventArena mArena;
+    std::atomic<bool> mStopped{false};
+};
+
+}
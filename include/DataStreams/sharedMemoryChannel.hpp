@@ -0,0 +1,515 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dataStream.hpp"
+#include "futex.hpp"
+#include "recordBytes.hpp"
+
+namespace hbreukers
+{
+
+enum class ChannelProducers
+{
+    Single,
+    Multiple
+};
+
+struct ChannelOptions
+{
+    // Payload bytes per slot; each slot occupies a whole number of cache lines
+    std::size_t slotSize = 240;
+    // Rounded up to a power of two
+    std::size_t slotCount = 1024;
+    ChannelProducers producers = ChannelProducers::Single;
+    // How long an empty source sleeps on the futex before returning nothing;
+    // zero never blocks, which suits graphs with several sources
+    std::chrono::microseconds idleWait{0};
+    // Polls of an empty (or full) ring before falling back to the futex
+    unsigned spinCount = 256;
+};
+
+namespace detail
+{
+
+inline constexpr std::size_t cacheLine = 64;
+inline constexpr std::uint64_t channelMagic = 0x4b45455243534d31; // "1MSCREEK"
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "Shared memory channels need address-free atomics");
+
+struct ChannelHeader
+{
+    // Written last by the creating process
+    std::atomic<std::uint64_t> magic;
+    std::uint64_t slotSize;
+    std::uint64_t slotCount;
+    std::uint64_t stride;
+    std::uint32_t multipleProducers;
+
+    // Producer and consumer positions live on separate lines to avoid false sharing
+    alignas(cacheLine) std::atomic<std::uint64_t> head;
+    alignas(cacheLine) std::atomic<std::uint64_t> tail;
+
+    alignas(cacheLine) std::atomic<std::uint32_t> consumerSignal;
+    std::atomic<std::uint32_t> consumerWaiting;
+    alignas(cacheLine) std::atomic<std::uint32_t> producerSignal;
+    std::atomic<std::uint32_t> producersWaiting;
+
+    alignas(cacheLine) std::atomic<std::uint32_t> producers;
+    std::atomic<std::uint32_t> attached;
+};
+
+struct alignas(cacheLine) ChannelSlot
+{
+    // Equals the slot's position when free and position + 1 when it holds a record
+    std::atomic<std::uint64_t> sequence;
+    std::uint32_t length;
+};
+
+inline constexpr std::size_t slotPayloadOffset = 16;
+static_assert(offsetof(ChannelSlot, length) + sizeof(std::uint32_t) <= slotPayloadOffset);
+
+}
+
+// Bounded ring of fixed-size slots in POSIX shared memory, written by one or
+// several producers and read by a single consumer, possibly in other processes.
+// Whichever side opens a name first creates the ring with its options; later
+// openers adopt the geometry already in place. A name nobody has open any
+// more, left behind by processes that exited without unlinking it or crashed
+// without detaching, is laid out afresh by its next opener. Idle sides spin briefly and then
+// sleep on a futex, which the other side only touches when someone is asleep.
+class SharedMemoryChannel
+{
+public:
+    SharedMemoryChannel(const std::string& name, const ChannelOptions& options = {}):
+    mSpinCount(options.spinCount)
+    {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if(fd >= 0)
+        {
+            lock(fd, F_RDLCK, true, name);
+            create(fd, name, options);
+        }
+        else if(errno == EEXIST)
+        {
+            fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0600);
+            if(fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            }
+            // Its creator locks a segment before sizing it, so a sized one
+            // nobody holds a lock on was abandoned, counters and all
+            const bool abandoned = lock(fd, F_WRLCK, false, name) && size(fd, name) > 0;
+            if(abandoned)
+            {
+                create(fd, name, options);
+            }
+            lock(fd, F_RDLCK, true, name);
+            if(!abandoned)
+            {
+                attach(fd, name);
+            }
+        }
+        else
+        {
+            throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+        }
+        mFd = fd;
+    }
+
+    SharedMemoryChannel(const SharedMemoryChannel&) = delete;
+    SharedMemoryChannel& operator=(const SharedMemoryChannel&) = delete;
+
+    ~SharedMemoryChannel()
+    {
+        ::munmap(mHeader, mSize);
+        ::close(mFd);
+    }
+
+    // Removes the name; processes that have it open keep their mapping
+    static void unlink(const std::string& name)
+    {
+        ::shm_unlink(name.c_str());
+    }
+
+    std::size_t slotSize() const { return mHeader->slotSize; }
+    std::size_t slotCount() const { return mHeader->slotCount; }
+    bool multipleProducers() const { return mHeader->multipleProducers != 0; }
+
+    // Copies bytes into the next free slot, returns false when the ring is full
+    bool tryPush(std::span<const std::byte> bytes)
+    {
+        if(bytes.size() > slotSize())
+        {
+            throw std::length_error("Record of " + std::to_string(bytes.size()) + " bytes exceeds the channel's slot size");
+        }
+        auto position = mHeader->head.load(std::memory_order_relaxed);
+        detail::ChannelSlot* slot;
+        while(true)
+        {
+            slot = slotAt(position);
+            const auto sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::int64_t>(sequence - position);
+            if(difference == 0)
+            {
+                if(!multipleProducers())
+                {
+                    mHeader->head.store(position + 1, std::memory_order_relaxed);
+                    break;
+                }
+                if(mHeader->head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if(difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = mHeader->head.load(std::memory_order_relaxed);
+            }
+        }
+        std::memcpy(payload(slot), bytes.data(), bytes.size());
+        slot->length = static_cast<std::uint32_t>(bytes.size());
+        slot->sequence.store(position + 1, std::memory_order_release);
+        notify(mHeader->consumerSignal, mHeader->consumerWaiting);
+        return true;
+    }
+
+    // Waits for a free slot when the ring is full
+    void push(std::span<const std::byte> bytes)
+    {
+        for(unsigned spin = 0; !tryPush(bytes); ++spin)
+        {
+            if(spin < mSpinCount)
+            {
+                continue;
+            }
+            const auto signal = mHeader->producerSignal.load(std::memory_order_relaxed);
+            mHeader->producersWaiting.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(full())
+            {
+                detail::futexWait(mHeader->producerSignal, signal, std::chrono::milliseconds(1), detail::FutexScope::Shared);
+            }
+            mHeader->producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // The oldest record, valid until the next call (which hands its slot back
+    // to the producers). Only one consumer may read a channel.
+    std::optional<std::span<const std::byte>> tryPop()
+    {
+        if(mHolding)
+        {
+            const auto tail = mHeader->tail.load(std::memory_order_relaxed);
+            slotAt(tail)->sequence.store(tail + slotCount(), std::memory_order_release);
+            mHeader->tail.store(tail + 1, std::memory_order_relaxed);
+            mHolding = false;
+            notify(mHeader->producerSignal, mHeader->producersWaiting);
+        }
+        if(!ready())
+        {
+            return std::nullopt;
+        }
+        auto* slot = slotAt(mHeader->tail.load(std::memory_order_relaxed));
+        mHolding = true;
+        return std::span<const std::byte>(payload(slot), slot->length);
+    }
+
+    // Spins, then sleeps until a record arrives or the timeout passes
+    void waitReadable(std::chrono::nanoseconds timeout)
+    {
+        for(unsigned spin = 0; spin < mSpinCount; ++spin)
+        {
+            if(ready() || closed())
+            {
+                return;
+            }
+        }
+        const auto signal = mHeader->consumerSignal.load(std::memory_order_relaxed);
+        mHeader->consumerWaiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!ready() && !closed())
+        {
+            detail::futexWait(mHeader->consumerSignal, signal, timeout, detail::FutexScope::Shared);
+        }
+        mHeader->consumerWaiting.store(0, std::memory_order_relaxed);
+    }
+
+    // Whether the record at the consumer's position (including one being held) is published
+    bool ready() const
+    {
+        const auto tail = mHeader->tail.load(std::memory_order_relaxed);
+        const auto offset = mHolding ? 1u : 0u;
+        return slotAt(tail + offset)->sequence.load(std::memory_order_acquire) == tail + offset + 1;
+    }
+
+    bool full() const
+    {
+        const auto head = mHeader->head.load(std::memory_order_relaxed);
+        return slotAt(head)->sequence.load(std::memory_order_acquire) != head;
+    }
+
+    // Registers a producer, rejecting a second one on a single producer channel
+    void attachProducer()
+    {
+        const auto previous = mHeader->producers.fetch_add(1, std::memory_order_acq_rel);
+        if(previous > 0 && !multipleProducers())
+        {
+            mHeader->producers.fetch_sub(1, std::memory_order_acq_rel);
+            throw std::logic_error("Channel was created for a single producer");
+        }
+        mHeader->attached.store(1, std::memory_order_release);
+    }
+
+    void detachProducer()
+    {
+        mHeader->producers.fetch_sub(1, std::memory_order_acq_rel);
+        notify(mHeader->consumerSignal, mHeader->consumerWaiting);
+    }
+
+    // A producer attached at some point and all of them have left since
+    bool closed() const
+    {
+        return mHeader->attached.load(std::memory_order_acquire) != 0
+            && mHeader->producers.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    void create(int fd, const std::string& name, const ChannelOptions& options)
+    {
+        const auto slotCount = std::bit_ceil(std::max<std::size_t>(options.slotCount, 2));
+        const auto stride = (detail::slotPayloadOffset + options.slotSize + detail::cacheLine - 1) / detail::cacheLine * detail::cacheLine;
+        mSize = sizeof(detail::ChannelHeader) + slotCount * stride;
+        if(::ftruncate(fd, static_cast<off_t>(mSize)) != 0)
+        {
+            fail(fd, "ftruncate " + name);
+        }
+        map(fd, name);
+        auto* header = new(mHeader) detail::ChannelHeader{};
+        header->slotSize = options.slotSize;
+        header->slotCount = slotCount;
+        header->stride = stride;
+        header->multipleProducers = options.producers == ChannelProducers::Multiple ? 1 : 0;
+        for(std::size_t i = 0; i < slotCount; ++i)
+        {
+            new(slotAt(i)) detail::ChannelSlot{};
+            slotAt(i)->sequence.store(i, std::memory_order_relaxed);
+        }
+        header->magic.store(detail::channelMagic, std::memory_order_release);
+    }
+
+    void attach(int fd, const std::string& name)
+    {
+        // The creator may still be sizing and initialising the ring
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while(true)
+        {
+            mSize = size(fd, name);
+            if(mSize >= sizeof(detail::ChannelHeader))
+            {
+                break;
+            }
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                ::close(fd);
+                throw std::runtime_error("Shared memory channel " + name + " was never initialised");
+            }
+            std::this_thread::yield();
+        }
+        map(fd, name);
+        while(mHeader->magic.load(std::memory_order_acquire) != detail::channelMagic)
+        {
+            if(std::chrono::steady_clock::now() > deadline)
+            {
+                ::munmap(mHeader, mSize);
+                ::close(fd);
+                throw std::runtime_error("Shared memory channel " + name + " was never initialised");
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void map(int fd, const std::string& name)
+    {
+        void* data = ::mmap(nullptr, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(data == MAP_FAILED)
+        {
+            fail(fd, "mmap " + name);
+        }
+        mHeader = static_cast<detail::ChannelHeader*>(data);
+    }
+
+    static std::size_t size(int fd, const std::string& name)
+    {
+        struct stat info{};
+        if(::fstat(fd, &info) != 0)
+        {
+            fail(fd, "fstat " + name);
+        }
+        return static_cast<std::size_t>(info.st_size);
+    }
+
+    // Every channel holds a read lock on its segment for as long as it lives.
+    // These are locks of the open file description, so channels in the same
+    // process do not share them, and a write lock turns into a read lock
+    // without letting anyone in between.
+    static bool lock(int fd, short type, bool wait, const std::string& name)
+    {
+        struct flock range{};
+        range.l_type = type;
+        range.l_whence = SEEK_SET;
+        while(::fcntl(fd, wait ? F_OFD_SETLKW : F_OFD_SETLK, &range) != 0)
+        {
+            if(!wait && (errno == EAGAIN || errno == EACCES))
+            {
+                return false;
+            }
+            if(errno != EINTR)
+            {
+                fail(fd, "fcntl " + name);
+            }
+        }
+        return true;
+    }
+
+    [[noreturn]] static void fail(int fd, const std::string& what)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), what);
+    }
+
+    // Wakes the other side if it announced it is going to sleep
+    static void notify(std::atomic<std::uint32_t>& signal, std::atomic<std::uint32_t>& waiting)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(waiting.load(std::memory_order_relaxed) != 0)
+        {
+            signal.fetch_add(1, std::memory_order_relaxed);
+            detail::futexWake(signal, detail::FutexScope::Shared);
+        }
+    }
+
+    detail::ChannelSlot* slotAt(std::uint64_t position) const
+    {
+        auto* slots = reinterpret_cast<std::byte*>(mHeader) + sizeof(detail::ChannelHeader);
+        return reinterpret_cast<detail::ChannelSlot*>(slots + (position & (mHeader->slotCount - 1)) * mHeader->stride);
+    }
+
+    static std::byte* payload(detail::ChannelSlot* slot)
+    {
+        return reinterpret_cast<std::byte*>(slot) + detail::slotPayloadOffset;
+    }
+
+    detail::ChannelHeader* mHeader = nullptr;
+    std::size_t mSize = 0;
+    int mFd = -1;
+    unsigned mSpinCount;
+    bool mHolding = false;
+};
+
+// Reads a shared memory channel; each record is a view into its slot, valid
+// until the next call. Exhausted once every producer detached and the ring is
+// drained. Copies share the consumer position.
+class SharedMemorySource
+{
+public:
+    SharedMemorySource(const std::string& name, const ChannelOptions& options = {}):
+    mChannel(std::make_shared<SharedMemoryChannel>(name, options)),
+    mIdleWait(options.idleWait)
+    {}
+
+    std::optional<std::span<const std::byte>> operator()()
+    {
+        auto record = mChannel->tryPop();
+        if(!record && mIdleWait.count() > 0)
+        {
+            mChannel->waitReadable(mIdleWait);
+            record = mChannel->tryPop();
+        }
+        return record;
+    }
+
+    bool exhausted() const
+    {
+        return mChannel->closed() && !mChannel->ready();
+    }
+
+    bool waitReady(std::chrono::nanoseconds timeout)
+    {
+        mChannel->waitReadable(timeout);
+        return mChannel->ready();
+    }
+
+private:
+    std::shared_ptr<SharedMemoryChannel> mChannel;
+    std::chrono::microseconds mIdleWait;
+};
+
+// Writes every record's recordBytes() into a shared memory channel, waiting
+// while the ring is full. Copies count as a single producer.
+class SharedMemorySink
+{
+public:
+    SharedMemorySink(const std::string& name, const ChannelOptions& options = {}):
+    mState(std::make_shared<State>(name, options))
+    {}
+
+    template<typename Record>
+    void operator()(const Record& record)
+    {
+        mState->mChannel.push(recordBytes(record));
+    }
+
+private:
+    struct State
+    {
+        State(const std::string& name, const ChannelOptions& options):
+        mChannel(name, options)
+        {
+            mChannel.attachProducer();
+        }
+
+        State(const State&) = delete;
+        State& operator=(const State&) = delete;
+
+        ~State()
+        {
+            mChannel.detachProducer();
+        }
+
+        SharedMemoryChannel mChannel;
+    };
+
+    std::shared_ptr<State> mState;
+};
+
+inline auto makeSharedMemorySource(const std::string& name, const ChannelOptions& options = {})
+{
+    return makeSource(SharedMemorySource(name, options));
+}
+
+}
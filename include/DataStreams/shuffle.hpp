@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "../CompileTimeGraph/ctgl.hpp"
+
+// Key-partitioned shuffle stages. A router with a partitionBy() selector
+// spreads records over N replicas of a stream, added to a pipeline through
+// replicated(); every stream derived from the replicated one becomes the
+// gather, reading from all replicas. shuffle() makes the router and the
+// replicas together. On a ThreadedDataStreamManager each replica runs on a
+// thread of its own, fed by an SpscQueue of its own.
+namespace hbreukers
+{
+
+// Tag of the I-th replica of Stream, to place it with ExecutorOptions::placement
+template<typename Stream, std::size_t I>
+struct Replica {};
+
+template<typename Stream, std::size_t I>
+using ReplicaNode = ctgl::Node<Replica<Stream, I>>;
+
+// Selector for route() sending every record to one of Replicas branches by
+// the hash of its key, so records sharing a key reach the same replica, in
+// order. The hash is mixed, so integer keys with a common stride still spread.
+template<std::size_t Replicas, typename KeyOf>
+class Partition
+{
+public:
+    static_assert(Replicas > 0, "A shuffle needs at least one replica");
+
+    // Checked against the replicas it feeds when built into a pipeline
+    static constexpr std::size_t branches = Replicas;
+
+    explicit Partition(KeyOf keyOf):
+    mKeyOf(std::move(keyOf))
+    {}
+
+    std::size_t operator()(const auto& in) const
+        requires std::invocable<const KeyOf&, decltype(in)>
+    {
+        const auto& key = std::invoke(mKeyOf, in);
+        const auto hash = static_cast<std::uint64_t>(std::hash<std::remove_cvref_t<decltype(key)>>{}(key));
+        // The high bits of the product depend on every bit of the hash
+        const auto mixed = (hash * 0x9E3779B97F4A7C15ull) >> 32;
+        return static_cast<std::size_t>((mixed * Replicas) >> 32);
+    }
+
+private:
+    KeyOf mKeyOf;
+};
+
+template<std::size_t Replicas, typename KeyOf>
+auto partitionBy(KeyOf keyOf)
+{
+    return Partition<Replicas, KeyOf>{std::move(keyOf)};
+}
+
+// Replicas copies of Stream. Each copy holds state of its own, so the state
+// of the stream must be held by value rather than shared through a pointer.
+template<std::size_t Replicas, typename Stream>
+struct Replicated
+{
+    static_assert(Replicas > 0, "A shuffle needs at least one replica");
+    static_assert(std::is_copy_constructible_v<Stream>, "Replicated streams are copied once per replica");
+
+    using StreamType = Stream;
+    using Upstream = typename Stream::Upstream;
+    static constexpr std::size_t count = Replicas;
+
+    // Streams derived from it gather from all replicas
+    Stream& stream()
+    {
+        return mStream;
+    }
+
+    Stream mStream;
+};
+
+template<std::size_t Replicas, typename Stream>
+auto replicated(Stream&& stream)
+{
+    return Replicated<Replicas, std::decay_t<Stream>>{std::forward<Stream>(stream)};
+}
+
+// The router of a shuffle, made by shuffle(), whose process() makes the
+// replicas it spreads over
+template<std::size_t Replicas, typename Router>
+struct Shuffle
+{
+    template<typename Process>
+    auto process(const Process& process)
+    {
+        return replicated<Replicas>(mRouter.process(process));
+    }
+
+    Router& router()
+    {
+        return mRouter;
+    }
+
+    Router mRouter;
+};
+
+// Partitions the records of upstream by keyOf over Replicas replicas, so that
+// the router and the replicas cannot disagree on the count. Add router() and
+// the replicas returned by process() to the pipeline.
+template<std::size_t Replicas, typename KeyOf, typename Upstream>
+auto shuffle(KeyOf keyOf, Upstream& upstream)
+{
+    auto router = upstream.route(partitionBy<Replicas>(std::move(keyOf)));
+    return Shuffle<Replicas, decltype(router)>{std::move(router)};
+}
+
+}
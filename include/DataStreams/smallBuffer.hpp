@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace hbreukers
+{
+
+// Fixed capacity buffer with inline storage, reused between updates so that
+// emitting several values from a node never touches the heap. Values pushed
+// into a full buffer are counted in overflowed(), which clear() leaves be.
+template<typename T, std::size_t Capacity>
+class SmallBuffer
+{
+public:
+    SmallBuffer() = default;
+
+    SmallBuffer(const SmallBuffer& other):
+    mOverflowed(other.mOverflowed)
+    {
+        for(const auto& value : other)
+        {
+            emplace(value);
+        }
+    }
+
+    SmallBuffer& operator=(const SmallBuffer& other)
+    {
+        if(this != &other)
+        {
+            clear();
+            for(const auto& value : other)
+            {
+                emplace(value);
+            }
+            mOverflowed = other.mOverflowed;
+        }
+        return *this;
+    }
+
+    ~SmallBuffer()
+    {
+        clear();
+    }
+
+    // Returns false, drops the value and counts it when the buffer is full.
+    template<typename... Args>
+    bool emplace(Args&&... args)
+    {
+        if(mSize == Capacity)
+        {
+            ++mOverflowed;
+            return false;
+        }
+        std::construct_at(data() + mSize, std::forward<Args>(args)...);
+        ++mSize;
+        return true;
+    }
+
+    bool push(const T& value)
+    {
+        return emplace(value);
+    }
+
+    bool push(T&& value)
+    {
+        return emplace(std::move(value));
+    }
+
+    void clear()
+    {
+        std::destroy(begin(), end());
+        mSize = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const { return mSize; }
+    [[nodiscard]] bool empty() const { return mSize == 0; }
+    [[nodiscard]] bool full() const { return mSize == Capacity; }
+    static constexpr std::size_t capacity() { return Capacity; }
+    // Values dropped since construction because the buffer was full
+    [[nodiscard]] std::size_t overflowed() const { return mOverflowed; }
+
+    T* begin() { return data(); }
+    T* end() { return data() + mSize; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + mSize; }
+
+    T& operator[](std::size_t i) { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+
+private:
+    T* data() { return std::launder(reinterpret_cast<T*>(mStorage)); }
+    const T* data() const { return std::launder(reinterpret_cast<const T*>(mStorage)); }
+
+    alignas(T) std::byte mStorage[sizeof(T) * Capacity];
+    std::size_t mSize = 0;
+    std::size_t mOverflowed = 0;
+};
+
+}
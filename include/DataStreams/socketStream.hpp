@@ -0,0 +1,761 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dataStream.hpp"
+#include "recordBytes.hpp"
+
+namespace hbreukers
+{
+
+enum class Transport
+{
+    Tcp,
+    Udp,
+    UnixStream,
+    UnixDatagram
+};
+
+class Endpoint
+{
+public:
+    static Endpoint tcp(const std::string& host, std::uint16_t port)
+    {
+        return inet(Transport::Tcp, host, port);
+    }
+
+    static Endpoint udp(const std::string& host, std::uint16_t port)
+    {
+        return inet(Transport::Udp, host, port);
+    }
+
+    static Endpoint unixStream(const std::string& path)
+    {
+        return local(Transport::UnixStream, path);
+    }
+
+    static Endpoint unixDatagram(const std::string& path)
+    {
+        return local(Transport::UnixDatagram, path);
+    }
+
+    // The address a socket ended up bound to (e.g. the port picked for port 0)
+    static Endpoint boundTo(int fd, Transport transport)
+    {
+        Endpoint endpoint(transport);
+        endpoint.mLength = sizeof(endpoint.mAddress);
+        if(::getsockname(fd, endpoint.address(), &endpoint.mLength) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "getsockname");
+        }
+        return endpoint;
+    }
+
+    Transport transport() const { return mTransport; }
+    bool datagram() const { return mTransport == Transport::Udp || mTransport == Transport::UnixDatagram; }
+    int family() const { return mAddress.ss_family; }
+    int type() const { return datagram() ? SOCK_DGRAM : SOCK_STREAM; }
+    const sockaddr* address() const { return reinterpret_cast<const sockaddr*>(&mAddress); }
+    sockaddr* address() { return reinterpret_cast<sockaddr*>(&mAddress); }
+    socklen_t length() const { return mLength; }
+
+    std::uint16_t port() const
+    {
+        return family() == AF_INET ? ntohs(reinterpret_cast<const sockaddr_in*>(&mAddress)->sin_port) : 0;
+    }
+
+private:
+    explicit Endpoint(Transport transport):
+    mTransport(transport)
+    {}
+
+    static Endpoint inet(Transport transport, const std::string& host, std::uint16_t port)
+    {
+        Endpoint endpoint(transport);
+        auto* address = reinterpret_cast<sockaddr_in*>(&endpoint.mAddress);
+        address->sin_family = AF_INET;
+        address->sin_port = htons(port);
+        if(::inet_pton(AF_INET, host.c_str(), &address->sin_addr) != 1)
+        {
+            throw std::invalid_argument("Not an IPv4 address: " + host);
+        }
+        endpoint.mLength = sizeof(sockaddr_in);
+        return endpoint;
+    }
+
+    static Endpoint local(Transport transport, const std::string& path)
+    {
+        Endpoint endpoint(transport);
+        auto* address = reinterpret_cast<sockaddr_un*>(&endpoint.mAddress);
+        if(path.size() >= sizeof(address->sun_path))
+        {
+            throw std::invalid_argument("Unix socket path too long: " + path);
+        }
+        address->sun_family = AF_UNIX;
+        std::memcpy(address->sun_path, path.c_str(), path.size() + 1);
+        endpoint.mLength = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+        return endpoint;
+    }
+
+    Transport mTransport;
+    sockaddr_storage mAddress{};
+    socklen_t mLength = 0;
+};
+
+// Receives readiness notifications from a Reactor
+class EventHandler
+{
+public:
+    virtual ~EventHandler() = default;
+    virtual void onEvent(std::uint32_t events) = 0;
+};
+
+// Level-triggered epoll loop shared by the socket sources and sinks of a
+// pipeline. Sources poll it without blocking from the manager's step(); an idle
+// pipeline can block in poll() with a timeout instead of spinning.
+class Reactor
+{
+public:
+    Reactor():
+    mEpoll(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        if(mEpoll < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "epoll_create1");
+        }
+    }
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ~Reactor()
+    {
+        ::close(mEpoll);
+    }
+
+    void add(int fd, std::uint32_t events, EventHandler* handler)
+    {
+        control(EPOLL_CTL_ADD, fd, events, handler);
+    }
+
+    void modify(int fd, std::uint32_t events, EventHandler* handler)
+    {
+        control(EPOLL_CTL_MOD, fd, events, handler);
+    }
+
+    void remove(int fd)
+    {
+        ::epoll_ctl(mEpoll, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    // Dispatches ready events, waiting up to timeoutMs (0 does not block).
+    // Returns the number of events handled.
+    std::size_t poll(int timeoutMs = 0)
+    {
+        const int count = ::epoll_wait(mEpoll, mEvents.data(), static_cast<int>(mEvents.size()), timeoutMs);
+        if(count < 0)
+        {
+            if(errno == EINTR)
+            {
+                return 0;
+            }
+            throw std::system_error(errno, std::generic_category(), "epoll_wait");
+        }
+        for(int i = 0; i < count; ++i)
+        {
+            const auto& event = mEvents[static_cast<std::size_t>(i)];
+            static_cast<EventHandler*>(event.data.ptr)->onEvent(event.events);
+        }
+        return static_cast<std::size_t>(count);
+    }
+
+private:
+    void control(int operation, int fd, std::uint32_t events, EventHandler* handler)
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.ptr = handler;
+        if(::epoll_ctl(mEpoll, operation, fd, &event) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+        }
+    }
+
+    int mEpoll;
+    std::array<epoll_event, 64> mEvents{};
+};
+
+namespace detail
+{
+
+class Socket
+{
+public:
+    Socket() = default;
+
+    explicit Socket(int fd):
+    mFd(fd)
+    {}
+
+    Socket(const Endpoint& endpoint):
+    mFd(::socket(endpoint.family(), endpoint.type() | SOCK_NONBLOCK | SOCK_CLOEXEC, 0))
+    {
+        if(mFd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "socket");
+        }
+    }
+
+    Socket(Socket&& other) noexcept:
+    mFd(std::exchange(other.mFd, -1))
+    {}
+
+    Socket& operator=(Socket&& other) noexcept
+    {
+        std::swap(mFd, other.mFd);
+        return *this;
+    }
+
+    ~Socket()
+    {
+        if(mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    int fd() const { return mFd; }
+
+private:
+    int mFd = -1;
+};
+
+inline void check(int result, const char* what)
+{
+    if(result != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+}
+
+inline std::size_t frameLength(const std::byte* prefix)
+{
+    return std::to_integer<std::size_t>(prefix[0])
+        | std::to_integer<std::size_t>(prefix[1]) << 8
+        | std::to_integer<std::size_t>(prefix[2]) << 16
+        | std::to_integer<std::size_t>(prefix[3]) << 24;
+}
+
+inline constexpr std::size_t framePrefix = sizeof(std::uint32_t);
+
+}
+
+struct SocketOptions
+{
+    // Datagrams received or sent per recvmmsg/sendmmsg call
+    std::size_t batchSize = 32;
+    // Larger datagrams are truncated
+    std::size_t maxDatagramSize = 2048;
+    // Stream sinks send once this many bytes are pending (0 sends every record)
+    std::size_t sendThreshold = 0;
+};
+
+// Binds to an endpoint and emits each received record as a view valid until the
+// next call. Stream transports accept any number of peers and split their byte
+// streams into frames prefixed by a little-endian uint32_t length; datagram
+// transports emit one record per datagram, read in batches with recvmmsg.
+class SocketSource
+{
+public:
+    SocketSource(std::shared_ptr<Reactor> reactor, const Endpoint& endpoint, const SocketOptions& options = {}):
+    mState(std::make_shared<State>(std::move(reactor), endpoint, options))
+    {}
+
+    std::optional<std::span<const std::byte>> operator()()
+    {
+        return mState->next();
+    }
+
+    // Blocks in the reactor for up to timeout until a whole frame came in, so
+    // an idle run() does not spin on the socket
+    bool waitReady(std::chrono::nanoseconds timeout)
+    {
+        return mState->waitReady(timeout);
+    }
+
+    // Where peers connect or send to
+    Endpoint localEndpoint() const
+    {
+        return Endpoint::boundTo(mState->fd(), mState->transport());
+    }
+
+private:
+    struct Connection : EventHandler
+    {
+        Connection(detail::Socket socket):
+        mSocket(std::move(socket))
+        {}
+
+        void onEvent(std::uint32_t) override
+        {
+            // Drop the consumed prefix before reading more
+            if(mBegin > 0)
+            {
+                mBuffer.erase(mBuffer.begin(), mBuffer.begin() + static_cast<std::ptrdiff_t>(mBegin));
+                mBegin = 0;
+            }
+            while(true)
+            {
+                const auto size = mBuffer.size();
+                mBuffer.resize(std::max(size + 4096, mBuffer.capacity()));
+                const auto received = ::recv(mSocket.fd(), mBuffer.data() + size, mBuffer.size() - size, 0);
+                mBuffer.resize(size + static_cast<std::size_t>(std::max<ssize_t>(received, 0)));
+                if(received > 0)
+                {
+                    continue;
+                }
+                if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                {
+                    mClosed = true;
+                }
+                if(received == 0 || errno != EINTR)
+                {
+                    return;
+                }
+            }
+        }
+
+        bool hasFrame() const
+        {
+            const auto available = mBuffer.size() - mBegin;
+            return available >= detail::framePrefix && available - detail::framePrefix >= detail::frameLength(mBuffer.data() + mBegin);
+        }
+
+        std::optional<std::span<const std::byte>> nextFrame()
+        {
+            const auto available = mBuffer.size() - mBegin;
+            if(available < detail::framePrefix)
+            {
+                return std::nullopt;
+            }
+            const auto length = detail::frameLength(mBuffer.data() + mBegin);
+            if(available - detail::framePrefix < length)
+            {
+                return std::nullopt;
+            }
+            const std::span<const std::byte> frame(mBuffer.data() + mBegin + detail::framePrefix, length);
+            mBegin += detail::framePrefix + length;
+            return frame;
+        }
+
+        detail::Socket mSocket;
+        std::vector<std::byte> mBuffer;
+        std::size_t mBegin = 0;
+        bool mClosed = false;
+    };
+
+    class State : public EventHandler
+    {
+    public:
+        State(std::shared_ptr<Reactor> reactor, const Endpoint& endpoint, const SocketOptions& options):
+        mReactor(std::move(reactor)),
+        mTransport(endpoint.transport()),
+        mSocket(endpoint),
+        mOptions(options)
+        {
+            const int on = 1;
+            ::setsockopt(mSocket.fd(), SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            detail::check(::bind(mSocket.fd(), endpoint.address(), endpoint.length()), "bind");
+            if(endpoint.datagram())
+            {
+                mStorage.resize(mOptions.batchSize * mOptions.maxDatagramSize);
+                mIovecs.resize(mOptions.batchSize);
+                mMessages.resize(mOptions.batchSize);
+                for(std::size_t i = 0; i < mOptions.batchSize; ++i)
+                {
+                    mIovecs[i].iov_base = mStorage.data() + i * mOptions.maxDatagramSize;
+                    mIovecs[i].iov_len = mOptions.maxDatagramSize;
+                    mMessages[i].msg_hdr.msg_iov = &mIovecs[i];
+                    mMessages[i].msg_hdr.msg_iovlen = 1;
+                }
+            }
+            else
+            {
+                detail::check(::listen(mSocket.fd(), SOMAXCONN), "listen");
+            }
+            mReactor->add(mSocket.fd(), EPOLLIN, this);
+        }
+
+        State(const State&) = delete;
+        State& operator=(const State&) = delete;
+
+        ~State() override
+        {
+            for(const auto& connection : mConnections)
+            {
+                mReactor->remove(connection->mSocket.fd());
+            }
+            mReactor->remove(mSocket.fd());
+        }
+
+        int fd() const { return mSocket.fd(); }
+        Transport transport() const { return mTransport; }
+
+        std::optional<std::span<const std::byte>> next()
+        {
+            if(auto frame = buffered())
+            {
+                return frame;
+            }
+            mReactor->poll(0);
+            return buffered();
+        }
+
+        bool waitReady(std::chrono::nanoseconds timeout)
+        {
+            // Polling while frames are buffered would overwrite the datagrams
+            if(!ready())
+            {
+                const auto ms = std::chrono::ceil<std::chrono::milliseconds>(timeout).count();
+                mReactor->poll(static_cast<int>(std::min<std::int64_t>(ms, std::numeric_limits<int>::max())));
+            }
+            return ready();
+        }
+
+        // Readable listening or datagram socket
+        void onEvent(std::uint32_t) override
+        {
+            if(!mMessages.empty())
+            {
+                receiveDatagrams();
+                return;
+            }
+            while(true)
+            {
+                const int fd = ::accept4(mSocket.fd(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(fd < 0)
+                {
+                    return;
+                }
+                const int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                mConnections.push_back(std::make_unique<Connection>(detail::Socket(fd)));
+                mReactor->add(fd, EPOLLIN | EPOLLRDHUP, mConnections.back().get());
+            }
+        }
+
+    private:
+        bool ready() const
+        {
+            if(!mMessages.empty())
+            {
+                return mNext != mReceived;
+            }
+            return std::ranges::any_of(mConnections, [](const auto& connection) { return connection->hasFrame(); });
+        }
+
+        std::optional<std::span<const std::byte>> buffered()
+        {
+            if(!mMessages.empty())
+            {
+                if(mNext == mReceived)
+                {
+                    return std::nullopt;
+                }
+                const auto& message = mMessages[mNext++];
+                return std::span<const std::byte>(static_cast<const std::byte*>(message.msg_hdr.msg_iov->iov_base), message.msg_len);
+            }
+            for(std::size_t i = 0; i < mConnections.size(); ++i)
+            {
+                // Round robin over the peers so none of them starves the others
+                auto& connection = *mConnections[(mCursor + i) % mConnections.size()];
+                if(auto frame = connection.nextFrame())
+                {
+                    mCursor = (mCursor + i + 1) % mConnections.size();
+                    return frame;
+                }
+            }
+            pruneClosed();
+            return std::nullopt;
+        }
+
+        void receiveDatagrams()
+        {
+            // Earlier datagrams are still being handed out
+            if(mNext != mReceived)
+            {
+                return;
+            }
+            const int count = ::recvmmsg(mSocket.fd(), mMessages.data(), static_cast<unsigned>(mMessages.size()), MSG_DONTWAIT, nullptr);
+            mNext = 0;
+            mReceived = count > 0 ? static_cast<std::size_t>(count) : 0;
+        }
+
+        void pruneClosed()
+        {
+            std::erase_if(mConnections, [&](const auto& connection)
+            {
+                if(connection->mClosed)
+                {
+                    mReactor->remove(connection->mSocket.fd());
+                }
+                return connection->mClosed;
+            });
+        }
+
+        std::shared_ptr<Reactor> mReactor;
+        Transport mTransport;
+        detail::Socket mSocket;
+        SocketOptions mOptions;
+        std::vector<std::unique_ptr<Connection>> mConnections;
+        std::size_t mCursor = 0;
+        std::vector<std::byte> mStorage;
+        std::vector<iovec> mIovecs;
+        std::vector<mmsghdr> mMessages;
+        std::size_t mReceived = 0;
+        std::size_t mNext = 0;
+    };
+
+    std::shared_ptr<State> mState;
+};
+
+// Connects to an endpoint and sends every record's recordBytes(). Stream
+// transports frame records with a little-endian uint32_t length and keep
+// unsent bytes until the reactor reports the socket writable; datagram
+// transports send one datagram per record, batched with sendmmsg.
+class SocketSink
+{
+public:
+    SocketSink(std::shared_ptr<Reactor> reactor, const Endpoint& endpoint, const SocketOptions& options = {}):
+    mState(std::make_shared<State>(std::move(reactor), endpoint, options))
+    {}
+
+    template<typename Record>
+    void operator()(const Record& record)
+    {
+        mState->push(recordBytes(record));
+    }
+
+    // Sends everything pending, blocking until the socket accepted it
+    void flush()
+    {
+        mState->flush();
+    }
+
+private:
+    class State : public EventHandler
+    {
+    public:
+        State(std::shared_ptr<Reactor> reactor, const Endpoint& endpoint, const SocketOptions& options):
+        mReactor(std::move(reactor)),
+        mSocket(endpoint),
+        mOptions(options),
+        mDatagram(endpoint.datagram())
+        {
+            if(::connect(mSocket.fd(), endpoint.address(), endpoint.length()) != 0 && errno != EINPROGRESS)
+            {
+                throw std::system_error(errno, std::generic_category(), "connect");
+            }
+            if(mDatagram)
+            {
+                mStorage.resize(mOptions.batchSize * mOptions.maxDatagramSize);
+                mIovecs.resize(mOptions.batchSize);
+                mMessages.resize(mOptions.batchSize);
+            }
+            else
+            {
+                const int on = 1;
+                ::setsockopt(mSocket.fd(), IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            }
+            mReactor->add(mSocket.fd(), 0, this);
+        }
+
+        State(const State&) = delete;
+        State& operator=(const State&) = delete;
+
+        ~State() override
+        {
+            try
+            {
+                flush();
+            }
+            catch(...)
+            {
+                // The peer went away, nothing left to deliver to
+            }
+            mReactor->remove(mSocket.fd());
+        }
+
+        void push(std::span<const std::byte> bytes)
+        {
+            if(mDatagram)
+            {
+                pushDatagram(bytes);
+                return;
+            }
+            const auto length = static_cast<std::uint32_t>(bytes.size());
+            const std::array<std::byte, detail::framePrefix> prefix{
+                std::byte(length & 0xff), std::byte((length >> 8) & 0xff),
+                std::byte((length >> 16) & 0xff), std::byte((length >> 24) & 0xff)};
+            mPending.insert(mPending.end(), prefix.begin(), prefix.end());
+            mPending.insert(mPending.end(), bytes.begin(), bytes.end());
+            if(mPending.size() - mSent > mOptions.sendThreshold)
+            {
+                sendPending();
+            }
+        }
+
+        void flush()
+        {
+            if(mDatagram)
+            {
+                sendDatagrams();
+            }
+            sendPending();
+            while(mSent < mPending.size() || mQueued > 0)
+            {
+                // Keep the reactor turning rather than blocking on this socket
+                // alone: the receiving end may be a source on the same reactor
+                mReactor->poll(1);
+                if(mDatagram)
+                {
+                    sendDatagrams();
+                }
+                sendPending();
+            }
+        }
+
+        // Writable socket with bytes left over from an earlier send
+        void onEvent(std::uint32_t) override
+        {
+            sendPending();
+        }
+
+    private:
+        void pushDatagram(std::span<const std::byte> bytes)
+        {
+            if(mQueued == mMessages.size())
+            {
+                sendDatagrams();
+                if(mQueued == mMessages.size())
+                {
+                    flush();
+                }
+            }
+            const auto size = std::min(bytes.size(), mOptions.maxDatagramSize);
+            auto* slot = mStorage.data() + mQueued * mOptions.maxDatagramSize;
+            std::memcpy(slot, bytes.data(), size);
+            mIovecs[mQueued] = iovec{slot, size};
+            mMessages[mQueued] = mmsghdr{};
+            mMessages[mQueued].msg_hdr.msg_iov = &mIovecs[mQueued];
+            mMessages[mQueued].msg_hdr.msg_iovlen = 1;
+            ++mQueued;
+            if(mQueued == mMessages.size())
+            {
+                sendDatagrams();
+            }
+        }
+
+        void sendDatagrams()
+        {
+            if(mQueued == 0)
+            {
+                return;
+            }
+            const int sent = ::sendmmsg(mSocket.fd(), mMessages.data(), static_cast<unsigned>(mQueued), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if(sent < 0)
+            {
+                if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                {
+                    return;
+                }
+                throw std::system_error(errno, std::generic_category(), "sendmmsg");
+            }
+            // Move the unsent tail to the front
+            const auto done = static_cast<std::size_t>(sent);
+            for(std::size_t i = done; i < mQueued; ++i)
+            {
+                std::memcpy(mStorage.data() + (i - done) * mOptions.maxDatagramSize, mIovecs[i].iov_base, mIovecs[i].iov_len);
+                mIovecs[i - done].iov_len = mIovecs[i].iov_len;
+                mIovecs[i - done].iov_base = mStorage.data() + (i - done) * mOptions.maxDatagramSize;
+            }
+            mQueued -= done;
+        }
+
+        void sendPending()
+        {
+            while(mSent < mPending.size())
+            {
+                const auto sent = ::send(mSocket.fd(), mPending.data() + mSent, mPending.size() - mSent, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if(sent < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if(errno != EAGAIN && errno != EWOULDBLOCK)
+                    {
+                        throw std::system_error(errno, std::generic_category(), "send");
+                    }
+                    break;
+                }
+                mSent += static_cast<std::size_t>(sent);
+            }
+            const bool drained = mSent == mPending.size();
+            if(drained)
+            {
+                mPending.clear();
+                mSent = 0;
+            }
+            if(drained == mWaitingWritable)
+            {
+                mWaitingWritable = !drained;
+                mReactor->modify(mSocket.fd(), drained ? 0u : static_cast<std::uint32_t>(EPOLLOUT), this);
+            }
+        }
+
+        std::shared_ptr<Reactor> mReactor;
+        detail::Socket mSocket;
+        SocketOptions mOptions;
+        bool mDatagram;
+        std::vector<std::byte> mPending;
+        std::size_t mSent = 0;
+        bool mWaitingWritable = false;
+        std::vector<std::byte> mStorage;
+        std::vector<iovec> mIovecs;
+        std::vector<mmsghdr> mMessages;
+        std::size_t mQueued = 0;
+    };
+
+    std::shared_ptr<State> mState;
+};
+
+inline auto makeSocketSource(std::shared_ptr<Reactor> reactor, const Endpoint& endpoint, const SocketOptions& options = {})
+{
+    return makeSource(SocketSource(std::move(reactor), endpoint, options));
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace hbreukers
+{
+
+// Bounded single producer, single consumer queue between two stage threads.
+// Each side keeps a cached copy of the other side's index, so the shared cache
+// lines are only touched when the cached view says the queue is full or empty.
+template<typename T>
+class SpscQueue
+{
+    static constexpr std::size_t cacheLine = 64;
+
+public:
+    // Capacity is rounded up to a power of two. The slots come from resource,
+    // e.g. one placing them on the NUMA node of the consumer.
+    explicit SpscQueue(std::size_t capacity, std::pmr::memory_resource* resource = std::pmr::new_delete_resource()):
+    mMask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+    mResource(resource),
+    mSlots(static_cast<Slot*>(mResource->allocate((mMask + 1) * sizeof(Slot), alignof(Slot))))
+    {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue()
+    {
+        while(!empty())
+        {
+            pop();
+        }
+        mResource->deallocate(mSlots, (mMask + 1) * sizeof(Slot), alignof(Slot));
+    }
+
+    template<typename... Args>
+    bool tryEmplace(Args&&... args)
+    {
+        const auto head = mHead.load(std::memory_order_relaxed);
+        if(head - mCachedTail > mMask)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if(head - mCachedTail > mMask)
+            {
+                return false;
+            }
+        }
+        new(&mSlots[head & mMask]) T(std::forward<Args>(args)...);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T& value)
+    {
+        return tryEmplace(value);
+    }
+
+    // The oldest element, or nullptr when empty (consumer only)
+    T* front()
+    {
+        const auto tail = mTail.load(std::memory_order_relaxed);
+        if(tail == mCachedHead)
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if(tail == mCachedHead)
+            {
+                return nullptr;
+            }
+        }
+        return std::launder(reinterpret_cast<T*>(&mSlots[tail & mMask]));
+    }
+
+    // Drops the element returned by (a non-null) front()
+    void pop()
+    {
+        const auto tail = mTail.load(std::memory_order_relaxed);
+        std::launder(reinterpret_cast<T*>(&mSlots[tail & mMask]))->~T();
+        mTail.store(tail + 1, std::memory_order_release);
+    }
+
+    // Checks from either side without updating the cached indices
+    bool empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+    bool full() const
+    {
+        return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire) > mMask;
+    }
+
+    std::size_t capacity() const
+    {
+        return mMask + 1;
+    }
+
+    // Set by the producer once it will not push anything more
+    void close()
+    {
+        mClosed.store(true, std::memory_order_release);
+    }
+
+    // Closed and drained
+    bool finished() const
+    {
+        return mClosed.load(std::memory_order_acquire) && empty();
+    }
+
+private:
+    struct Slot
+    {
+        alignas(T) std::byte mBytes[sizeof(T)];
+    };
+
+    const std::size_t mMask;
+    std::pmr::memory_resource* const mResource;
+    Slot* const mSlots;
+
+    alignas(cacheLine) std::atomic<std::size_t> mHead{0};
+    std::size_t mCachedTail = 0;
+    alignas(cacheLine) std::atomic<std::size_t> mTail{0};
+    std::size_t mCachedHead = 0;
+    alignas(cacheLine) std::atomic<bool> mClosed{false};
+};
+
+}
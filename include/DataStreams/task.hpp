@@ -0,0 +1,576 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "virtualClock.hpp"
+
+namespace hbreukers
+{
+
+class Scheduler;
+
+template<typename T>
+class Task;
+
+template<typename T>
+inline constexpr bool isTask = false;
+
+template<typename T>
+inline constexpr bool isTask<Task<T>> = true;
+
+namespace detail
+{
+
+class TaskPromiseBase
+{
+public:
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept;
+
+        void await_resume() noexcept
+        {}
+    };
+
+    FinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception()
+    {
+        mError = std::current_exception();
+    }
+
+    Scheduler* scheduler() const
+    {
+        return mScheduler;
+    }
+
+    std::coroutine_handle<> mContinuation;
+    Scheduler* mScheduler = nullptr;
+    // Spawned on a scheduler rather than awaited by another task
+    bool mDetached = false;
+    std::exception_ptr mError;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& value)
+    {
+        mValue.emplace(std::forward<U>(value));
+    }
+
+    T result()
+    {
+        if(mError)
+        {
+            std::rethrow_exception(mError);
+        }
+        return std::move(*mValue);
+    }
+
+private:
+    std::optional<T> mValue;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    Task<void> get_return_object();
+
+    void return_void()
+    {}
+
+    void result()
+    {
+        if(mError)
+        {
+            std::rethrow_exception(mError);
+        }
+    }
+};
+
+// Starts the awaited task, which resumes the awaiting one as it completes
+template<typename T>
+struct TaskAwaiter
+{
+    std::coroutine_handle<TaskPromise<T>> mHandle;
+
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> awaiting) noexcept
+    {
+        mHandle.promise().mContinuation = awaiting;
+        mHandle.promise().mScheduler = awaiting.promise().scheduler();
+        return mHandle;
+    }
+
+    T await_resume()
+    {
+        return mHandle.promise().result();
+    }
+};
+
+}
+
+// Coroutine producing a T. It starts once awaited (or spawned on a Scheduler)
+// and hands its scheduler on to the tasks it awaits in turn, which is how
+// sleepFor and Completion find the scheduler to resume them on.
+template<typename T = void>
+class [[nodiscard]] Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using ValueType = T;
+
+    explicit Task(std::coroutine_handle<promise_type> handle):
+    mHandle(handle)
+    {}
+
+    Task(Task&& other) noexcept:
+    mHandle(std::exchange(other.mHandle, {}))
+    {}
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if(this != &other)
+        {
+            reset();
+            mHandle = std::exchange(other.mHandle, {});
+        }
+        return *this;
+    }
+
+    ~Task()
+    {
+        reset();
+    }
+
+    auto operator co_await() && noexcept
+    {
+        return detail::TaskAwaiter<T>{mHandle};
+    }
+
+    // Hands the frame over, e.g. to a Scheduler
+    std::coroutine_handle<promise_type> release()
+    {
+        return std::exchange(mHandle, {});
+    }
+
+private:
+    void reset()
+    {
+        if(mHandle)
+        {
+            mHandle.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+namespace detail
+{
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+// Held by those who post to a scheduler from other threads, which may outlive
+// it; the scheduler unsets itself here as it is destroyed
+struct SchedulerLink
+{
+    std::mutex mMutex;
+    Scheduler* mScheduler = nullptr;
+};
+
+}
+
+// Resumes tasks on the thread calling runReady(): tasks spawned on it, tasks
+// whose timer expired and tasks posted by other threads. Destroying the
+// scheduler drops the tasks still pending.
+class Scheduler
+{
+    using Clock = std::chrono::steady_clock;
+
+public:
+    Scheduler():
+    mLink(std::make_shared<detail::SchedulerLink>())
+    {
+        mLink->mScheduler = this;
+    }
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    ~Scheduler()
+    {
+        {
+            std::lock_guard lock(mLink->mMutex);
+            mLink->mScheduler = nullptr;
+        }
+        for(void* const frame : mTasks)
+        {
+            std::coroutine_handle<>::from_address(frame).destroy();
+        }
+    }
+
+    // Runs task up to its first suspension and keeps it alive until it completes
+    void spawn(Task<void> task)
+    {
+        const auto handle = task.release();
+        handle.promise().mScheduler = this;
+        handle.promise().mDetached = true;
+        mTasks.insert(handle.address());
+        handle.resume();
+        rethrowFailure();
+    }
+
+    // Resumes handle on the scheduler thread; safe to call from any thread
+    void post(std::coroutine_handle<> handle)
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mPosted.push_back(handle);
+            mHasPosted.store(true, std::memory_order_release);
+        }
+        mWake.notify_one();
+    }
+
+    // Lets other threads post to the scheduler for as long as it exists
+    std::shared_ptr<detail::SchedulerLink> link() const
+    {
+        return mLink;
+    }
+
+    // Resumes handle once the clock reaches when (scheduler thread only)
+    void resumeAt(std::coroutine_handle<> handle, Clock::time_point when)
+    {
+        mTimers.push({when, mTimerSequence++, handle});
+    }
+
+    // Keeps time by clock rather than the steady clock from now on. Timers
+    // then only expire as clock is advanced, see DataStreamManager::simulate().
+    void useClock(const VirtualClock& clock)
+    {
+        mVirtualClock = &clock;
+    }
+
+    Clock::time_point now() const
+    {
+        return mVirtualClock ? mVirtualClock->now() : Clock::now();
+    }
+
+    // When the earliest timer expires, if there is one (scheduler thread only)
+    std::optional<Clock::time_point> nextTimer() const
+    {
+        if(mTimers.empty())
+        {
+            return std::nullopt;
+        }
+        return mTimers.top().mWhen;
+    }
+
+    // Resumes the posted tasks and those whose timer expired. Rethrows the
+    // first exception a spawned task ended with. Returns whether anything ran.
+    bool runReady()
+    {
+        // Called after every step of a manager, mostly with nothing to do
+        if(mTimers.empty() && !mHasPosted.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        std::vector<std::coroutine_handle<>> ready;
+        {
+            std::lock_guard lock(mMutex);
+            ready.swap(mPosted);
+            mHasPosted.store(false, std::memory_order_relaxed);
+        }
+        const auto current = now();
+        while(!mTimers.empty() && mTimers.top().mWhen <= current)
+        {
+            ready.push_back(mTimers.top().mHandle);
+            mTimers.pop();
+        }
+        for(const auto handle : ready)
+        {
+            handle.resume();
+        }
+        rethrowFailure();
+        return !ready.empty();
+    }
+
+    // Blocks until a task is posted, a timer expires or wake() is called
+    void waitForWork()
+    {
+        std::unique_lock lock(mMutex);
+        const auto idle = [&]{ return mPosted.empty() && !mWoken; };
+        // Virtual time does not pass while waiting, so only posts and wake() end the wait
+        if(mTimers.empty() || mVirtualClock)
+        {
+            mWake.wait(lock, [&]{ return !idle(); });
+        }
+        else
+        {
+            mWake.wait_until(lock, mTimers.top().mWhen, [&]{ return !idle(); });
+        }
+        mWoken = false;
+    }
+
+    void wake()
+    {
+        {
+            std::lock_guard lock(mMutex);
+            mWoken = true;
+        }
+        mWake.notify_one();
+    }
+
+    // Spawned tasks that did not complete yet
+    std::size_t pending() const
+    {
+        return mTasks.size();
+    }
+
+    // Called by a spawned task as it completes
+    void finished(std::coroutine_handle<> handle, std::exception_ptr error)
+    {
+        mTasks.erase(handle.address());
+        handle.destroy();
+        if(error && !mFailure)
+        {
+            mFailure = error;
+        }
+    }
+
+private:
+    struct Timer
+    {
+        Clock::time_point mWhen;
+        std::uint64_t mSequence;
+        std::coroutine_handle<> mHandle;
+
+        bool operator>(const Timer& other) const
+        {
+            return mWhen != other.mWhen ? mWhen > other.mWhen : mSequence > other.mSequence;
+        }
+    };
+
+    void rethrowFailure()
+    {
+        if(mFailure)
+        {
+            std::rethrow_exception(std::exchange(mFailure, {}));
+        }
+    }
+
+    // Frames of the spawned tasks
+    std::unordered_set<void*> mTasks;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> mTimers;
+    std::uint64_t mTimerSequence = 0;
+    const VirtualClock* mVirtualClock = nullptr;
+    std::exception_ptr mFailure;
+
+    std::mutex mMutex;
+    std::atomic<bool> mHasPosted{false};
+    std::condition_variable mWake;
+    std::vector<std::coroutine_handle<>> mPosted;
+    bool mWoken = false;
+    std::shared_ptr<detail::SchedulerLink> mLink;
+};
+
+namespace detail
+{
+
+template<typename Promise>
+std::coroutine_handle<> TaskPromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<Promise> handle) noexcept
+{
+    auto& promise = handle.promise();
+    if(promise.mContinuation)
+    {
+        return promise.mContinuation;
+    }
+    if(promise.mDetached)
+    {
+        promise.mScheduler->finished(handle, promise.mError);
+    }
+    return std::noop_coroutine();
+}
+
+}
+
+namespace detail
+{
+
+struct SleepAwaiter
+{
+    std::chrono::steady_clock::duration mDuration;
+
+    bool await_ready() const noexcept
+    {
+        return mDuration <= std::chrono::steady_clock::duration::zero();
+    }
+
+    template<typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> awaiting)
+    {
+        auto* scheduler = awaiting.promise().scheduler();
+        scheduler->resumeAt(awaiting, scheduler->now() + mDuration);
+    }
+
+    void await_resume() noexcept
+    {}
+};
+
+template<typename T>
+struct CompletionState
+{
+    std::mutex mMutex;
+    bool mDone = false;
+    std::optional<T> mValue;
+    std::exception_ptr mError;
+    std::coroutine_handle<> mWaiter;
+    std::shared_ptr<SchedulerLink> mScheduler;
+};
+
+template<typename T>
+struct CompletionAwaiter
+{
+    std::shared_ptr<CompletionState<T>> mState;
+
+    bool await_ready() const
+    {
+        std::lock_guard lock(mState->mMutex);
+        return mState->mDone;
+    }
+
+    template<typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> awaiting)
+    {
+        std::lock_guard lock(mState->mMutex);
+        if(mState->mDone)
+        {
+            return false;
+        }
+        mState->mWaiter = awaiting;
+        mState->mScheduler = awaiting.promise().scheduler()->link();
+        return true;
+    }
+
+    T await_resume()
+    {
+        if(mState->mError)
+        {
+            std::rethrow_exception(mState->mError);
+        }
+        return std::move(*mState->mValue);
+    }
+};
+
+}
+
+// Suspends the awaiting task for at least duration
+inline detail::SleepAwaiter sleepFor(std::chrono::steady_clock::duration duration)
+{
+    return {duration};
+}
+
+// One-shot result delivered by another thread, e.g. the reply of a lookup
+// service. Copies share the result; the awaiting task resumes on its scheduler.
+// Completing it after that scheduler was destroyed, and the awaiting task with
+// it, does nothing.
+template<typename T>
+class Completion
+{
+public:
+    Completion():
+    mState(std::make_shared<State>())
+    {}
+
+    void complete(T value)
+    {
+        finish([&](State& state){ state.mValue.emplace(std::move(value)); });
+    }
+
+    void fail(std::exception_ptr error)
+    {
+        finish([&](State& state){ state.mError = error; });
+    }
+
+    detail::CompletionAwaiter<T> operator co_await() const noexcept
+    {
+        return {mState};
+    }
+
+private:
+    using State = detail::CompletionState<T>;
+
+    template<typename F>
+    void finish(F&& set)
+    {
+        std::coroutine_handle<> waiter;
+        std::shared_ptr<detail::SchedulerLink> link;
+        {
+            std::lock_guard lock(mState->mMutex);
+            set(*mState);
+            mState->mDone = true;
+            waiter = std::exchange(mState->mWaiter, {});
+            link = std::move(mState->mScheduler);
+        }
+        if(waiter)
+        {
+            // Keeps the scheduler from being destroyed while posting to it
+            std::lock_guard lock(link->mMutex);
+            if(link->mScheduler)
+            {
+                link->mScheduler->post(waiter);
+            }
+        }
+    }
+
+    std::shared_ptr<State> mState;
+};
+
+}
@@ -0,0 +1,632 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <ranges>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../CompileTimeGraph/ctgl.hpp"
+#include "dataStream.hpp"
+#include "dataStreamManager.hpp"
+#include "eventArena.hpp"
+#include "placement.hpp"
+#include "spscQueue.hpp"
+#include "timer.hpp"
+#include "waitStrategy.hpp"
+
+namespace hbreukers
+{
+
+// Uses Strategy for the stage of Node instead of the default
+template<typename Node, typename Strategy>
+struct StageWait
+{
+    using StageNode = Node;
+    using Type = Strategy;
+};
+
+// Wait strategy of every stage: Default unless overridden by a StageWait
+template<typename Default, typename... Overrides>
+struct WaitStrategies
+{
+private:
+    template<typename Node, typename... Os>
+    struct Select
+    {
+        using type = Default;
+    };
+
+    template<typename Node, typename O, typename... Os>
+    struct Select<Node, O, Os...>
+    {
+        using type = std::conditional_t<std::is_same_v<Node, typename O::StageNode>,
+                                        typename O::Type,
+                                        typename Select<Node, Os...>::type>;
+    };
+
+public:
+    template<typename Node>
+    using For = typename Select<Node, Overrides...>::type;
+};
+
+struct ExecutorOptions
+{
+    // Elements per edge queue, rounded up to a power of two
+    std::size_t queueCapacity = 1024;
+    // CPUs, NUMA node and name of the stage threads. The queue of an edge is
+    // placed on the node of the stage consuming it. What the system refuses is
+    // left out and listed by placementFailures().
+    Placement placement;
+};
+
+// Runs every Node of program graph P on a thread of its own. Each Edge becomes
+// a bounded SpscQueue carrying copies of the values its tail emits, so views
+// (spans, string_views) must be materialised before they cross a stage. A full
+// queue holds its producer back. Idle stages wait as chosen by Waits.
+//
+// A timer thread flags the stages with an onTimer(now) hook every
+// timerInterval() and wakes them, so the hook runs on the thread of the stage
+// between two records. Stages with a finish() member call it once their
+// inputs ran dry.
+template<typename P, typename Waits, typename... StreamTypes>
+class ThreadedDataStreamManager
+{
+    static_assert(ctgl::list::empty(detail::FeedbackEdges<P>{}), "Feedback edges (cycles) are run by a DataStreamManager only");
+
+    using Store = detail::ComponentStore<P, StreamTypes...>;
+    using Edges = typename P::Edges;
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto order = Store::order;
+    static constexpr auto timedNodes = detail::timedNodesOf<Store>();
+    static constexpr std::size_t timerCount = ctgl::list::size(timedNodes);
+
+    // Type of the values Node passes on to its adjacent nodes
+    template<typename Node>
+    using Emitted = detail::EmittedType<P, std::tuple<StreamTypes...>, Node>;
+
+    template<typename... Es>
+    static auto inputOf(ctgl::List<Es...>)
+    {
+        using First = Emitted<typename std::tuple_element_t<0, std::tuple<Es...>>::Tail>;
+        static_assert((std::is_same_v<First, Emitted<typename Es::Tail>> && ...), "All inputs of a stage must carry the same type");
+        return std::type_identity<First>{};
+    }
+
+    template<typename Node>
+    using Input = typename decltype(inputOf(ctgl::graph::getIncomingEdges(P{}, Node{})))::type;
+
+    struct QueueSetup
+    {
+        std::size_t capacity;
+        std::pmr::memory_resource* resource;
+    };
+
+    // Lets the tuple of queues construct each one in place
+    template<typename T>
+    struct EdgeQueue : SpscQueue<T>
+    {
+        explicit EdgeQueue(const QueueSetup& setup):
+        SpscQueue<T>(setup.capacity, setup.resource)
+        {}
+    };
+
+    template<typename Edge>
+    static auto queueOf()
+    {
+        using T = Emitted<typename Edge::Tail>;
+        static_assert(!std::ranges::view<T>, "Values crossing stage threads are copied; a view would dangle");
+        return std::type_identity<EdgeQueue<T>>{};
+    }
+
+    template<typename... Es>
+    static auto queuesOf(ctgl::List<Es...>) -> std::tuple<typename decltype(queueOf<Es>())::type...>;
+
+    template<typename... OrderedNodes>
+    static auto waitsOf(ctgl::List<OrderedNodes...>) -> std::tuple<typename Waits::template For<OrderedNodes>...>;
+
+    using Queues = decltype(queuesOf(Edges{}));
+    using StageWaits = decltype(waitsOf(order));
+
+    // Items taken from one input before looking at the next
+    static constexpr std::size_t inputBatch = 64;
+    // Longest an idle event driven source blocks before checking for stop()
+    static constexpr std::chrono::milliseconds idleWait{1};
+
+public:
+    explicit ThreadedDataStreamManager(const ExecutorOptions& options, StreamTypes... streams):
+    ThreadedDataStreamManager(options, Edges{}, std::move(streams)...)
+    {}
+
+    ThreadedDataStreamManager(const ThreadedDataStreamManager&) = delete;
+    ThreadedDataStreamManager& operator=(const ThreadedDataStreamManager&) = delete;
+
+    // Starts a thread per stage and returns once all sources are exhausted (or
+    // stop() was called) and everything in flight drained. Rethrows the first
+    // exception a stage threw.
+    void run()
+    {
+        std::thread timers;
+        if constexpr(timerCount > 0)
+        {
+            forEach(timedNodes, [&]<typename Node>()
+            {
+                mIntervals[timerSlot<Node>()] = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::nanoseconds(component<Node>().timerInterval()));
+            });
+            mTimersStopped = false;
+            timers = std::thread([this]{ runTimers(); });
+        }
+        {
+            std::lock_guard lock(mPlacementMutex);
+            mPlacementFailures.clear();
+        }
+        std::vector<std::thread> threads;
+        ctgl::rtutil::transformList(
+            [&]<typename Node>()
+            {
+                threads.emplace_back([this]{ runStage(ctgl::Node<Node>{}); });
+            },
+            ctgl::rtutil::nodeListToList(order)
+        );
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+        if constexpr(timerCount > 0)
+        {
+            {
+                std::lock_guard lock(mTimerMutex);
+                mTimersStopped = true;
+            }
+            mTimerWake.notify_all();
+            timers.join();
+        }
+        if(mError)
+        {
+            std::rethrow_exception(mError);
+        }
+    }
+
+    // The placement requests the last run() (and the queue setup) could not
+    // apply; the stages concerned ran where the OS put them
+    std::vector<PlacementFailure> placementFailures() const
+    {
+        std::vector<PlacementFailure> failures;
+        for(const auto& [node, resource] : mNumaResources)
+        {
+            if(const auto& error = resource.bindError())
+            {
+                failures.push_back({"node " + std::to_string(node), error->what(), error->code()});
+            }
+        }
+        std::lock_guard lock(mPlacementMutex);
+        failures.insert(failures.end(), mPlacementFailures.begin(), mPlacementFailures.end());
+        return failures;
+    }
+
+    // Sources stop producing; the stages downstream finish what was emitted
+    void stop()
+    {
+        mStopped.store(true, std::memory_order_relaxed);
+        std::apply([](auto&... waits){ (waits.notify(), ...); }, mWaits);
+    }
+
+    template<typename Node>
+    auto& component()
+    {
+        return mStreamComponents.template component<Node>();
+    }
+
+private:
+    template<typename... Es>
+    ThreadedDataStreamManager(const ExecutorOptions& options, ctgl::List<Es...>, StreamTypes... streams):
+    mStreamComponents(std::move(streams)...),
+    mPlacement(options.placement),
+    mQueues(QueueSetup{options.queueCapacity, resourceOf<typename Es::Head>()}...)
+    {}
+
+    template<typename Node>
+    std::pmr::memory_resource* resourceOf()
+    {
+        const int node = mPlacement.template of<Node>().numaNode;
+        if(node < 0)
+        {
+            return std::pmr::new_delete_resource();
+        }
+        return &mNumaResources.try_emplace(node, node).first->second;
+    }
+
+    template<typename Node>
+    void runStage(Node)
+    {
+        constexpr auto incoming = ctgl::graph::getIncomingEdges(P{}, Node{});
+        constexpr int index = ctgl::list::indexOf(Node{}, order);
+        auto& stream = component<Node>();
+        try
+        {
+            if(auto failures = detail::placeCurrentThread(mPlacement.template of<Node>(), "stage-" + std::to_string(index));
+               !failures.empty())
+            {
+                std::lock_guard lock(mPlacementMutex);
+                mPlacementFailures.insert(mPlacementFailures.end(), failures.begin(), failures.end());
+            }
+            // Constructed once the thread is placed, so its pages are local
+            EventArena arena;
+            if constexpr(ctgl::list::size(incoming) == 0)
+            {
+                runSource<Node>(stream, arena);
+            }
+            else
+            {
+                runConsumer<Node>(stream, arena, incoming);
+            }
+            if constexpr(requires { stream.finish(); })
+            {
+                stream.finish();
+            }
+        }
+        catch(...)
+        {
+            {
+                std::lock_guard lock(mErrorMutex);
+                if(!mError)
+                {
+                    mError = std::current_exception();
+                }
+            }
+            stop();
+        }
+        forEach(ctgl::graph::getOutgoingEdges(P{}, Node{}), [&]<typename Edge>()
+        {
+            queue<Edge>().close();
+            waitOf<typename Edge::Head>().notify();
+        });
+    }
+
+    // Sources are pulled only once every adjacent stage has room for the
+    // value, so a source never runs ahead of its slowest consumer and emit()
+    // does not have to hold a value back
+    template<typename Node, typename Stream>
+    void runSource(Stream& stream, EventArena& arena)
+    {
+        while(!mStopped.load(std::memory_order_relaxed))
+        {
+            if constexpr(requires { stream.exhausted(); })
+            {
+                if(stream.exhausted())
+                {
+                    return;
+                }
+            }
+            waitOf<Node>().wait([&]{ return hasCredit<Node>() || mStopped.load(std::memory_order_relaxed) || timerDue<Node>(); });
+            if(mStopped.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            if(runTimer<Node>(stream, arena))
+            {
+                continue;
+            }
+            decltype(auto) val = detail::invokeUpdate(stream, arena.resource());
+            if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>)
+            {
+                if(val)
+                {
+                    emit<Node>(*val);
+                }
+                else if constexpr(requires { stream.waitReady(idleWait); })
+                {
+                    stream.waitReady(waitTimeout<Node>());
+                }
+            }
+            else
+            {
+                emit<Node>(val);
+            }
+            arena.reset();
+        }
+    }
+
+    // Every queue out of Node has a free slot
+    template<typename Node>
+    bool hasCredit()
+    {
+        bool room = true;
+        forEach(ctgl::graph::getOutgoingEdges(P{}, Node{}), [&]<typename Edge>(){ room = room && !queue<Edge>().full(); });
+        return room;
+    }
+
+    template<typename Node, typename Stream, typename Incoming>
+    void runConsumer(Stream& stream, EventArena& arena, Incoming incoming)
+    {
+        const auto ready = [&]
+        {
+            bool any = false;
+            forEach(incoming, [&]<typename Edge>(){ any = any || !queue<Edge>().empty(); });
+            return any;
+        };
+        const auto finished = [&]
+        {
+            bool all = true;
+            forEach(incoming, [&]<typename Edge>(){ all = all && queue<Edge>().finished(); });
+            return all;
+        };
+        while(true)
+        {
+            bool progressed = runTimer<Node>(stream, arena);
+            forEach(incoming, [&]<typename Edge>()
+            {
+                auto& input = queue<Edge>();
+                for(std::size_t i = 0; i < inputBatch; ++i)
+                {
+                    auto* val = input.front();
+                    if(!val)
+                    {
+                        break;
+                    }
+                    process<Node>(stream, arena, *val);
+                    input.pop();
+                    waitOf<typename Edge::Tail>().notify();
+                    progressed = true;
+                }
+            });
+            if(progressed)
+            {
+                continue;
+            }
+            if(finished())
+            {
+                return;
+            }
+            waitOf<Node>().wait([&]{ return ready() || finished() || timerDue<Node>(); });
+        }
+    }
+
+    template<typename Node>
+    static constexpr std::size_t timerSlot()
+    {
+        return static_cast<std::size_t>(ctgl::list::indexOf(Node{}, timedNodes));
+    }
+
+    template<typename Node>
+    bool timerDue() const
+    {
+        if constexpr(ctgl::list::contains(Node{}, timedNodes))
+        {
+            return mTimerDue[timerSlot<Node>()].load(std::memory_order_relaxed);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // Runs onTimer of Node if the timer thread flagged it. Returns whether it did.
+    template<typename Node, typename Stream>
+    bool runTimer([[maybe_unused]] Stream& stream, [[maybe_unused]] EventArena& arena)
+    {
+        if constexpr(ctgl::list::contains(Node{}, timedNodes))
+        {
+            if(!mTimerDue[timerSlot<Node>()].exchange(false, std::memory_order_acquire))
+            {
+                return false;
+            }
+            const auto now = Clock::now();
+            if constexpr(std::is_void_v<decltype(stream.onTimer(now))>)
+            {
+                stream.onTimer(now);
+            }
+            else
+            {
+                decltype(auto) val = stream.onTimer(now);
+                if constexpr(ctgl::list::size(ctgl::graph::getOutgoingEdges(P{}, Node{})) > 0)
+                {
+                    // Like the result of update, an optional is only unwrapped for sources
+                    if constexpr(isOptional<std::remove_cvref_t<decltype(val)>>
+                                 && ctgl::list::size(ctgl::graph::getIncomingEdges(P{}, Node{})) == 0)
+                    {
+                        if(val)
+                        {
+                            emit<Node>(*val);
+                        }
+                    }
+                    else
+                    {
+                        emit<Node>(val);
+                    }
+                }
+            }
+            arena.reset();
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // How long an idle source of Node may wait in waitReady() without running its timer late
+    template<typename Node>
+    std::chrono::nanoseconds waitTimeout() const
+    {
+        if constexpr(ctgl::list::contains(Node{}, timedNodes))
+        {
+            const Clock::time_point next(Clock::duration(mTimerNext[timerSlot<Node>()].load(std::memory_order_relaxed)));
+            return std::clamp(std::chrono::duration_cast<std::chrono::nanoseconds>(next - Clock::now()),
+                              std::chrono::nanoseconds::zero(), std::chrono::nanoseconds(idleWait));
+        }
+        else
+        {
+            return idleWait;
+        }
+    }
+
+    // Keeps the timers of the stages on a TimingWheel, flagging and waking a
+    // stage once its timer expired
+    void runTimers()
+    {
+        TimingWheel<std::uint32_t> timers(detail::timerResolution);
+        const auto schedule = [&](std::size_t slot, Clock::time_point when)
+        {
+            timers.schedule(when, static_cast<std::uint32_t>(slot));
+            mTimerNext[slot].store(when.time_since_epoch().count(), std::memory_order_relaxed);
+        };
+        const auto start = Clock::now();
+        for(std::size_t slot = 0; slot < timerCount; ++slot)
+        {
+            schedule(slot, start + mIntervals[slot]);
+        }
+        std::unique_lock lock(mTimerMutex);
+        while(!mTimersStopped)
+        {
+            mTimerWake.wait_until(lock, *timers.nextExpiry(), [&]{ return mTimersStopped; });
+            const auto now = Clock::now();
+            timers.advance(now, [&](std::uint32_t slot, Clock::time_point expiry)
+            {
+                mTimerDue[slot].store(true, std::memory_order_release);
+                forEach(timedNodes, [&]<typename Node>()
+                {
+                    if(timerSlot<Node>() == slot)
+                    {
+                        waitOf<Node>().notify();
+                    }
+                });
+                // Keeps to the period unless the stage fell behind by more than one
+                auto next = expiry + mIntervals[slot];
+                if(next <= now)
+                {
+                    next = now + mIntervals[slot];
+                }
+                schedule(slot, next);
+            });
+        }
+    }
+
+    template<typename Node, typename Stream, typename Data>
+    void process(Stream& stream, EventArena& arena, const Data& input)
+    {
+        constexpr auto outgoing = ctgl::graph::getOutgoingEdges(P{}, Node{});
+        using Tag = typename Stream::NodeTag;
+        if constexpr(std::is_same_v<Tag, FilterNodeTag>)
+        {
+            if(stream.test(input))
+            {
+                emit<Node>(input);
+            }
+        }
+        else if constexpr(std::is_same_v<Tag, RouterNodeTag>)
+        {
+            detail::forEachSelected<ctgl::list::size(outgoing)>(stream.select(input), [&]<std::size_t I>()
+            {
+                emitTo<Node, decltype(ctgl::list::at<I>(outgoing))>(input);
+            });
+        }
+        else if constexpr(std::is_same_v<Tag, FlatMapNodeTag>)
+        {
+            for(const auto& val : detail::invokeUpdate(stream, arena.resource(), input))
+            {
+                emit<Node>(val);
+            }
+        }
+        else if constexpr(ctgl::list::size(outgoing) > 0)
+        {
+            decltype(auto) val = detail::invokeUpdate(stream, arena.resource(), input);
+            static_assert(!isTask<std::remove_cvref_t<decltype(val)>>, "Processes returning a Task run on a DataStreamManager");
+            emit<Node>(val);
+        }
+        else
+        {
+            detail::invokeUpdate(stream, arena.resource(), input);
+        }
+        arena.reset();
+    }
+
+    // Pushes a copy of val to every adjacent stage, waiting while a queue is
+    // full. Once stopped, values that do not fit are dropped.
+    template<typename Node, typename Data>
+    void emit(const Data& val)
+    {
+        forEach(ctgl::graph::getOutgoingEdges(P{}, Node{}), [&]<typename Edge>()
+        {
+            emitTo<Node, Edge>(val);
+        });
+    }
+
+    template<typename Node, typename Edge, typename Data>
+    void emitTo(const Data& val)
+    {
+        auto& output = queue<Edge>();
+        if(!output.tryPush(val))
+        {
+            waitOf<Node>().wait([&]{ return !output.full() || mStopped.load(std::memory_order_relaxed); });
+            if(!output.tryPush(val))
+            {
+                return;
+            }
+        }
+        waitOf<typename Edge::Head>().notify();
+    }
+
+    template<typename Edge>
+    auto& queue()
+    {
+        constexpr int slot = ctgl::list::indexOf(Edge{}, Edges{});
+        return std::get<static_cast<std::size_t>(slot)>(mQueues);
+    }
+
+    template<typename Node>
+    auto& waitOf()
+    {
+        constexpr int slot = ctgl::list::indexOf(Node{}, order);
+        return std::get<static_cast<std::size_t>(slot)>(mWaits);
+    }
+
+    template<typename... Ts, typename F>
+    static void forEach(ctgl::List<Ts...>, F&& f)
+    {
+        (f.template operator()<Ts>(), ...);
+    }
+
+    Store mStreamComponents;
+    Placement mPlacement;
+    std::map<int, NumaResource> mNumaResources;
+    mutable std::mutex mPlacementMutex;
+    std::vector<PlacementFailure> mPlacementFailures;
+    Queues mQueues;
+    StageWaits mWaits;
+    std::atomic<bool> mStopped{false};
+    std::mutex mErrorMutex;
+    std::exception_ptr mError;
+    std::array<Clock::duration, timerCount> mIntervals{};
+    std::array<std::atomic<bool>, timerCount> mTimerDue{};
+    std::array<std::atomic<Clock::rep>, timerCount> mTimerNext{};
+    std::mutex mTimerMutex;
+    std::condition_variable mTimerWake;
+    bool mTimersStopped = false;
+};
+
+template<typename Waits = WaitStrategies<wait::SpinThenPark<>>, typename P, typename... Vars>
+auto constructThreadedDataStreamManager([[maybe_unused]]P&& program, const ExecutorOptions& options, Vars&&... vars)
+{
+    return ThreadedDataStreamManager<std::remove_cvref_t<P>, Waits, std::decay_t<Vars>...>{options, std::forward<Vars>(vars)...};
+}
+
+template<typename Waits = WaitStrategies<wait::SpinThenPark<>>, typename P, typename... Vars>
+    requires (!std::is_same_v<std::decay_t<Vars>, ExecutorOptions> && ...)
+auto constructThreadedDataStreamManager(P&& program, Vars&&... vars)
+{
+    return constructThreadedDataStreamManager<Waits>(std::forward<P>(program), ExecutorOptions{}, std::forward<Vars>(vars)...);
+}
+
+}
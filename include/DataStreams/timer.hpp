@@ -0,0 +1,275 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hbreukers
+{
+
+// Hierarchical timing wheel: Levels wheels of 2^SlotBits slots, where a slot
+// of a level spans a whole turn of the level below. An entry sits in the
+// lowest level its deadline fits in and moves down as the wheel turns, so
+// scheduling and expiring cost a constant per entry however many are
+// pending. Deadlines are rounded up to the resolution: entries expire up to
+// one resolution late, never early. Stretches without expiries are skipped
+// rather than turned through, so the wheel follows the wall clock as well as
+// a VirtualClock jumping ahead.
+template<typename Payload, std::size_t Levels = 4, std::size_t SlotBits = 6>
+class TimingWheel
+{
+    static_assert(Levels > 0 && SlotBits > 0 && Levels * SlotBits < 64, "The wheel has to count its ticks in 64 bits");
+
+    static constexpr std::size_t slots = std::size_t{1} << SlotBits;
+    static constexpr std::uint64_t mask = slots - 1;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TimingWheel(Clock::duration resolution = std::chrono::milliseconds(1)):
+    mResolution(resolution)
+    {}
+
+    // A deadline that passed already expires on the next advance()
+    void schedule(Clock::time_point when, Payload payload)
+    {
+        place(Entry{tickOf(when), mSequence++, std::move(payload)});
+        ++mSize;
+    }
+
+    // Expires the entries due by now, calling f(payload, expiry) in the order
+    // of their deadlines, ties in the order they were scheduled. f may
+    // schedule further entries; those due by now expire in this call too.
+    template<typename F>
+    void advance(Clock::time_point now, F&& f)
+    {
+        if(now.time_since_epoch() < Clock::duration::zero())
+        {
+            return;
+        }
+        const auto target = static_cast<std::uint64_t>(now.time_since_epoch() / mResolution);
+        while(mCurrent < target)
+        {
+            if(mSize == 0)
+            {
+                mCurrent = target;
+                break;
+            }
+            if(target - mCurrent > slots)
+            {
+                const auto next = earliestTick();
+                if(next > mCurrent + slots)
+                {
+                    rebase(std::min(next, target) - 1);
+                    continue;
+                }
+            }
+            turn(f);
+        }
+    }
+
+    // When the earliest entry expires, if there is one
+    std::optional<Clock::time_point> nextExpiry() const
+    {
+        if(mSize == 0)
+        {
+            return std::nullopt;
+        }
+        return Clock::time_point(mResolution * static_cast<Clock::rep>(earliestTick()));
+    }
+
+    std::size_t size() const
+    {
+        return mSize;
+    }
+
+    bool empty() const
+    {
+        return mSize == 0;
+    }
+
+private:
+    struct Entry
+    {
+        std::uint64_t mTick;
+        std::uint64_t mSequence;
+        Payload mPayload;
+    };
+
+    using Slot = std::vector<Entry>;
+
+    std::uint64_t tickOf(Clock::time_point when) const
+    {
+        const auto since = when.time_since_epoch();
+        if(since <= Clock::duration::zero())
+        {
+            return 0;
+        }
+        return static_cast<std::uint64_t>((since + mResolution - Clock::duration(1)) / mResolution);
+    }
+
+    void place(Entry entry)
+    {
+        entry.mTick = std::max(entry.mTick, mCurrent + 1);
+        const auto delta = entry.mTick - mCurrent;
+        std::size_t level = 0;
+        while(level + 1 < Levels && (delta >> (SlotBits * (level + 1))) != 0)
+        {
+            ++level;
+        }
+        mSlots[level][(entry.mTick >> (SlotBits * level)) & mask].push_back(std::move(entry));
+    }
+
+    // The first occupied slot of a level holds its earliest entries, except
+    // at the top level, which also holds deadlines beyond the range of the wheel
+    std::uint64_t earliestTick() const
+    {
+        auto earliest = std::numeric_limits<std::uint64_t>::max();
+        for(std::size_t level = 0; level < Levels; ++level)
+        {
+            const auto period = mCurrent >> (SlotBits * level);
+            for(std::uint64_t i = 1; i <= slots; ++i)
+            {
+                const auto& slot = mSlots[level][(period + i) & mask];
+                for(const auto& entry : slot)
+                {
+                    earliest = std::min(earliest, entry.mTick);
+                }
+                if(!slot.empty() && level + 1 < Levels)
+                {
+                    break;
+                }
+            }
+        }
+        return earliest;
+    }
+
+    // Moves the wheel to tick current, which no entry is due by
+    void rebase(std::uint64_t current)
+    {
+        Slot pending;
+        for(auto& level : mSlots)
+        {
+            for(auto& slot : level)
+            {
+                std::move(slot.begin(), slot.end(), std::back_inserter(pending));
+                slot.clear();
+            }
+        }
+        mCurrent = current;
+        for(auto& entry : pending)
+        {
+            place(std::move(entry));
+        }
+    }
+
+    template<typename F>
+    void turn(F& f)
+    {
+        ++mCurrent;
+        // Higher levels first, as they may move entries into a slot of a
+        // lower level that is due at this very tick
+        for(std::size_t level = Levels - 1; level > 0; --level)
+        {
+            if((mCurrent & ((std::uint64_t{1} << (SlotBits * level)) - 1)) == 0)
+            {
+                mCascading.clear();
+                mCascading.swap(mSlots[level][(mCurrent >> (SlotBits * level)) & mask]);
+                for(auto& entry : mCascading)
+                {
+                    place(std::move(entry));
+                }
+            }
+        }
+        auto& due = mSlots[0][mCurrent & mask];
+        if(due.empty())
+        {
+            return;
+        }
+        Slot expired;
+        expired.swap(due);
+        std::sort(expired.begin(), expired.end(), [](const Entry& a, const Entry& b) { return a.mSequence < b.mSequence; });
+        mSize -= expired.size();
+        const Clock::time_point expiry(mResolution * static_cast<Clock::rep>(mCurrent));
+        for(auto& entry : expired)
+        {
+            f(std::move(entry.mPayload), expiry);
+        }
+        // Hand the buffer back, unless f filled the slot meanwhile
+        if(due.empty())
+        {
+            expired.clear();
+            due.swap(expired);
+        }
+    }
+
+    Clock::duration mResolution;
+    std::array<std::array<Slot, slots>, Levels> mSlots{};
+    Slot mCascading;
+    std::uint64_t mCurrent = 0;
+    std::uint64_t mSequence = 0;
+    std::size_t mSize = 0;
+};
+
+namespace detail
+{
+
+// Timers of nodes expire up to this late
+inline constexpr std::chrono::microseconds timerResolution{100};
+
+// Streams acting on time passing (see DataStreamProcess::onTimer)
+template<typename Stream>
+concept TimedStream = requires(Stream& stream, std::chrono::steady_clock::time_point now)
+{
+    { stream.timerInterval() } -> std::convertible_to<std::chrono::nanoseconds>;
+    stream.onTimer(now);
+};
+
+}
+
+// Source emitting the time every interval, e.g. as a heartbeat or to trigger
+// periodic work downstream. It is driven by the timers of the manager, so
+// it follows the VirtualClock of a simulation as well as the wall clock.
+class TimerSource
+{
+public:
+    explicit TimerSource(std::chrono::nanoseconds interval):
+    mInterval(interval)
+    {}
+
+    // Nothing to poll, the ticks come from onTimer()
+    std::optional<std::chrono::steady_clock::time_point> operator()()
+    {
+        return std::nullopt;
+    }
+
+    // Nothing arrives between the ticks, so waiting for data is sleeping
+    bool waitReady(std::chrono::nanoseconds timeout)
+    {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    std::chrono::nanoseconds timerInterval() const
+    {
+        return mInterval;
+    }
+
+    std::chrono::steady_clock::time_point onTimer(std::chrono::steady_clock::time_point now)
+    {
+        return now;
+    }
+
+private:
+    std::chrono::nanoseconds mInterval;
+};
+
+}
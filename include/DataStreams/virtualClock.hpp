@@ -0,0 +1,33 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+
+namespace hbreukers
+{
+
+// Time of a simulation, moved on by DataStreamManager::simulate() to the
+// timestamp of each record instead of following the wall clock. Processes
+// that need the time read it from here, so replays come out the same on
+// every run. Its time points count from the epoch of the recording.
+class VirtualClock
+{
+public:
+    using duration = std::chrono::steady_clock::duration;
+    using time_point = std::chrono::steady_clock::time_point;
+
+    time_point now() const
+    {
+        return mNow;
+    }
+
+    // Never moves back, so a record older than the last one sees the time of that one
+    void advanceTo(time_point when)
+    {
+        mNow = std::max(mNow, when);
+    }
+
+private:
+    time_point mNow{};
+};
+
+}
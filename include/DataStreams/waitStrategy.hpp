@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "futex.hpp"
+
+// How an idle stage thread waits for input (or for room downstream). A
+// strategy is a per-stage object with
+//   wait(condition): returns once condition() holds
+//   notify():        called by neighbouring stages after they made progress
+// Waiting side and notifying side run on different threads.
+namespace hbreukers::wait
+{
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Never sleeps: lowest latency, at the cost of a core per stage
+class BusySpin
+{
+public:
+    template<typename Condition>
+    void wait(Condition&& condition)
+    {
+        while(!condition())
+        {
+            cpuRelax();
+        }
+    }
+
+    void notify()
+    {}
+};
+
+// Spins for a while, then parks on a futex. Notifying is a fence and a load
+// unless the stage is actually parked.
+template<unsigned Spins = 4096>
+class SpinThenPark
+{
+public:
+    template<typename Condition>
+    void wait(Condition&& condition)
+    {
+        for(unsigned spin = 0; spin < Spins; ++spin)
+        {
+            if(condition())
+            {
+                return;
+            }
+            cpuRelax();
+        }
+        while(true)
+        {
+            const auto epoch = mEpoch.load(std::memory_order_relaxed);
+            mParked.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(condition())
+            {
+                break;
+            }
+            detail::futexWait(mEpoch, epoch);
+        }
+        mParked.store(false, std::memory_order_relaxed);
+    }
+
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(mParked.load(std::memory_order_relaxed))
+        {
+            mEpoch.fetch_add(1, std::memory_order_relaxed);
+            detail::futexWake(mEpoch);
+        }
+    }
+
+private:
+    std::atomic<std::uint32_t> mEpoch{0};
+    std::atomic<bool> mParked{false};
+};
+
+// Sleeps on a condition variable straight away; for stages where latency does
+// not matter and burning CPU does
+class Blocking
+{
+public:
+    template<typename Condition>
+    void wait(Condition&& condition)
+    {
+        if(condition())
+        {
+            return;
+        }
+        mWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            std::unique_lock lock(mMutex);
+            mCondition.wait(lock, condition);
+        }
+        mWaiting.store(false, std::memory_order_relaxed);
+    }
+
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(mWaiting.load(std::memory_order_relaxed))
+        {
+            // Taking the lock orders this with the waiter's last check
+            std::lock_guard lock(mMutex);
+            mCondition.notify_one();
+        }
+    }
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::atomic<bool> mWaiting{false};
+};
+
+}
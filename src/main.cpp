@@ -1,9 +1,8 @@
 #include <iostream>
 #include "dataStream.hpp"
 #include "dataStreamManager.hpp"
-
-#include <thread>
-#include <chrono>
+#include "generator.hpp"
+#include "pipeline.hpp"
 
 using namespace hbreukers;
 
@@ -11,12 +10,13 @@ using namespace hbreukers;
 int main()
 {
     // TODO, statefull processing
-    auto source = makeSource([]()
+    auto source = makeSource([]() -> Generator<int>
         {
-            static int i =0;
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            return i++;
-        });
+            for(int i = 0; i < 10; ++i)
+            {
+                co_yield i;
+            }
+        }());
 
     auto stream = source.addDataStream<int>()
         .process([](auto&& in){return in+5;});
@@ -26,26 +26,9 @@ int main()
     auto sink2 = stream2.addDataSink([](auto&& in){std::cout<<in<<'\n';});
 
 
-    using t1 = ctgl::Node<decltype(&source)>;
-    using t2 = ctgl::Node<decltype(&stream)>;
-    using t3 = ctgl::Node<decltype(&stream2)>;
-    using t4 = ctgl::Node<decltype(&sink)>;
-    using t5 = ctgl::Node<decltype(&sink2)>;
-
-    using tasks = ctgl::List<t1, t2, t3, t4>;
-
-    using routes = ctgl::List<ctgl::Edge<t1, t2, 1>,
-                              ctgl::Edge<t1, t3, 1>,
-                              ctgl::Edge<t2, t4, 1>,
-                              ctgl::Edge<t3, t5, 1>>;
-    using program = ctgl::Graph<tasks, routes>;
-
-
     // TODO BFS vs DFS (currently DFS)
-    // TODO concurrent execution
-    // TODO think about storing by value instead of by pointer
     // TODO add concepts / customization points
-    auto manager = constructDataStreamManager(program{}, &source,&stream,&stream2,&sink,&sink2);
+    auto manager = pipeline(source, stream, stream2, sink, sink2).build();
 
     manager.run();
     return 0;
@@ -84,6 +84,49 @@ TEST(GraphTest, GetOutgoingEdges) {
     EXPECT_EQ(getOutgoingEdges(Leap{}, N3{}), List<>{});
 }
 
+// Unit tests for the ctgl::graph::getIncomingEdges() function.
+TEST(GraphTest, GetIncomingEdges) {
+    // Empty
+    EXPECT_EQ(getIncomingEdges(Empty{}, N1{}), List<>{});
+
+    // Loopback
+    EXPECT_EQ(getIncomingEdges(Loopback{}, N1{}), List<E11>{});
+
+    // Arrow
+    EXPECT_EQ(getIncomingEdges(Arrow{}, N1{}), List<>{});
+    EXPECT_EQ(getIncomingEdges(Arrow{}, N2{}), List<E12>{});
+
+    // Leap
+    EXPECT_EQ(getIncomingEdges(Leap{}, N1{}), List<>{});
+    EXPECT_EQ(getIncomingEdges(Leap{}, N2{}), List<E12>{});
+    EXPECT_EQ(getIncomingEdges(Leap{}, N3{}), (List<E23, E13>{}));
+}
+
+// Unit tests for the ctgl::graph::getSourceNodes() function.
+TEST(GraphTest, GetSourceNodes) {
+    EXPECT_EQ(getSourceNodes(Empty{}), List<>{});
+    EXPECT_EQ(getSourceNodes(Island{}), List<N1>{});
+    EXPECT_EQ(getSourceNodes(Loopback{}), List<>{});
+    EXPECT_EQ(getSourceNodes(Leap{}), List<N1>{});
+    EXPECT_EQ(getSourceNodes(Dipper{}), List<N4>{});
+}
+
+// Unit tests for the ctgl::graph::topologicalSort() function.
+TEST(GraphTest, TopologicalSort) {
+    // Acyclic
+    EXPECT_EQ(topologicalSort(Empty{}), List<>{});
+    EXPECT_EQ(topologicalSort(Island{}), List<N1>{});
+    EXPECT_EQ(topologicalSort(Arrow{}), (List<N1, N2>{}));
+    EXPECT_EQ(topologicalSort(Leap{}), (List<N1, N2, N3>{}));
+    EXPECT_EQ(topologicalSort(Pan{}), (List<N1, N4, N2, N3>{}));
+    EXPECT_EQ(topologicalSort(Bow{}), (List<N5, N7, N6>{}));
+
+    // Cyclic
+    EXPECT_EQ(topologicalSort(Loopback{}), path::DNE);
+    EXPECT_EQ(topologicalSort(Triangle{}), path::DNE);
+    EXPECT_EQ(topologicalSort(Dipper{}), path::DNE);
+}
+
 // Unit tests for the ctgl::graph::hasCycle() functions.
 TEST(GraphTest, HasCycle) {
     // Cyclic
@@ -100,6 +143,35 @@ TEST(GraphTest, HasCycle) {
     EXPECT_FALSE(hasCycle(Pan{}));
 }
 
+// Unit tests for the ctgl::graph::getBackEdges() function.
+TEST(GraphTest, GetBackEdges) {
+    // Cyclic
+    EXPECT_EQ(getBackEdges(Loopback{}), List<E11>{});
+    EXPECT_EQ(getBackEdges(Bridge{}), List<E21>{});
+    EXPECT_EQ(getBackEdges(Triangle{}), List<E31>{});
+    EXPECT_EQ(getBackEdges(Dipper{}), List<E31>{});
+
+    // Acyclic
+    EXPECT_EQ(getBackEdges(Empty{}), List<>{});
+    EXPECT_EQ(getBackEdges(Leap{}), List<>{});
+    EXPECT_EQ(getBackEdges(Pan{}), List<>{});
+    EXPECT_EQ(getBackEdges(Bow{}), List<>{});
+}
+
+// Unit tests for the ctgl::graph::FeedbackEdge type.
+TEST(GraphTest, FeedbackEdge) {
+    using F21 = FeedbackEdge<N2, N1, 1>;
+    using Marked = Graph<List<N1, N2>, List<E12, F21>>;
+    EXPECT_TRUE(F21::feedback);
+    EXPECT_FALSE(E21::feedback);
+
+    // Traversed like any other Edge
+    EXPECT_EQ(getAdjacentNodes(Marked{}, N2{}), List<N1>{});
+    EXPECT_EQ(getOutgoingEdges(Marked{}, N2{}), List<F21>{});
+    EXPECT_TRUE(hasCycle(Marked{}));
+    EXPECT_EQ(getBackEdges(Marked{}), List<F21>{});
+}
+
 // Unit tests for the ctgl::graph::hasNegativeCycle() functions.
 TEST(GraphTest, HasNegativeCycle) {
     // Negative Cyclic
@@ -1,5 +1,6 @@
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 #include <gtest/gtest.h>
 
@@ -49,6 +50,13 @@ TEST(ListTest, Front) {
     EXPECT_EQ(front(List<int, float, double>{}), int{});
 }
 
+// Unit tests for the ctgl::list::at() function.
+TEST(ListTest, At) {
+    EXPECT_TRUE((std::is_same_v<decltype(at<0>(List<int>{})), int>));
+    EXPECT_TRUE((std::is_same_v<decltype(at<0>(List<int, float, double>{})), int>));
+    EXPECT_TRUE((std::is_same_v<decltype(at<2>(List<int, float, double>{})), double>));
+}
+
 // Unit tests for the ctgl::list::contains() function.
 TEST(ListTest, Contains) {
     // Empty
@@ -63,6 +71,20 @@ TEST(ListTest, Contains) {
     EXPECT_FALSE(contains(bool{}, List<int, float, double>{}));
 }
 
+// Unit tests for the ctgl::list::indexOf() function.
+TEST(ListTest, IndexOf) {
+    // Empty
+    EXPECT_EQ(indexOf(int{}, List<>{}), -1);
+
+    // Found
+    EXPECT_EQ(indexOf(int{}, List<int>{}), 0);
+    EXPECT_EQ(indexOf(bool{}, List<int, bool>{}), 1);
+    EXPECT_EQ(indexOf(int{}, List<float, int, int>{}), 1);
+
+    // Not Found
+    EXPECT_EQ(indexOf(bool{}, List<int, float, double>{}), -1);
+}
+
 // Unit tests for the ctgl::list::unique() function.
 TEST(ListTest, Unique) {
     // Empty
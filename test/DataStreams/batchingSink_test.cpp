@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/batchingSink.hpp"
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/runtimeDataStreamManager.hpp"
+#include "../../include/DataStreams/threadedDataStreamManager.hpp"
+#include "../../include/DataStreams/virtualClock.hpp"
+
+using namespace hbreukers;
+using namespace std::chrono_literals;
+
+namespace {
+    // Emits 1..count
+    struct Counter {
+        std::int64_t count;
+        std::int64_t next = 1;
+
+        std::optional<std::int64_t> operator()() {
+            if (next > count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+
+        bool exhausted() const {
+            return next > count;
+        }
+    };
+
+    // Counter taking a millisecond per record
+    struct SlowCounter : Counter {
+        std::optional<std::int64_t> operator()() {
+            std::this_thread::sleep_for(1ms);
+            return Counter::operator()();
+        }
+    };
+
+    struct Event {
+        std::chrono::milliseconds time;
+        int value;
+    };
+
+    // Replays recorded events
+    struct Recording {
+        std::vector<Event> events;
+        std::size_t next = 0;
+
+        std::optional<Event> operator()() {
+            if (next == events.size()) {
+                return std::nullopt;
+            }
+            return events[next++];
+        }
+
+        bool exhausted() const {
+            return next == events.size();
+        }
+    };
+}
+
+// Unit tests for batches handed on once full, and the partial one at the end of a run.
+TEST(BatchingSinkTest, Size) {
+    auto source = makeSource(Counter{1000});
+    std::vector<std::size_t> sizes;
+    std::int64_t sum = 0;
+    const std::int64_t* buffer = nullptr;
+    bool reused = true;
+    auto batcher = batched<std::int64_t>([&](std::span<const std::int64_t> batch) {
+        sizes.push_back(batch.size());
+        for (const auto in : batch) {
+            sum += in;
+        }
+        reused = reused && (buffer == nullptr || buffer == batch.data());
+        buffer = batch.data();
+    }, 64, 1s);
+    auto sink = source.addDataSink(batcher);
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    manager.run();
+
+    ASSERT_EQ(sizes.size(), 16u);
+    EXPECT_EQ(sizes.front(), 64u);
+    EXPECT_EQ(sizes.back(), 1000u - 15 * 64);
+    EXPECT_EQ(sum, 1000 * 1001 / 2);
+    EXPECT_TRUE(reused);
+
+    // The copy held by the manager keeps the stats
+    EXPECT_EQ(batcher.stats().batches, 0u);
+    const auto& stats = manager.component<t2>().function().stats();
+    EXPECT_EQ(stats.batches, 16u);
+    EXPECT_EQ(stats.records, 1000u);
+    EXPECT_EQ(stats.full, 15u);
+    EXPECT_EQ(stats.largest, 64u);
+    EXPECT_DOUBLE_EQ(stats.averageSize(), 62.5);
+}
+
+// Unit tests for batches handed on once their latency passed.
+TEST(BatchingSinkTest, Latency) {
+    VirtualClock clock;
+    auto source = makeSource(Recording{{{100ms, 1}, {101ms, 2}, {102ms, 3}, {150ms, 4}, {151ms, 5}}});
+    std::vector<std::pair<std::size_t, std::chrono::milliseconds>> batches;
+    auto sink = source.addDataSink(batched<Event>([&](std::span<const Event> batch) {
+        batches.emplace_back(batch.size(), std::chrono::duration_cast<std::chrono::milliseconds>(clock.now().time_since_epoch()));
+    }, 100, 10ms));
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    manager.simulate(clock, [](const Event& event) { return event.time; });
+
+    // The timer runs from the first record; the last batch leaves as the run ends
+    const std::vector<std::pair<std::size_t, std::chrono::milliseconds>> expected{{3, 110ms}, {2, 151ms}};
+    EXPECT_EQ(batches, expected);
+}
+
+// Unit tests for sink edges built from the same adapter batching on their own.
+TEST(BatchingSinkTest, PerEdge) {
+    auto source = makeSource(Counter{10});
+    std::vector<std::size_t> sizes;
+    const auto batcher = batched<std::int64_t>([&](std::span<const std::int64_t> batch) { sizes.push_back(batch.size()); }, 4);
+    auto every = source.addDataSink(batcher);
+    auto odd = source.filter([](std::int64_t in) { return in % 2 == 1; });
+    auto oddSink = odd.addDataSink(batcher);
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(every)>;
+    using t3 = ctgl::Node<decltype(odd)>;
+    using t4 = ctgl::Node<std::integral_constant<int, 4>>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t1, t3, 1>, ctgl::Edge<t3, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, every, odd, oddSink);
+    manager.run();
+
+    EXPECT_EQ(manager.component<t2>().function().stats().records, 10u);
+    EXPECT_EQ(manager.component<t2>().function().stats().batches, 3u);
+    EXPECT_EQ(manager.component<t4>().function().stats().records, 5u);
+    EXPECT_EQ(manager.component<t4>().function().stats().batches, 2u);
+    EXPECT_EQ(sizes.size(), 5u);
+}
+
+// Unit tests for batching sinks on the threaded and runtime managers.
+TEST(BatchingSinkTest, Executors) {
+    std::int64_t sum = 0;
+    std::size_t batches = 0;
+    const auto add = [&](std::span<const std::int64_t> batch) {
+        ++batches;
+        for (const auto in : batch) {
+            sum += in;
+        }
+    };
+
+    // Size only, which needs no timers
+    auto counter = makeSource(Counter{100});
+    auto sizeOnly = counter.addDataSink(batched<std::int64_t>(add, 32));
+    static_assert(!detail::TimedStream<decltype(sizeOnly)>);
+    RuntimeDataStreamManager runtime;
+    runtime.add(sizeOnly, runtime.addSource(counter));
+    runtime.run();
+    EXPECT_EQ(sum, 100 * 101 / 2);
+    EXPECT_EQ(batches, 4u);
+
+    // A slow source, so that the latency rather than the size ends batches
+    sum = 0;
+    batches = 0;
+    auto slow = makeSource(SlowCounter{{20}});
+    auto sink = slow.addDataSink(batched<std::int64_t>(add, 1000, 5ms));
+    using t1 = ctgl::Node<decltype(slow)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructThreadedDataStreamManager(program{}, slow, sink);
+    manager.run();
+    EXPECT_EQ(sum, 20 * 21 / 2);
+    EXPECT_GT(batches, 1u);
+    EXPECT_EQ(manager.component<t2>().function().stats().full, 0u);
+}
@@ -0,0 +1,206 @@
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "../../include/DataStreams/checkpoint.hpp"
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/mappedFileSource.hpp"
+#include "../../include/DataStreams/task.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    std::string tempPath(const std::string& name) {
+        const auto path = (std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string();
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    std::string writeRecords(const std::string& name, std::int64_t count) {
+        const auto path = tempPath(name);
+        std::ofstream out(path, std::ios::binary);
+        for (std::int64_t i = 1; i <= count; ++i) {
+            out.write(reinterpret_cast<const char*>(&i), sizeof(i));
+        }
+        return path;
+    }
+
+    // Stateful sink taking part in checkpoints
+    struct Summer {
+        std::int64_t* result;
+        std::int64_t sum = 0;
+        std::vector<std::int64_t> batchSizes;
+        // Restores the sum only, as an older version of the state would
+        bool sumOnly = false;
+
+        void operator()(std::span<const std::int64_t> batch) {
+            for (const auto value : batch) {
+                sum += value;
+            }
+            batchSizes.push_back(static_cast<std::int64_t>(batch.size()));
+            *result = sum;
+        }
+
+        void snapshot(CheckpointWriter& writer) const {
+            writer.write(sum);
+            writer.write(batchSizes);
+        }
+
+        void restore(CheckpointReader& reader) {
+            reader.read(sum);
+            if (!sumOnly) {
+                reader.read(batchSizes);
+            }
+            *result = sum;
+        }
+    };
+
+    auto makeManager(const std::string& records, std::int64_t& result, bool sumOnly = false) {
+        auto source = makeMappedRecordSource<std::int64_t>(records, 10);
+        auto sink = source.addDataSink(Summer{&result, 0, {}, sumOnly});
+        using t1 = ctgl::Node<decltype(source)>;
+        using t2 = ctgl::Node<decltype(sink)>;
+        using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+        return constructDataStreamManager(program{}, source, sink);
+    }
+}
+
+// Unit tests for the CheckpointWriter and CheckpointReader types.
+TEST(CheckpointTest, WriterReader) {
+    CheckpointWriter writer;
+    writer.write(std::uint32_t{7});
+    const auto block = writer.beginBlock();
+    writer.write(std::string("state"));
+    writer.write(std::vector<double>{1.5, 2.5});
+    writer.endBlock(block);
+    writer.write(std::int8_t{-1});
+
+    CheckpointReader reader(writer.bytes());
+    EXPECT_EQ(reader.read<std::uint32_t>(), 7u);
+    auto inner = reader.block();
+    EXPECT_EQ(inner.read<std::string>(), "state");
+    EXPECT_EQ(inner.read<std::vector<double>>(), (std::vector<double>{1.5, 2.5}));
+    EXPECT_TRUE(inner.empty());
+    EXPECT_EQ(reader.read<std::int8_t>(), -1);
+    EXPECT_THROW(reader.read<std::int8_t>(), std::runtime_error);
+}
+
+// Unit tests for restarting a graph from a checkpoint.
+TEST(CheckpointTest, Restart) {
+    const auto records = writeRecords("creek_checkpoint_records", 1000);
+    const auto path = tempPath("creek_checkpoint_restart");
+    {
+        std::int64_t result = 0;
+        auto manager = makeManager(records, result);
+        for (int i = 0; i < 40; ++i) {
+            manager.step();
+        }
+        EXPECT_EQ(result, 400 * 401 / 2);
+        Checkpointer checkpointer(path);
+        checkpointer.checkpoint(manager);
+        checkpointer.wait();
+        // Progress after the checkpoint is lost in the crash
+        manager.step();
+    }
+
+    std::int64_t result = 0;
+    auto manager = makeManager(records, result);
+    Checkpointer checkpointer(path);
+    ASSERT_TRUE(checkpointer.restore(manager));
+    EXPECT_EQ(result, 400 * 401 / 2);
+    manager.run();
+    EXPECT_EQ(result, 1000 * 1001 / 2);
+    std::filesystem::remove(records);
+    std::filesystem::remove(path);
+}
+
+// Unit tests for periodic checkpoints taken by run().
+TEST(CheckpointTest, Periodic) {
+    const auto records = writeRecords("creek_checkpoint_periodic_records", 1000);
+    const auto path = tempPath("creek_checkpoint_periodic");
+    {
+        std::int64_t result = 0;
+        auto manager = makeManager(records, result);
+        Checkpointer checkpointer(path, CheckpointOptions{std::chrono::milliseconds(0)});
+        EXPECT_FALSE(checkpointer.restore(manager));
+        manager.run(checkpointer);
+        checkpointer.wait();
+    }
+
+    // The final checkpoint has the source at its end
+    std::int64_t result = 0;
+    auto manager = makeManager(records, result);
+    ASSERT_TRUE(Checkpointer(path).restore(manager));
+    EXPECT_TRUE(manager.exhausted());
+    EXPECT_EQ(result, 1000 * 1001 / 2);
+    std::filesystem::remove(records);
+    std::filesystem::remove(path);
+}
+
+// Unit tests for rejecting checkpoints of another graph.
+TEST(CheckpointTest, Mismatch) {
+    const auto records = writeRecords("creek_checkpoint_mismatch", 10);
+    auto source = makeMappedRecordSource<std::int64_t>(records);
+    using t1 = ctgl::Node<decltype(source)>;
+    using program = ctgl::Graph<ctgl::List<t1>, ctgl::List<>>;
+    auto single = constructDataStreamManager(program{}, source);
+    CheckpointWriter writer;
+    single.snapshot(writer);
+
+    std::int64_t result = 0;
+    auto manager = makeManager(records, result);
+    CheckpointReader reader(writer.bytes());
+    EXPECT_THROW(manager.restore(reader), std::runtime_error);
+
+    // Same number of components, but other types
+    auto other = makeMappedRecordSource<std::int64_t>(records);
+    auto sink = other.addDataSink([](std::span<const std::int64_t>){});
+    using o1 = ctgl::Node<decltype(other)>;
+    using o2 = ctgl::Node<decltype(sink)>;
+    using otherProgram = ctgl::Graph<ctgl::List<o1, o2>, ctgl::List<ctgl::Edge<o1, o2, 1>>>;
+    auto otherManager = constructDataStreamManager(otherProgram{}, other, sink);
+    writer.clear();
+    otherManager.snapshot(writer);
+    CheckpointReader otherReader(writer.bytes());
+    EXPECT_THROW(manager.restore(otherReader), std::runtime_error);
+
+    // State left unread in a block
+    writer.clear();
+    manager.step();
+    manager.snapshot(writer);
+    auto partial = makeManager(records, result, true);
+    CheckpointReader partialReader(writer.bytes());
+    EXPECT_THROW(partial.restore(partialReader), std::runtime_error);
+    CheckpointReader fullReader(writer.bytes());
+    EXPECT_NO_THROW(makeManager(records, result).restore(fullReader));
+    std::filesystem::remove(records);
+}
+
+// Unit tests for refusing snapshots while a task is in flight.
+TEST(CheckpointTest, InFlight) {
+    const auto records = writeRecords("creek_checkpoint_inflight", 10);
+    auto source = makeMappedRecordSource<std::int64_t>(records, 10);
+    auto sink = source.addDataSink([](std::span<const std::int64_t>) -> Task<void> {
+        co_await sleepFor(std::chrono::hours(1));
+    });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    CheckpointWriter writer;
+    EXPECT_NO_THROW(manager.snapshot(writer));
+    manager.step();
+    // The source already moved past the batch the task still works on
+    writer.clear();
+    EXPECT_THROW(manager.snapshot(writer), std::logic_error);
+    std::filesystem::remove(records);
+}
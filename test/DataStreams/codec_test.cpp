@@ -0,0 +1,125 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/codec.hpp"
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    enum class Side : std::uint8_t { Bid, Ask };
+
+    struct Tick {
+        std::uint64_t timestamp;
+        double price;
+        std::uint32_t quantity;
+        Side side;
+        bool operator==(const Tick&) const = default;
+    };
+
+    struct Packed {
+        std::uint32_t a;
+        std::uint32_t b;
+        bool operator==(const Packed&) const = default;
+    };
+
+    struct Book {
+        Tick best;
+        std::array<std::int16_t, 3> levels;
+        Packed packed;
+        bool operator==(const Book&) const = default;
+    };
+
+    struct Flagged {
+        std::uint8_t id;
+        bool set;
+    };
+
+    const Tick tick{1700000000123456789ull, 101.25, 0x01020304u, Side::Ask};
+}
+
+// Unit tests for the compile-time layout.
+TEST(CodecTest, Layout) {
+    static_assert(codec::encodedSize<Tick> == 21);
+    static_assert(codec::fieldOffset<Tick, 2> == 16);
+    static_assert(codec::encodedSize<Book> == 21 + 6 + 8);
+    static_assert(codec::fieldOffset<Book, 2> == 27);
+    static_assert(!codec::bitwise<Tick>);
+    static_assert(codec::bitwise<Packed> == (std::endian::native == std::endian::little));
+
+    // Little-endian quantity right after the two 8 byte fields
+    const auto bytes = codec::encode(tick);
+    EXPECT_EQ(bytes[16], std::byte{0x04});
+    EXPECT_EQ(bytes[19], std::byte{0x01});
+    EXPECT_EQ(bytes[20], std::byte{1});
+}
+
+// Unit tests for encoding and decoding nested records.
+TEST(CodecTest, RoundTrip) {
+    const Book book{tick, {-1, 2, -3}, {7, 8}};
+    std::vector<std::byte> buffer(codec::encodedSize<Book> + 3);
+    codec::encode(book, buffer);
+    EXPECT_EQ(codec::decode<Book>(buffer), book);
+    EXPECT_EQ(codec::decode<Tick>(codec::encode(tick)), tick);
+    EXPECT_THROW(codec::encode(book, std::span<std::byte>(buffer).first(10)), std::length_error);
+    EXPECT_THROW(codec::decode<Book>(std::span<const std::byte>(buffer).first(10)), std::length_error);
+}
+
+// Unit tests for decoding bools from bytes other than 0 and 1.
+TEST(CodecTest, Bool) {
+    static_assert(!codec::bitwise<Flagged>);
+    const std::array<std::byte, 2> bytes{std::byte{0x05}, std::byte{0x02}};
+    const auto flagged = codec::decode<Flagged>(bytes);
+    EXPECT_EQ(flagged.id, 5u);
+    EXPECT_TRUE(flagged.set);
+    EXPECT_TRUE(codec::decode<bool>(std::span<const std::byte>(bytes).last(1)));
+    EXPECT_FALSE(codec::decode<bool>(codec::encode(false)));
+    EXPECT_EQ(codec::encode(Flagged{5, true})[1], std::byte{1});
+}
+
+// Unit tests for reading fields in place.
+TEST(CodecTest, Views) {
+    std::vector<std::byte> buffer;
+    for (std::uint32_t i = 0; i < 10; ++i) {
+        const Book book{{i, 0.5 * i, i * 10, Side::Bid}, {1, 2, 3}, {i, i}};
+        const auto bytes = codec::encode(book);
+        buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+    }
+    buffer.push_back(std::byte{0});
+
+    const codec::Views<Book> books(buffer);
+    ASSERT_EQ(books.size(), 10u);
+    EXPECT_EQ(books[3].get<0>().get<2>(), 30u);
+    EXPECT_EQ(books[4].get<0>().get<1>(), 2.0);
+    EXPECT_EQ(books[5].get<1>(), (std::array<std::int16_t, 3>{1, 2, 3}));
+    EXPECT_EQ(books[6].get<2>().value(), (Packed{6, 6}));
+    EXPECT_EQ(books[9].value().best.timestamp, 9u);
+}
+
+// Unit tests for encoder and decoder processes in a graph.
+TEST(CodecTest, Graph) {
+    auto source = makeSource([i = std::uint64_t{0}]() mutable { ++i; return Tick{i, 1.5, 2, Side::Bid}; });
+    auto encode = source.process(codec::encoder<Tick>());
+    auto decode = encode.process(codec::decoder<Tick>());
+    std::vector<Tick> received;
+    auto sink = decode.addDataSink([&](const Tick& t) { received.push_back(t); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(encode)>;
+    using t3 = ctgl::Node<decltype(decode)>;
+    using t4 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t3, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, encode, decode, sink);
+    for (int i = 0; i < 3; ++i) {
+        manager.step();
+    }
+    EXPECT_EQ(received, (std::vector<Tick>{{1, 1.5, 2, Side::Bid}, {2, 1.5, 2, Side::Bid}, {3, 1.5, 2, Side::Bid}}));
+}
@@ -0,0 +1,104 @@
+#include <span>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/columnBatch.hpp"
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/numeric.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    struct Tick {
+        long timestamp;
+        std::string symbol;
+        double price;
+        int size;
+    };
+
+    ColumnBatch<Tick> makeBatch() {
+        ColumnBatch<Tick> batch;
+        batch.push_back({1, "AAA", 10.0, 5});
+        batch.push_back({2, "BBB", 20.0, 7});
+        batch.push_back({3, "AAA", 30.0, 9});
+        return batch;
+    }
+}
+
+// Unit tests for the aggregate field helpers.
+TEST(ColumnBatchTest, Aggregate) {
+    static_assert(aggregate::fieldCount<Tick> == 4);
+    static_assert(std::is_same_v<aggregate::Fields<Tick>, std::tuple<long, std::string, double, int>>);
+
+    Tick tick{1, "AAA", 2.0, 3};
+    std::get<2>(aggregate::tie(tick)) = 4.0;
+    EXPECT_EQ(tick.price, 4.0);
+}
+
+// Unit tests for the ColumnBatch layout.
+TEST(ColumnBatchTest, Columns) {
+    auto batch = makeBatch();
+    EXPECT_EQ(batch.columns(), 4u);
+    EXPECT_EQ(batch.size(), 3u);
+
+    const auto prices = batch.column<2>();
+    EXPECT_EQ(std::vector<double>(prices.begin(), prices.end()), (std::vector<double>{10.0, 20.0, 30.0}));
+
+    const auto tick = batch.record(1);
+    EXPECT_EQ(tick.symbol, "BBB");
+    EXPECT_EQ(tick.size, 7);
+
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+}
+
+// Unit tests for the columnar operators inside a DataStream graph.
+TEST(ColumnBatchTest, Operators) {
+    double total = 0.0;
+    auto source = makeSource([]{ return ColumnBatch<Tick>{}; });
+    auto selected = source.addDataStream<ColumnBatch<Tick>>()
+        .process(columnar::filter<1, Tick>([](const std::string& symbol){ return symbol == "AAA"; }));
+    auto prices = selected.addDataStream<SelectedRows<Tick>>()
+        .process(columnar::project<2, Tick>());
+    auto sum = prices.addDataStream<double>()
+        .process(numeric::reduceSum<double>());
+    auto sink = sum.addDataSink([&](double in){ total = in; });
+
+    using t1 = ctgl::Node<decltype(&source)>;
+    using t2 = ctgl::Node<decltype(&selected)>;
+    using t3 = ctgl::Node<decltype(&prices)>;
+    using t4 = ctgl::Node<decltype(&sum)>;
+    using t5 = ctgl::Node<decltype(&sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>,
+                                           ctgl::Edge<t3, t4, 1>,
+                                           ctgl::Edge<t4, t5, 1>>>;
+    auto manager = constructDataStreamManager(program{}, &source, &selected, &prices, &sum, &sink);
+
+    manager.processNode(t2{}, program{}, makeBatch());
+    EXPECT_DOUBLE_EQ(total, 40.0);
+}
+
+// Unit tests for SelectedRows viewing a batch in place.
+TEST(ColumnBatchTest, SelectedRows) {
+    const auto batch = makeBatch();
+    auto filter = columnar::filter<2, Tick>([](double price){ return price > 15.0; });
+    const auto selection = filter(batch);
+    EXPECT_EQ(&selection.batch(), &batch);
+    ASSERT_EQ(selection.size(), 2u);
+    EXPECT_EQ(selection.value<1>(0), "BBB");
+    EXPECT_EQ(selection.record(1).size, 9);
+
+    auto sizes = columnar::project<3, Tick>();
+    const auto selected = sizes(selection);
+    EXPECT_EQ(std::vector<int>(selected.begin(), selected.end()), (std::vector<int>{7, 9}));
+
+    ColumnBatch<Tick> copy;
+    selection.materialize(copy);
+    EXPECT_EQ(copy.size(), 2u);
+    EXPECT_EQ(copy.record(0).timestamp, 2);
+}
@@ -0,0 +1,19 @@
+#include "../../../include/DataStreams/dataStream.hpp"
+#include "../../../include/DataStreams/dataStreamManager.hpp"
+
+using namespace hbreukers;
+
+// Two nodes feeding each other
+int main() {
+    auto source = makeSource([] { return 1; });
+    auto first = source.process([](int in) { return in + 1; });
+    auto second = first.process([](int in) { return in * 2; });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(first)>;
+    using t3 = ctgl::Node<decltype(second)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t3, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, first, second);
+    (void)manager;
+}
@@ -0,0 +1,18 @@
+#include <string>
+
+#include "../../../include/DataStreams/dataStream.hpp"
+#include "../../../include/DataStreams/dataStreamManager.hpp"
+
+using namespace hbreukers;
+
+// A node taking strings fed with integers
+int main() {
+    auto source = makeSource([] { return 1; });
+    auto text = source.filter([](const std::string& in) { return in.empty(); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(text)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, text);
+    (void)manager;
+}
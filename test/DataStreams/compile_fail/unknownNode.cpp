@@ -0,0 +1,16 @@
+#include "../../../include/DataStreams/dataStream.hpp"
+#include "../../../include/DataStreams/dataStreamManager.hpp"
+
+using namespace hbreukers;
+
+// An edge to a node left out of the Nodes of the graph
+int main() {
+    auto source = makeSource([] { return 1; });
+    auto sink = source.addDataSink([](int) {});
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source);
+    (void)manager;
+}
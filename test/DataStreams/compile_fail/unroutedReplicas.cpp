@@ -0,0 +1,14 @@
+#include "../../../include/DataStreams/dataStream.hpp"
+#include "../../../include/DataStreams/pipeline.hpp"
+
+using namespace hbreukers;
+
+// Replicas fed by a plain stream instead of a partitionBy router
+int main() {
+    auto source = makeSource([] { return 1; });
+    auto doubled = source.process([](int in) { return in * 2; });
+    auto gather = doubled.addDataSink([](int) {});
+
+    auto manager = pipeline(source, replicated<2>(doubled), gather).build();
+    (void)manager;
+}
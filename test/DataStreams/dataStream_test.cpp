@@ -0,0 +1,230 @@
+#include <bitset>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+
+using namespace hbreukers;
+
+// Unit tests for the filter node kind.
+TEST(DataStreamTest, Filter) {
+    std::vector<int> seen;
+    int mapped = 0;
+    auto source = makeSource([]{ return 0; });
+    auto even = source.addDataStream<int>()
+        .filter([](int in){ return in % 2 == 0; });
+    auto stream = even.addDataStream<int>()
+        .process([&](int in){ ++mapped; return in + 1; });
+    auto sink = stream.addDataSink([&](int in){ seen.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(&source)>;
+    using t2 = ctgl::Node<decltype(&even)>;
+    using t3 = ctgl::Node<decltype(&stream)>;
+    using t4 = ctgl::Node<decltype(&sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>,
+                                           ctgl::Edge<t3, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, &source, &even, &stream, &sink);
+
+    for(int i = 0; i < 6; ++i)
+    {
+        manager.processNode(t2{}, program{}, i);
+    }
+
+    // Rejected records never reach the downstream process
+    EXPECT_EQ(mapped, 3);
+    EXPECT_EQ(seen, (std::vector<int>{1, 3, 5}));
+}
+
+// Unit tests for the flatMap node kind.
+TEST(DataStreamTest, FlatMap) {
+    std::vector<int> seen;
+    auto source = makeSource([]{ return 0; });
+    auto split = source.addDataStream<int>()
+        .flatMap<4>([](int in, auto& out)
+        {
+            for(int i = 0; i < in; ++i)
+            {
+                out.push(in * 10 + i);
+            }
+        });
+    auto sink = split.addDataSink([&](int in){ seen.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(&source)>;
+    using t2 = ctgl::Node<decltype(&split)>;
+    using t3 = ctgl::Node<decltype(&sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>>>;
+    auto manager = constructDataStreamManager(program{}, &source, &split, &sink);
+
+    manager.processNode(t2{}, program{}, 0);
+    manager.processNode(t2{}, program{}, 2);
+    // Values beyond the buffer capacity are dropped and counted
+    manager.processNode(t2{}, program{}, 5);
+
+    EXPECT_EQ(seen, (std::vector<int>{20, 21, 50, 51, 52, 53}));
+    EXPECT_EQ(split.overflowed(), 1u);
+}
+
+// Unit tests for stages taking the type their upstream actually emits.
+TEST(DataStreamTest, ChainedTypes) {
+    std::vector<double> seen;
+    auto source = makeSource([]{ return 0; });
+    auto half = source.process([](int in) { return in / 2.0; });
+    auto split = half.flatMap<4>([](double in, auto& out) {
+        out.push(in);
+        out.push(in + 0.25);
+    });
+    auto sink = split.addDataSink([&](double in) { seen.push_back(in); });
+    static_assert(std::is_same_v<decltype(split)::Buffer, SmallBuffer<double, 4>>);
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(half)>;
+    using t3 = ctgl::Node<decltype(split)>;
+    using t4 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>,
+                                           ctgl::Edge<t3, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, half, split, sink);
+
+    manager.processNode(t2{}, program{}, 3);
+    EXPECT_EQ(seen, (std::vector<double>{1.5, 1.75}));
+}
+
+// Unit tests for the router node kind.
+TEST(DataStreamTest, Router) {
+    std::vector<int> evens;
+    std::vector<int> odds;
+    int evaluated = 0;
+    auto source = makeSource([]{ return 0; });
+    // Branch 2 does not exist, so negative values are dropped
+    auto parity = source.route([](int in) { return in < 0 ? 2 : in % 2; });
+    auto even = parity.process([&](int in) { ++evaluated; return in; });
+    auto odd = parity.process([&](int in) { ++evaluated; return in; });
+    auto evenSink = even.addDataSink([&](int in) { evens.push_back(in); });
+    auto oddSink = odd.addDataSink([&](int in) { odds.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(parity)>;
+    using t3 = ctgl::Node<decltype(even)>;
+    using t4 = ctgl::Node<decltype(odd)>;
+    using t5 = ctgl::Node<decltype(evenSink)>;
+    using t6 = ctgl::Node<decltype(oddSink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5, t6>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t2, t4, 1>,
+                   ctgl::Edge<t3, t5, 1>, ctgl::Edge<t4, t6, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, parity, even, odd, evenSink, oddSink);
+
+    for(int i = -1; i < 5; ++i)
+    {
+        manager.processNode(t2{}, program{}, i);
+    }
+    EXPECT_EQ(evens, (std::vector<int>{0, 2, 4}));
+    EXPECT_EQ(odds, (std::vector<int>{1, 3}));
+    // The branch not taken is never evaluated
+    EXPECT_EQ(evaluated, 5);
+
+    // A bitset selects several branches
+    std::vector<int> all;
+    auto fanOut = source.route([](int in) { return std::bitset<2>(static_cast<unsigned long long>(in)); });
+    auto first = fanOut.addDataSink([&](int in) { all.push_back(in); });
+    auto second = fanOut.addDataSink([&](int in) { all.push_back(-in); });
+    using f1 = ctgl::Node<decltype(fanOut)>;
+    using f2 = ctgl::Node<decltype(first)>;
+    using f3 = ctgl::Node<decltype(second)>;
+    using fanProgram = ctgl::Graph<ctgl::List<t1, f1, f2, f3>,
+        ctgl::List<ctgl::Edge<t1, f1, 1>, ctgl::Edge<f1, f2, 1>, ctgl::Edge<f1, f3, 1>>>;
+    auto fanManager = constructDataStreamManager(fanProgram{}, source, fanOut, first, second);
+    for(int i = 0; i < 4; ++i)
+    {
+        fanManager.processNode(f1{}, fanProgram{}, i);
+    }
+    EXPECT_EQ(all, (std::vector<int>{1, -2, 3, -3}));
+}
+
+// Unit tests for the SmallBuffer type.
+TEST(DataStreamTest, SmallBuffer) {
+    SmallBuffer<std::vector<int>, 2> buffer;
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.emplace(3, 1));
+    EXPECT_TRUE(buffer.push(std::vector<int>{2}));
+    EXPECT_TRUE(buffer.full());
+    EXPECT_FALSE(buffer.push(std::vector<int>{}));
+    EXPECT_EQ(buffer[0], (std::vector<int>{1, 1, 1}));
+    buffer.clear();
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.overflowed(), 1u);
+}
+
+// Unit tests for the per-event arena handed to processes.
+TEST(DataStreamTest, EventArena) {
+    std::vector<std::string> seen;
+    std::pmr::memory_resource* used = nullptr;
+    auto source = makeSource([]{ return 0; });
+    auto stream = source.addDataStream<std::pmr::string>()
+        .process([&](int in, std::pmr::memory_resource* resource)
+        {
+            used = resource;
+            return std::pmr::string(static_cast<std::size_t>(in), 'x', resource);
+        });
+    auto sink = stream.addDataSink([&](const std::pmr::string& in)
+        {
+            EXPECT_EQ(in.get_allocator().resource(), used);
+            seen.emplace_back(in);
+        });
+
+    using t1 = ctgl::Node<decltype(&source)>;
+    using t2 = ctgl::Node<decltype(&stream)>;
+    using t3 = ctgl::Node<decltype(&sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>>>;
+    auto manager = constructDataStreamManager(program{}, &source, &stream, &sink);
+
+    manager.processNode(t2{}, program{}, 40);
+    manager.arena().reset();
+    manager.processNode(t2{}, program{}, 3);
+
+    EXPECT_EQ(used, manager.arena().resource());
+    EXPECT_EQ(seen, (std::vector<std::string>{std::string(40, 'x'), "xxx"}));
+}
+
+// Unit tests for components owned by value, including nodes sharing a type.
+TEST(DataStreamTest, ComponentsByValue) {
+    std::vector<int> seen;
+    auto source = makeSource([i = 0]() mutable { return i++; });
+    const auto addOne = [](int in){ return in + 1; };
+    const auto collect = [&](int in){ seen.push_back(in); };
+    auto left = source.addDataStream<int>().process(addOne);
+    auto right = source.addDataStream<int>().process(addOne);
+    auto leftSink = left.addDataSink(collect);
+    auto rightSink = right.addDataSink(collect);
+    static_assert(std::is_same_v<decltype(left), decltype(right)>);
+    static_assert(std::is_same_v<decltype(leftSink), decltype(rightSink)>);
+
+    // Nodes only identify the components by position, so any tag will do
+    using t1 = ctgl::Node<std::integral_constant<int, 1>>;
+    using t2 = ctgl::Node<std::integral_constant<int, 2>>;
+    using t3 = ctgl::Node<std::integral_constant<int, 3>>;
+    using t4 = ctgl::Node<std::integral_constant<int, 4>>;
+    using t5 = ctgl::Node<std::integral_constant<int, 5>>;
+    // Declared out of execution order on purpose
+    using program = ctgl::Graph<ctgl::List<t4, t2, t1, t5, t3>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t1, t3, 1>,
+                                           ctgl::Edge<t2, t4, 1>,
+                                           ctgl::Edge<t3, t5, 1>>>;
+    auto manager = constructDataStreamManager(program{}, leftSink, left, source, rightSink, right);
+
+    manager.step();
+    manager.step();
+
+    EXPECT_EQ(seen, (std::vector<int>{1, 1, 2, 2}));
+}
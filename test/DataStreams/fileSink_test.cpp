@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/fileSink.hpp"
+#include "../../include/DataStreams/mappedFileSource.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    std::string tempPath(const std::string& name) {
+        return (std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string();
+    }
+
+    std::vector<std::int64_t> readInts(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        const std::vector<char> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        std::vector<std::int64_t> values(bytes.size() / sizeof(std::int64_t));
+        std::memcpy(values.data(), bytes.data(), values.size() * sizeof(std::int64_t));
+        return values;
+    }
+
+    void writeInts(const std::string& path, const FileSinkOptions& options) {
+        FileSink sink(path, options);
+        for (std::int64_t i = 0; i < 5000; ++i) {
+            sink(i);
+        }
+    }
+
+    std::vector<std::int64_t> expectedInts() {
+        std::vector<std::int64_t> values(5000);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<std::int64_t>(i);
+        }
+        return values;
+    }
+}
+
+// Unit tests for the pwrite thread backend.
+TEST(FileSinkTest, ThreadBackend) {
+    const auto path = tempPath("creek_sink_thread");
+    FileSinkOptions options;
+    options.flushSize = 4096;
+    options.backend = WriteBackend::Thread;
+    options.fsync = FsyncPolicy::OnFlush;
+    writeInts(path, options);
+    EXPECT_EQ(readInts(path), expectedInts());
+    std::filesystem::remove(path);
+}
+
+// Unit tests for the io_uring backend.
+TEST(FileSinkTest, IoUringBackend) {
+    const auto path = tempPath("creek_sink_uring");
+    FileSinkOptions options;
+    options.flushSize = 4096;
+    options.backend = WriteBackend::IoUring;
+    options.fsync = FsyncPolicy::OnFlush;
+    try {
+        writeInts(path, options);
+    } catch (const std::system_error& error) {
+        std::filesystem::remove(path);
+        GTEST_SKIP() << "io_uring unavailable: " << error.what();
+    }
+    EXPECT_EQ(readInts(path), expectedInts());
+    std::filesystem::remove(path);
+}
+
+// Unit tests for framed records read back by MappedFrameSource.
+TEST(FileSinkTest, Framed) {
+    const auto path = tempPath("creek_sink_framed");
+    {
+        FileSinkOptions options;
+        options.framed = true;
+        FileSink sink(path, options);
+        sink(std::string("abc"));
+        sink(std::string(""));
+        // Larger than a buffer
+        sink(std::string(10000, 'x'));
+    }
+    MappedFrameSource source(path);
+    std::vector<std::size_t> sizes;
+    while (const auto frame = source()) {
+        sizes.push_back(frame->size());
+    }
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{3, 0, 10000}));
+    std::filesystem::remove(path);
+}
+
+// Unit tests for the FileSink inside a DataStream graph.
+TEST(FileSinkTest, Graph) {
+    const auto path = tempPath("creek_sink_graph");
+    {
+        auto source = makeSource([i = std::int64_t{0}]() mutable -> std::optional<std::int64_t>
+            {
+                if (i == 5000) {
+                    return std::nullopt;
+                }
+                return i++;
+            });
+        auto sink = source.addDataSink(FileSink(path));
+
+        using t1 = ctgl::Node<decltype(source)>;
+        using t2 = ctgl::Node<decltype(sink)>;
+        using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+        auto manager = constructDataStreamManager(program{}, source, sink);
+        for (int i = 0; i < 6000; ++i) {
+            manager.step();
+        }
+    }
+    EXPECT_EQ(readInts(path), expectedInts());
+    std::filesystem::remove(path);
+}
+
+// Unit tests for write errors reported by close().
+TEST(FileSinkTest, Close) {
+    FileSinkOptions options;
+    options.backend = WriteBackend::Thread;
+    options.fsync = FsyncPolicy::Never;
+    FileSink sink("/dev/full", options);
+    sink(std::int64_t{1});
+    EXPECT_THROW(sink.close(), std::system_error);
+    // Closing twice is harmless, appending afterwards is not
+    EXPECT_NO_THROW(sink.close());
+    EXPECT_THROW(sink(std::int64_t{2}), std::logic_error);
+
+    // A failed io_uring write does not escape the destructor
+    options.backend = WriteBackend::IoUring;
+    try {
+        FileSink uring("/dev/full", options);
+        uring(std::int64_t{1});
+    } catch (const std::system_error& error) {
+        GTEST_SKIP() << "io_uring unavailable: " << error.what();
+    }
+}
+
+// Unit tests for a failed write, which is not retried later.
+TEST(FileSinkTest, FailedFlush) {
+    FileSinkOptions options;
+    options.backend = WriteBackend::Thread;
+    options.fsync = FsyncPolicy::Never;
+    options.flushSize = sizeof(std::int64_t);
+    FileSink sink("/dev/full", options);
+    // The first buffer only fails once the second one has to wait for it
+    sink(std::int64_t{1});
+    EXPECT_THROW(sink(std::int64_t{2}), std::system_error);
+    EXPECT_THROW(sink(std::int64_t{3}), std::system_error);
+    EXPECT_THROW(sink.close(), std::system_error);
+    EXPECT_NO_THROW(sink.close());
+}
+
+// Unit tests for the flush interval kept by the manager's timer.
+TEST(FileSinkTest, FlushInterval) {
+    const auto path = tempPath("creek_sink_interval");
+    FileSinkOptions options;
+    options.flushInterval = std::chrono::milliseconds(1);
+    auto source = makeSource([sent = false]() mutable -> std::optional<std::int64_t>
+        {
+            if (sent) {
+                return std::nullopt;
+            }
+            sent = true;
+            return 7;
+        });
+    auto sink = source.addDataSink(FileSink(path, options));
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    // No further record arrives to push the first one out
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (std::filesystem::file_size(path) == 0 && std::chrono::steady_clock::now() < deadline) {
+        manager.step();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(readInts(path), (std::vector<std::int64_t>{7}));
+    std::filesystem::remove(path);
+}
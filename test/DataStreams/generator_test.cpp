@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/generator.hpp"
+#include "../../include/DataStreams/threadedDataStreamManager.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    Generator<int> count(int from, int to) {
+        for (int i = from; i <= to; ++i) {
+            co_yield i;
+        }
+    }
+
+    // Has a record every period; waitReady sleeps until then
+    struct Ticker {
+        Ticker(std::chrono::steady_clock::duration every, int count, int* pollCount, int* waitCount)
+            : period(every), ticks(count), polls(pollCount), waits(waitCount) {}
+
+        std::chrono::steady_clock::duration period;
+        int ticks;
+        int* polls;
+        int* waits;
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + period;
+        int emitted = 0;
+
+        std::optional<int> operator()() {
+            ++*polls;
+            if (std::chrono::steady_clock::now() < next) {
+                return std::nullopt;
+            }
+            next += period;
+            return emitted++;
+        }
+
+        bool waitReady(std::chrono::nanoseconds timeout) {
+            ++*waits;
+            std::this_thread::sleep_until(std::min(next, std::chrono::steady_clock::now() + timeout));
+            return std::chrono::steady_clock::now() >= next;
+        }
+
+        bool exhausted() const {
+            return emitted == ticks;
+        }
+    };
+}
+
+// Unit tests for the Generator type.
+TEST(GeneratorTest, Generator) {
+    auto numbers = count(1, 3);
+    auto copy = numbers;
+    EXPECT_FALSE(numbers.exhausted());
+    EXPECT_EQ(numbers(), 1);
+    // Copies share the coroutine
+    EXPECT_EQ(copy(), 2);
+    EXPECT_EQ(numbers(), 3);
+    EXPECT_EQ(numbers(), std::nullopt);
+    EXPECT_TRUE(numbers.exhausted());
+    EXPECT_EQ(numbers(), std::nullopt);
+
+    auto failing = []() -> Generator<int> {
+        co_yield 1;
+        throw std::runtime_error("source failed");
+    }();
+    EXPECT_EQ(failing(), 1);
+    EXPECT_THROW(failing(), std::runtime_error);
+    EXPECT_TRUE(failing.exhausted());
+}
+
+// Unit tests for generators as sources of a DataStreamManager.
+TEST(GeneratorTest, Source) {
+    auto source = makeSource(count(1, 100));
+    int sum = 0;
+    auto sink = source.addDataSink([&](int in) { sum += in; });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    manager.run();
+    EXPECT_EQ(sum, 5050);
+}
+
+// Unit tests for sources pulled only when downstream has room.
+TEST(GeneratorTest, Demand) {
+    std::atomic<int> produced = 0;
+    std::atomic<int> consumed = 0;
+    int maxAhead = 0;
+    auto source = makeSource([](std::atomic<int>& counter) -> Generator<int> {
+        for (int i = 0; i < 2000; ++i) {
+            ++counter;
+            co_yield i;
+        }
+    }(produced));
+    auto sink = source.addDataSink([&](int) {
+        maxAhead = std::max(maxAhead, produced.load() - consumed.load());
+        ++consumed;
+        if (consumed % 100 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    ExecutorOptions options;
+    options.queueCapacity = 8;
+    auto manager = constructThreadedDataStreamManager(program{}, options, source, sink);
+    manager.run();
+    EXPECT_EQ(consumed, 2000);
+    // The record being consumed, the full queue and nothing more
+    EXPECT_LE(maxAhead, 9);
+}
+
+// Unit tests for event driven sources waiting instead of being polled.
+TEST(GeneratorTest, WaitReady) {
+    int polls = 0;
+    int waits = 0;
+    auto source = makeSource(Ticker(std::chrono::milliseconds(2), 10, &polls, &waits));
+    int received = 0;
+    auto sink = source.addDataSink([&](int in) { EXPECT_EQ(in, received++); });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    manager.run();
+    EXPECT_EQ(received, 10);
+    EXPECT_GT(waits, 0);
+    // Polling in a loop for 20ms would take far more calls
+    EXPECT_LE(polls, 10 + waits);
+}
@@ -0,0 +1,102 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/mappedFileSource.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    struct Tick {
+        std::int64_t timestamp;
+        double price;
+    };
+
+    // Tests run in processes of their own, possibly in parallel
+    std::string writeFile(const std::string& name, const void* data, std::size_t size) {
+        const auto path = (std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        return path;
+    }
+}
+
+// Unit tests for the MappedRecordSource type.
+TEST(MappedFileSourceTest, Records) {
+    std::vector<Tick> ticks;
+    for (std::int64_t i = 0; i < 10; ++i) {
+        ticks.push_back({i, static_cast<double>(i) * 0.5});
+    }
+    const auto path = writeFile("creek_records", ticks.data(), ticks.size() * sizeof(Tick));
+
+    MappedRecordSource<Tick> source(path, 4);
+    std::vector<std::size_t> sizes;
+    double total = 0.0;
+    while (const auto batch = source()) {
+        sizes.push_back(batch->size());
+        for (const auto& tick : *batch) {
+            total += tick.price;
+        }
+    }
+    EXPECT_TRUE(source.exhausted());
+    EXPECT_EQ(sizes, (std::vector<std::size_t>{4, 4, 2}));
+    EXPECT_DOUBLE_EQ(total, 22.5);
+
+    source.seek(9);
+    EXPECT_EQ(source()->front().timestamp, 9);
+
+    // Empty batches would never move through the file
+    EXPECT_THROW(MappedRecordSource<Tick>(path, 0), std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+// Unit tests for the MappedFrameSource type.
+TEST(MappedFileSourceTest, Frames) {
+    const unsigned char bytes[] = {3, 0, 0, 0, 'a', 'b', 'c', 0, 0, 0, 0, 1, 0, 0, 0, 'd', 5, 0, 0, 0, 'e'};
+    const auto path = writeFile("creek_frames", bytes, sizeof(bytes));
+
+    MappedFrameSource source(path);
+    std::vector<std::string> frames;
+    while (const auto frame = source()) {
+        frames.emplace_back(reinterpret_cast<const char*>(frame->data()), frame->size());
+    }
+    // The truncated trailing frame is ignored
+    EXPECT_EQ(frames, (std::vector<std::string>{"abc", "", "d"}));
+    EXPECT_TRUE(source.exhausted());
+    std::filesystem::remove(path);
+}
+
+// Unit tests for replaying a mapped file through a DataStream graph.
+TEST(MappedFileSourceTest, Replay) {
+    std::vector<Tick> ticks{{1, 1.0}, {2, 2.0}, {3, 3.0}};
+    const auto path = writeFile("creek_replay", ticks.data(), ticks.size() * sizeof(Tick));
+
+    std::vector<std::int64_t> seen;
+    auto source = makeMappedRecordSource<Tick>(path);
+    auto sink = source.addDataSink([&](std::span<const Tick> batch)
+        {
+            for (const auto& tick : batch) {
+                seen.push_back(tick.timestamp);
+            }
+        });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+
+    // Returns once the file has been replayed
+    manager.run();
+    EXPECT_EQ(seen, (std::vector<std::int64_t>{1, 2, 3}));
+    std::filesystem::remove(path);
+}
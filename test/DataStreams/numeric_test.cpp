@@ -0,0 +1,101 @@
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/numeric.hpp"
+
+using namespace hbreukers;
+
+#if defined(HBREUKERS_NO_SIMD) && defined(HBREUKERS_HAS_SIMD)
+#error "HBREUKERS_NO_SIMD has to select the scalar kernels"
+#endif
+
+namespace {
+    // Sizes that exercise both the vector body and the scalar tail.
+    template <typename T>
+    std::vector<T> iota(std::size_t n, T start) {
+        std::vector<T> values(n);
+        std::iota(values.begin(), values.end(), start);
+        return values;
+    }
+}
+
+// Unit tests for the numeric::kernel::affine() function.
+TEST(NumericTest, Affine) {
+    for (std::size_t n : {0u, 1u, 7u, 16u, 37u}) {
+        const auto in = iota<float>(n, -3.f);
+        std::vector<float> out(n);
+        numeric::kernel::affine(in.data(), out.data(), n, 2.f, 1.f);
+        for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_FLOAT_EQ(out[i], 2.f * in[i] + 1.f);
+        }
+    }
+}
+
+// Unit tests for the numeric::kernel::filterRange() function.
+TEST(NumericTest, FilterRange) {
+    const auto in = iota<int>(37, -10);
+    std::vector<int> out(in.size());
+    const auto count = numeric::kernel::filterRange(in.data(), out.data(), in.size(), -2, 20);
+    out.resize(count);
+    EXPECT_EQ(out, iota<int>(23, -2));
+}
+
+// Unit tests for the numeric::kernel reductions.
+TEST(NumericTest, Reduce) {
+    const auto in = iota<double>(37, -5.0);
+    EXPECT_DOUBLE_EQ(numeric::kernel::sum(in.data(), in.size()), std::accumulate(in.begin(), in.end(), 0.0));
+    EXPECT_DOUBLE_EQ(numeric::kernel::min(in.data(), in.size()), -5.0);
+    EXPECT_DOUBLE_EQ(numeric::kernel::max(in.data(), in.size()), 31.0);
+    EXPECT_EQ(numeric::kernel::max(in.data(), 3), -3.0);
+    // The kernels return their seed for no values, the operators nothing
+    EXPECT_EQ(numeric::kernel::min(in.data(), 0), std::numeric_limits<double>::infinity());
+    EXPECT_EQ(numeric::kernel::max(in.data(), 0), -std::numeric_limits<double>::infinity());
+    EXPECT_EQ(numeric::reduceMin<double>()(in), std::optional<double>(-5.0));
+    EXPECT_EQ(numeric::reduceMax<double>()(in), std::optional<double>(31.0));
+    EXPECT_EQ(numeric::reduceMin<double>()(std::span<const double>{}), std::nullopt);
+    EXPECT_EQ(numeric::reduceMax<int>()(std::span<const int>{}), std::nullopt);
+}
+
+// Unit tests for the numeric::kernel::inclusiveScan() function.
+TEST(NumericTest, InclusiveScan) {
+    const auto in = iota<int>(9, 1);
+    std::vector<int> out(in.size());
+    numeric::kernel::inclusiveScan(in.data(), out.data(), in.size());
+    EXPECT_EQ(out, (std::vector<int>{1, 3, 6, 10, 15, 21, 28, 36, 45}));
+}
+
+// Unit tests for the numeric operators inside a DataStream graph.
+TEST(NumericTest, Operators) {
+    float total = 0.f;
+    auto source = makeSource([]{ return std::span<const float>{}; });
+    auto scaled = source.addDataStream<std::span<const float>>()
+        .process(numeric::mapAffine(2.f, 0.f));
+    auto bounded = scaled.addDataStream<std::span<const float>>()
+        .process(numeric::filterRange(0.f, 10.f));
+    auto sum = bounded.addDataStream<float>()
+        .process(numeric::reduceSum<float>());
+    auto sink = sum.addDataSink([&](float in){ total = in; });
+
+    using t1 = ctgl::Node<decltype(&source)>;
+    using t2 = ctgl::Node<decltype(&scaled)>;
+    using t3 = ctgl::Node<decltype(&bounded)>;
+    using t4 = ctgl::Node<decltype(&sum)>;
+    using t5 = ctgl::Node<decltype(&sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+                                ctgl::List<ctgl::Edge<t1, t2, 1>,
+                                           ctgl::Edge<t2, t3, 1>,
+                                           ctgl::Edge<t3, t4, 1>,
+                                           ctgl::Edge<t4, t5, 1>>>;
+    auto manager = constructDataStreamManager(program{}, &source, &scaled, &bounded, &sum, &sink);
+
+    const auto batch = iota<float>(20, -4.f);
+    manager.processNode(t2{}, program{}, std::span<const float>(batch));
+    EXPECT_FLOAT_EQ(total, 0.f + 2.f + 4.f + 6.f + 8.f + 10.f);
+}
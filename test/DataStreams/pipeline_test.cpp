@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/pipeline.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    // Emits 1..count
+    struct Counter {
+        std::int64_t count;
+        std::int64_t next = 1;
+
+        std::optional<std::int64_t> operator()() {
+            if (next > count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+
+        bool exhausted() const {
+            return next > count;
+        }
+    };
+}
+
+// Unit tests for the program graph derived from the streams.
+TEST(PipelineTest, Program) {
+    auto source = makeSource(Counter{10});
+    auto stream = source.addDataStream<std::int64_t>().process([](std::int64_t in) { return in + 5; });
+    auto stream2 = source.addDataStream<std::int64_t>().process([](std::int64_t in) { return in * 3; });
+    auto sink = stream.addDataSink([](std::int64_t) {});
+    auto sink2 = stream2.addDataSink([](std::int64_t) {});
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(stream)>;
+    using t3 = ctgl::Node<decltype(stream2)>;
+    using t4 = ctgl::Node<decltype(sink)>;
+    using t5 = ctgl::Node<decltype(sink2)>;
+    using expected = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t1, t3, 1>, ctgl::Edge<t2, t4, 1>, ctgl::Edge<t3, t5, 1>>>;
+    static_assert(std::is_same_v<ProgramOf<decltype(source), decltype(stream), decltype(stream2), decltype(sink), decltype(sink2)>, expected>);
+    static_assert(std::is_void_v<decltype(source)::Upstream>);
+    static_assert(std::is_same_v<decltype(sink)::Upstream, decltype(stream)>);
+}
+
+// Unit tests for building a manager from chained streams.
+TEST(PipelineTest, Build) {
+    auto source = makeSource(Counter{100});
+    auto doubled = source.process([](std::int64_t in) { return in * 2; });
+    auto multiples = doubled.filter([](std::int64_t in) { return in % 4 == 0; });
+    auto twice = multiples.flatMap<2>([](std::int64_t in, auto& out) { out.push(in); out.push(in); });
+    std::vector<std::int64_t> received;
+    auto sink = twice.addDataSink([&](std::int64_t in) { received.push_back(in); });
+
+    // Added out of order; the graph comes from the types
+    auto manager = pipeline(sink, twice).add(source, multiples).add(doubled).build();
+    manager.run();
+    ASSERT_EQ(received.size(), 100u);
+    EXPECT_EQ(received[0], 4);
+    EXPECT_EQ(received[1], 4);
+    EXPECT_EQ(received[99], 200);
+}
+
+// Unit tests for building a threaded manager.
+TEST(PipelineTest, BuildThreaded) {
+    auto source = makeSource(Counter{1000});
+    auto squared = source.process([](std::int64_t in) { return in * in; });
+    std::int64_t sum = 0;
+    auto sink = squared.addDataSink([&](std::int64_t in) { sum += in; });
+    ExecutorOptions options;
+    options.queueCapacity = 16;
+    auto manager = pipeline(source, squared, sink).buildThreaded(options);
+    manager.run();
+    EXPECT_EQ(sum, 1000 * 1001 * 2001 / 6);
+}
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/port.hpp"
+#include "../../include/DataStreams/threadedDataStreamManager.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    // Emits 1, 2, 3, ... without end
+    struct Endless {
+        std::int64_t next = 1;
+
+        std::int64_t operator()() {
+            return next++;
+        }
+    };
+}
+
+// Unit tests for attaching to and detaching from a port between steps.
+TEST(PortTest, Subscribe) {
+    Port<std::int64_t> port;
+    auto source = makeSource(Endless{});
+    auto tap = source.process(port);
+    std::vector<std::int64_t> received;
+    auto sink = tap.addDataSink([&](std::int64_t in) { received.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(tap)>;
+    using t3 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>, ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, tap, sink);
+
+    manager.step();
+    std::vector<std::int64_t> tapped;
+    auto subscription = port.subscribe([&](std::int64_t in) { tapped.push_back(in); });
+    EXPECT_EQ(port.subscribers(), 1u);
+    manager.step();
+    manager.step();
+    subscription.detach();
+    EXPECT_FALSE(subscription);
+    EXPECT_EQ(port.subscribers(), 0u);
+    manager.step();
+
+    EXPECT_EQ(tapped, (std::vector<std::int64_t>{2, 3}));
+    // The compiled path is unaffected by subscribers coming and going
+    EXPECT_EQ(received, (std::vector<std::int64_t>{1, 2, 3, 4}));
+
+    Port<int, 1> small;
+    auto first = small.subscribe([](int) {});
+    EXPECT_THROW((void)small.subscribe([](int) {}), std::length_error);
+    first.detach();
+    EXPECT_NO_THROW((void)small.subscribe([](int) {}));
+}
+
+// Unit tests for tapping a pipeline while it runs.
+TEST(PortTest, LiveTap) {
+    Port<std::int64_t> port;
+    auto source = makeSource(Endless{});
+    auto tap = source.process(port);
+    std::atomic<std::int64_t> sunk = 0;
+    auto sink = tap.addDataSink([&](std::int64_t) { ++sunk; });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(tap)>;
+    using t3 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>, ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>>>;
+    ExecutorOptions options;
+    options.queueCapacity = 64;
+    auto manager = constructThreadedDataStreamManager(program{}, options, source, tap, sink);
+    std::thread runner([&] { manager.run(); });
+
+    for (int session = 0; session < 3; ++session) {
+        std::atomic<int> count = 0;
+        std::atomic<bool> ordered = true;
+        std::int64_t last = 0;
+        auto subscription = port.subscribe([&](std::int64_t in) {
+            if (last != 0 && in != last + 1) {
+                ordered = false;
+            }
+            last = in;
+            ++count;
+        });
+        while (count < 100) {
+            std::this_thread::yield();
+        }
+        subscription.detach();
+        // Nothing reaches a detached subscriber
+        const int seen = count;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        EXPECT_EQ(count, seen);
+        EXPECT_TRUE(ordered);
+    }
+
+    manager.stop();
+    runner.join();
+    EXPECT_GT(sunk, 300);
+}
@@ -0,0 +1,51 @@
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/programValidation.hpp"
+
+using namespace hbreukers;
+
+// Unit tests for the types flowing along the edges of a program graph.
+TEST(ProgramValidationTest, EmittedType) {
+    auto source = makeSource([] { return 1; });
+    auto text = source.process([](int in) { return std::to_string(in); });
+    auto nonEmpty = text.filter([](const std::string& in) { return !in.empty(); });
+    auto letters = nonEmpty.addDataStream<char>().flatMap<4>([](const std::string& in, auto& out) { out.push(in.front()); });
+    auto sink = letters.addDataSink([](char) {});
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(text)>;
+    using t3 = ctgl::Node<decltype(nonEmpty)>;
+    using t4 = ctgl::Node<decltype(letters)>;
+    using t5 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t3, t4, 1>, ctgl::Edge<t4, t5, 1>>>;
+    using Components = std::tuple<decltype(source), decltype(text), decltype(nonEmpty), decltype(letters), decltype(sink)>;
+
+    static_assert(std::is_same_v<detail::EmittedType<program, Components, t1>, int>);
+    static_assert(std::is_same_v<detail::EmittedType<program, Components, t2>, std::string>);
+    static_assert(std::is_same_v<detail::EmittedType<program, Components, t3>, std::string>);
+    static_assert(std::is_same_v<detail::EmittedType<program, Components, t4>, char>);
+    static_assert(detail::validProgram<program, decltype(source), decltype(text), decltype(nonEmpty), decltype(letters), decltype(sink)>);
+    // Components handed over as pointers
+    static_assert(detail::validProgram<program, decltype(source)*, decltype(text), decltype(nonEmpty)*, decltype(letters), decltype(sink)>);
+}
+
+// Unit tests for the checks on the inputs of nodes.
+TEST(ProgramValidationTest, AcceptsInput) {
+    auto source = makeSource([] { return 1; });
+    auto number = source.process([](int in) { return in; });
+    auto text = source.filter([](const std::string& in) { return in.empty(); });
+
+    static_assert(detail::isSourceStream<decltype(source)>());
+    static_assert(!detail::isSourceStream<decltype(number)>());
+    static_assert(detail::acceptsInput<decltype(number), int>());
+    static_assert(!detail::acceptsInput<decltype(number), std::string>());
+    static_assert(detail::acceptsInput<decltype(text), std::string>());
+    static_assert(!detail::acceptsInput<decltype(text), int>());
+}
@@ -0,0 +1,129 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/runtimeDataStreamManager.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    // Emits 1..count
+    struct Counter {
+        std::int64_t count;
+        std::int64_t next = 1;
+
+        std::optional<std::int64_t> operator()() {
+            if (next > count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+
+        bool exhausted() const {
+            return next > count;
+        }
+    };
+}
+
+// Unit tests for a pipeline with every node kind, checked against DataStreamManager.
+TEST(RuntimeDataStreamManagerTest, Pipeline) {
+    auto source = makeSource(Counter{100});
+    auto doubled = source.process([](std::int64_t in) { return in * 2; });
+    auto multiples = doubled.filter([](std::int64_t in) { return in % 4 == 0; });
+    auto twice = multiples.flatMap<2>([](std::int64_t in, auto& out) { out.push(in); out.push(in + 1); });
+    std::vector<std::int64_t> expected;
+    std::vector<std::int64_t> received;
+    auto sink = twice.addDataSink([&](std::int64_t in) { received.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(doubled)>;
+    using t3 = ctgl::Node<decltype(multiples)>;
+    using t4 = ctgl::Node<decltype(twice)>;
+    using t5 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t3, t4, 1>, ctgl::Edge<t4, t5, 1>>>;
+    auto compiled = constructDataStreamManager(program{}, source, doubled, multiples, twice, sink);
+    compiled.run();
+    expected.swap(received);
+
+    RuntimeDataStreamManager manager;
+    auto a = manager.addSource(source);
+    auto b = manager.add(doubled, a);
+    auto c = manager.add(multiples, b);
+    auto d = manager.add(twice, c);
+    manager.add(sink, d);
+    manager.run();
+    EXPECT_EQ(received, expected);
+    EXPECT_EQ(manager.component(a).exhausted(), true);
+}
+
+// Unit tests for nodes with several inputs and outputs.
+TEST(RuntimeDataStreamManagerTest, Diamond) {
+    auto source = makeSource(Counter{3});
+    auto plus = source.process([](std::int64_t in) { return in + 10; });
+    auto times = source.process([](std::int64_t in) { return in * 10; });
+    auto text = plus.process([](std::int64_t in) { return std::to_string(in); });
+    std::vector<std::string> received;
+    auto sink = text.addDataSink([&](const std::string& in) { received.push_back(in); });
+
+    RuntimeDataStreamManager manager;
+    auto s = manager.addSource(source);
+    auto p = manager.add(plus, s);
+    auto t = manager.add(times, s);
+    auto x = manager.add(text, p);
+    manager.connect(t, x);
+    manager.add(sink, x);
+    manager.run();
+    EXPECT_EQ(received, (std::vector<std::string>{"11", "10", "12", "20", "13", "30"}));
+
+    // Edges added later close a cycle
+    RuntimeDataStreamManager cyclic;
+    auto u = cyclic.addSource(source);
+    auto v = cyclic.add(plus, u);
+    auto w = cyclic.add(times, v);
+    cyclic.connect(w, v);
+    EXPECT_THROW(cyclic.step(), std::logic_error);
+}
+
+// Unit tests for routers selecting among the successors of a node.
+TEST(RuntimeDataStreamManagerTest, Router) {
+    auto source = makeSource(Counter{9});
+    auto byThree = source.route([](std::int64_t in) { return in % 3; });
+    std::vector<std::int64_t> branches[3];
+    auto zero = byThree.addDataSink([&](std::int64_t in) { branches[0].push_back(in); });
+    auto one = byThree.addDataSink([&](std::int64_t in) { branches[1].push_back(in); });
+    auto two = byThree.addDataSink([&](std::int64_t in) { branches[2].push_back(in); });
+
+    RuntimeDataStreamManager manager;
+    auto r = manager.add(byThree, manager.addSource(source));
+    manager.add(zero, r);
+    manager.add(one, r);
+    manager.add(two, r);
+    manager.run();
+    EXPECT_EQ(branches[0], (std::vector<std::int64_t>{3, 6, 9}));
+    EXPECT_EQ(branches[1], (std::vector<std::int64_t>{1, 4, 7}));
+    EXPECT_EQ(branches[2], (std::vector<std::int64_t>{2, 5, 8}));
+}
+
+// Unit tests for processes taking the per-event arena.
+TEST(RuntimeDataStreamManagerTest, Arena) {
+    auto source = makeSource(Counter{50});
+    auto digits = source.process([](std::int64_t in, std::pmr::memory_resource* resource) {
+        return std::pmr::string(std::to_string(in), resource).size();
+    });
+    std::size_t total = 0;
+    auto sink = digits.addDataSink([&](std::size_t in) { total += in; });
+
+    RuntimeDataStreamManager manager;
+    manager.add(sink, manager.add(digits, manager.addSource(source)));
+    manager.run();
+    EXPECT_EQ(total, 9u + 2 * 41u);
+}
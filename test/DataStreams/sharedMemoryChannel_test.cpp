@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/sharedMemoryChannel.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    std::string channelName(const std::string& test) {
+        const auto name = "/creek_" + test + "_" + std::to_string(::getpid());
+        SharedMemoryChannel::unlink(name);
+        return name;
+    }
+
+    std::int64_t decode(std::span<const std::byte> bytes) {
+        std::int64_t value = 0;
+        EXPECT_EQ(bytes.size(), sizeof(value));
+        std::memcpy(&value, bytes.data(), sizeof(value));
+        return value;
+    }
+}
+
+// Unit tests for a channel between two processes.
+TEST(SharedMemoryChannelTest, CrossProcess) {
+    const auto name = channelName("process");
+    ChannelOptions options;
+    options.slotCount = 64;
+    options.idleWait = std::chrono::milliseconds(1);
+    SharedMemorySource source(name, options);
+
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        {
+            SharedMemorySink sink(name, options);
+            for (std::int64_t i = 0; i < 100000; ++i) {
+                sink(i);
+            }
+        }
+        ::_exit(0);
+    }
+
+    std::int64_t expected = 0;
+    while (!source.exhausted()) {
+        if (const auto record = source()) {
+            ASSERT_EQ(decode(*record), expected);
+            ++expected;
+        }
+    }
+    EXPECT_EQ(expected, 100000);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    EXPECT_EQ(status, 0);
+    SharedMemoryChannel::unlink(name);
+}
+
+// Unit tests for several producers sharing a ring.
+TEST(SharedMemoryChannelTest, MultipleProducers) {
+    const auto name = channelName("multiple");
+    ChannelOptions options;
+    options.slotCount = 16;
+    options.producers = ChannelProducers::Multiple;
+    options.idleWait = std::chrono::milliseconds(1);
+    SharedMemorySource source(name, options);
+
+    constexpr std::int64_t perProducer = 20000;
+    std::vector<std::thread> producers;
+    for (std::int64_t p = 0; p < 4; ++p) {
+        producers.emplace_back([&, p] {
+            SharedMemorySink sink(name, options);
+            for (std::int64_t i = 0; i < perProducer; ++i) {
+                sink(p * perProducer + i);
+            }
+        });
+    }
+
+    // Each producer's records arrive in order
+    std::vector<std::int64_t> next{0, perProducer, 2 * perProducer, 3 * perProducer};
+    std::size_t received = 0;
+    while (received < 4 * perProducer) {
+        if (const auto record = source()) {
+            const auto value = decode(*record);
+            auto& expected = next[static_cast<std::size_t>(value / perProducer)];
+            ASSERT_EQ(value, expected);
+            ++expected;
+            ++received;
+        }
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(source.exhausted());
+    SharedMemoryChannel::unlink(name);
+}
+
+// Unit tests for the single producer guard and oversized records.
+TEST(SharedMemoryChannelTest, Limits) {
+    const auto name = channelName("limits");
+    ChannelOptions options;
+    options.slotSize = 8;
+    SharedMemorySink sink(name, options);
+    EXPECT_THROW(SharedMemorySink(name, options), std::logic_error);
+    EXPECT_THROW(sink(std::string(9, 'x')), std::length_error);
+    SharedMemoryChannel::unlink(name);
+}
+
+// Unit tests for reusing the name of a channel whose producer crashed.
+TEST(SharedMemoryChannelTest, Abandoned) {
+    const auto name = channelName("abandoned");
+    const pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        // Leaves without detaching, as if it crashed
+        auto* sink = new SharedMemorySink(name);
+        (*sink)(std::int64_t{1});
+        ::_exit(0);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_EQ(status, 0);
+
+    // The dead producer neither counts as attached nor leaves its record behind
+    SharedMemorySource source(name);
+    EXPECT_FALSE(source.exhausted());
+    SharedMemorySink sink(name);
+    sink(std::int64_t{7});
+    const auto record = source();
+    ASSERT_TRUE(record.has_value());
+    EXPECT_EQ(decode(*record), 7);
+    SharedMemoryChannel::unlink(name);
+}
+
+// Unit tests for a graph fed from a channel that runs until the producer leaves.
+TEST(SharedMemoryChannelTest, Graph) {
+    const auto name = channelName("graph");
+    ChannelOptions options;
+    options.idleWait = std::chrono::milliseconds(1);
+    auto source = makeSharedMemorySource(name, options);
+    std::int64_t sum = 0;
+    auto sink = source.addDataSink([&](std::span<const std::byte> record) { sum += decode(record); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+
+    std::thread producer([&] {
+        SharedMemorySink channel(name, options);
+        for (std::int64_t i = 1; i <= 1000; ++i) {
+            channel(i);
+        }
+    });
+    producer.join();
+    manager.run();
+    EXPECT_EQ(sum, 500500);
+    SharedMemoryChannel::unlink(name);
+}
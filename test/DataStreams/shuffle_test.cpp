@@ -0,0 +1,156 @@
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/pipeline.hpp"
+#include "../../include/DataStreams/shuffle.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    struct Tick {
+        int symbol;
+        std::int64_t value;
+    };
+
+    struct Total {
+        int symbol;
+        std::int64_t sum;
+        std::thread::id replica;
+    };
+
+    // Emits count ticks over symbols 0..symbols-1
+    struct Ticks {
+        int count;
+        int symbols;
+        int next = 0;
+
+        std::optional<Tick> operator()() {
+            if (next == count) {
+                return std::nullopt;
+            }
+            const int i = next++;
+            return Tick{i % symbols, i};
+        }
+
+        bool exhausted() const {
+            return next == count;
+        }
+    };
+
+    // Running sum per symbol, the state each replica holds on its own
+    struct SymbolSums {
+        std::unordered_map<int, std::int64_t> sums;
+
+        Total operator()(const Tick& tick) {
+            return Total{tick.symbol, sums[tick.symbol] += tick.value, std::this_thread::get_id()};
+        }
+    };
+}
+
+// Unit tests for the hash partitioning of records by key.
+TEST(ShuffleTest, PartitionBy) {
+    auto partition = partitionBy<4>(&Tick::symbol);
+    static_assert(decltype(partition)::branches == 4);
+    std::set<std::size_t> used;
+    for (int symbol = 0; symbol < 64; ++symbol) {
+        const auto branch = partition(Tick{symbol, 0});
+        EXPECT_LT(branch, 4u);
+        EXPECT_EQ(partition(Tick{symbol, 7}), branch);
+        used.insert(branch);
+    }
+    EXPECT_EQ(used.size(), 4u);
+
+    // Keys sharing a stride with the replica count still spread
+    auto byKey = partitionBy<4>([](std::int64_t in) { return in * 4; });
+    used.clear();
+    for (std::int64_t key = 0; key < 64; ++key) {
+        used.insert(byKey(key));
+    }
+    EXPECT_EQ(used.size(), 4u);
+}
+
+// Unit tests for the program graph of a shuffle stage.
+TEST(ShuffleTest, Program) {
+    auto source = makeSource(Ticks{10, 2});
+    auto shuffle = source.route(partitionBy<2>(&Tick::symbol));
+    auto sums = shuffle.process(SymbolSums{});
+    auto gather = sums.addDataSink([](const Total&) {});
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(shuffle)>;
+    using r0 = ReplicaNode<decltype(sums), 0>;
+    using r1 = ReplicaNode<decltype(sums), 1>;
+    using t3 = ctgl::Node<decltype(gather)>;
+    using expected = ctgl::Graph<ctgl::List<t1, t2, r0, r1, t3>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, r0, 1>, ctgl::Edge<t2, r1, 1>, ctgl::Edge<r0, t3, 1>, ctgl::Edge<r1, t3, 1>>>;
+    using Builder = decltype(pipeline(source, shuffle, replicated<2>(sums), gather));
+    static_assert(std::is_same_v<Builder::Program, expected>);
+}
+
+// Unit tests for per-key aggregation over replicas on threads of their own.
+TEST(ShuffleTest, Threaded) {
+    constexpr int count = 10000;
+    constexpr int symbols = 16;
+    auto source = makeSource(Ticks{count, symbols});
+    auto shuffle = source.route(partitionBy<4>(&Tick::symbol));
+    auto sums = shuffle.process(SymbolSums{});
+    std::map<int, std::int64_t> totals;
+    std::map<int, std::set<std::thread::id>> replicas;
+    bool ordered = true;
+    auto gather = sums.addDataSink([&](const Total& total) {
+        // Running sums of a symbol only grow while its ticks stay in order
+        ordered = ordered && total.sum >= totals[total.symbol];
+        totals[total.symbol] = total.sum;
+        replicas[total.symbol].insert(total.replica);
+    });
+
+    ExecutorOptions options;
+    options.queueCapacity = 64;
+    options.placement.place<ReplicaNode<decltype(sums), 0>>({{}, -1, "replica-0"});
+    auto manager = pipeline(source, shuffle, replicated<4>(sums), gather).buildThreaded(options);
+    manager.run();
+
+    std::set<std::thread::id> threads;
+    for (int symbol = 0; symbol < symbols; ++symbol) {
+        std::int64_t expected = 0;
+        for (std::int64_t i = symbol; i < count; i += symbols) {
+            expected += i;
+        }
+        EXPECT_EQ(totals[symbol], expected);
+        // Every symbol stays with the state of one replica
+        ASSERT_EQ(replicas[symbol].size(), 1u);
+        threads.insert(*replicas[symbol].begin());
+    }
+    EXPECT_TRUE(ordered);
+    EXPECT_GT(threads.size(), 1u);
+}
+
+// Unit tests for chained replicated streams, made by shuffle(), and the
+// single threaded manager.
+TEST(ShuffleTest, Chained) {
+    auto source = makeSource(Ticks{100, 5});
+    auto stage = shuffle<3>(&Tick::symbol, source);
+    auto sums = stage.process(SymbolSums{});
+    static_assert(decltype(sums)::count == 3);
+    auto doubled = sums.stream().process([](const Total& total) { return total.sum * 2; });
+    std::int64_t last = 0;
+    auto gather = doubled.addDataSink([&](std::int64_t in) { last = in; });
+
+    using Builder = decltype(pipeline(source, stage.router(), sums, replicated<3>(doubled), gather));
+    static_assert(ctgl::list::size(Builder::Program::Nodes{}) == 9);
+    static_assert(ctgl::list::size(Builder::Program::Edges{}) == 10);
+
+    auto manager = pipeline(source, stage.router(), sums, replicated<3>(doubled), gather).build();
+    manager.run();
+    // Tick 99 has symbol 4, whose ticks sum to 4 + 9 + ... + 99
+    EXPECT_EQ(last, 2 * (4 + 99) * 20 / 2);
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/task.hpp"
+#include "../../include/DataStreams/virtualClock.hpp"
+
+using namespace hbreukers;
+using namespace std::chrono_literals;
+
+namespace {
+    struct Event {
+        std::chrono::seconds time;
+        int value;
+    };
+
+    // Replays recorded events; Id tells recordings apart in a program graph
+    template<int Id = 0>
+    struct Recording {
+        std::vector<Event> events;
+        std::size_t next = 0;
+
+        std::optional<Event> operator()() {
+            if (next == events.size()) {
+                return std::nullopt;
+            }
+            return events[next++];
+        }
+
+        bool exhausted() const {
+            return next == events.size();
+        }
+    };
+
+    const auto timeOf = [](const Event& event) { return event.time; };
+
+    std::chrono::seconds since(const VirtualClock& clock) {
+        return std::chrono::duration_cast<std::chrono::seconds>(clock.now().time_since_epoch());
+    }
+}
+
+// Unit tests for merging sources in timestamp order.
+TEST(SimulationTest, Merge) {
+    VirtualClock clock;
+    auto trades = makeSource(Recording<1>{{{1s, 1}, {4s, 4}, {7s, 7}, {9s, 9}}});
+    auto quotes = makeSource(Recording<2>{{{2s, 2}, {3s, 3}, {7s, 70}, {8s, 8}}});
+    std::vector<std::pair<int, std::chrono::seconds>> received;
+    auto tradeSink = trades.addDataSink([&](const Event& in) { received.emplace_back(in.value, since(clock)); });
+    auto quoteSink = quotes.addDataSink([&](const Event& in) { received.emplace_back(in.value, since(clock)); });
+
+    using t1 = ctgl::Node<decltype(trades)>;
+    using t2 = ctgl::Node<decltype(quotes)>;
+    using t3 = ctgl::Node<decltype(tradeSink)>;
+    using t4 = ctgl::Node<decltype(quoteSink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>, ctgl::List<ctgl::Edge<t1, t3, 1>, ctgl::Edge<t2, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, trades, quotes, tradeSink, quoteSink);
+    manager.simulate(clock, timeOf);
+
+    // Ties go to the source listed first
+    const std::vector<std::pair<int, std::chrono::seconds>> expected{
+        {1, 1s}, {2, 2s}, {3, 3s}, {4, 4s}, {7, 7s}, {70, 7s}, {8, 8s}, {9, 9s}};
+    EXPECT_EQ(received, expected);
+    EXPECT_TRUE(manager.exhausted());
+}
+
+// Unit tests for tasks sleeping on the virtual clock.
+TEST(SimulationTest, Timers) {
+    const auto replay = [] {
+        VirtualClock clock;
+        auto source = makeSource(Recording<>{{{0s, 0}, {10s, 10}, {20s, 20}, {2h, 7200}}});
+        std::vector<std::string> log;
+        auto delayed = source.process([](Event in) -> Task<int> {
+            co_await sleepFor(15s);
+            co_return in.value;
+        });
+        auto sink = source.addDataSink([&](const Event& in) {
+            log.push_back(std::to_string(in.value) + "@" + std::to_string(since(clock).count()));
+        });
+        auto delayedSink = delayed.addDataSink([&](int in) {
+            log.push_back("late " + std::to_string(in) + "@" + std::to_string(since(clock).count()));
+        });
+
+        using t1 = ctgl::Node<decltype(source)>;
+        using t2 = ctgl::Node<decltype(delayed)>;
+        using t3 = ctgl::Node<decltype(sink)>;
+        using t4 = ctgl::Node<decltype(delayedSink)>;
+        using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+            ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t1, t3, 1>, ctgl::Edge<t2, t4, 1>>>;
+        auto manager = constructDataStreamManager(program{}, source, delayed, sink, delayedSink);
+        manager.simulate(clock, timeOf);
+        EXPECT_EQ(manager.scheduler().pending(), 0u);
+        return log;
+    };
+
+    // Two hours of recording, which a replay does not wait for
+    const auto start = std::chrono::steady_clock::now();
+    const auto log = replay();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 10s);
+    const std::vector<std::string> expected{
+        "0@0", "10@10", "late 0@15", "20@20", "late 10@25", "late 20@35", "7200@7200", "late 7200@7215"};
+    EXPECT_EQ(log, expected);
+    // Nothing depends on the wall clock
+    EXPECT_EQ(replay(), expected);
+}
@@ -0,0 +1,184 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/socketStream.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    std::string tempPath(const std::string& name) {
+        const auto path = (std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()))).string();
+        std::filesystem::remove(path);
+        return path;
+    }
+
+    void receive(SocketSource& source, std::vector<std::int32_t>& received) {
+        while (const auto frame = source()) {
+            std::int32_t value = 0;
+            EXPECT_EQ(frame->size(), sizeof(value));
+            std::memcpy(&value, frame->data(), sizeof(value));
+            received.push_back(value);
+        }
+    }
+
+    // Sends count integers through the sink and collects what the source
+    // receives. Both ends run on this thread, so the sink is flushed in chunks
+    // small enough for the receive queue and drained in between.
+    std::vector<std::int32_t> roundTrip(const std::shared_ptr<Reactor>& reactor, SocketSource& source, SocketSink& sink, int count) {
+        std::vector<std::int32_t> received;
+        for (std::int32_t i = 0; i < count; ++i) {
+            sink(i);
+            if (i % 8 == 7) {
+                sink.flush();
+                receive(source, received);
+            }
+        }
+        sink.flush();
+        for (int polls = 0; static_cast<int>(received.size()) < count && polls < 1000; ++polls) {
+            receive(source, received);
+            reactor->poll(1);
+        }
+        return received;
+    }
+
+    // Counts how often the manager polls the socket
+    struct CountingSource {
+        SocketSource source;
+        std::shared_ptr<std::atomic<int>> calls = std::make_shared<std::atomic<int>>(0);
+
+        std::optional<std::span<const std::byte>> operator()() {
+            ++*calls;
+            return source();
+        }
+
+        bool waitReady(std::chrono::nanoseconds timeout) {
+            return source.waitReady(timeout);
+        }
+    };
+
+    std::vector<std::int32_t> iota(int count) {
+        std::vector<std::int32_t> values(static_cast<std::size_t>(count));
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<std::int32_t>(i);
+        }
+        return values;
+    }
+}
+
+// Unit tests for framed records over loopback TCP.
+TEST(SocketStreamTest, Tcp) {
+    auto reactor = std::make_shared<Reactor>();
+    SocketSource source(reactor, Endpoint::tcp("127.0.0.1", 0));
+    SocketSink sink(reactor, Endpoint::tcp("127.0.0.1", source.localEndpoint().port()));
+    EXPECT_EQ(roundTrip(reactor, source, sink, 5000), iota(5000));
+}
+
+// Unit tests for batched datagrams over loopback UDP.
+TEST(SocketStreamTest, Udp) {
+    auto reactor = std::make_shared<Reactor>();
+    SocketSource source(reactor, Endpoint::udp("127.0.0.1", 0));
+    SocketOptions options;
+    options.batchSize = 8;
+    SocketSink sink(reactor, Endpoint::udp("127.0.0.1", source.localEndpoint().port()), options);
+    // Small enough not to overrun the receive buffer
+    EXPECT_EQ(roundTrip(reactor, source, sink, 100), iota(100));
+}
+
+// Unit tests for framed records over a Unix stream socket.
+TEST(SocketStreamTest, UnixStream) {
+    const auto path = tempPath("creek_socket_stream");
+    auto reactor = std::make_shared<Reactor>();
+    SocketSource source(reactor, Endpoint::unixStream(path));
+    SocketSink sink(reactor, Endpoint::unixStream(path));
+    EXPECT_EQ(roundTrip(reactor, source, sink, 5000), iota(5000));
+    std::filesystem::remove(path);
+}
+
+// Unit tests for datagrams over a Unix datagram socket.
+TEST(SocketStreamTest, UnixDatagram) {
+    const auto path = tempPath("creek_socket_datagram");
+    auto reactor = std::make_shared<Reactor>();
+    SocketSource source(reactor, Endpoint::unixDatagram(path));
+    SocketSink sink(reactor, Endpoint::unixDatagram(path));
+    EXPECT_EQ(roundTrip(reactor, source, sink, 100), iota(100));
+    std::filesystem::remove(path);
+}
+
+// Unit tests for a graph fed from a socket.
+TEST(SocketStreamTest, Graph) {
+    auto reactor = std::make_shared<Reactor>();
+    // Copies share the listening socket
+    SocketSource listener(reactor, Endpoint::tcp("127.0.0.1", 0));
+    auto source = makeSource(listener);
+    std::vector<std::string> received;
+    auto sink = source.addDataSink([&](std::span<const std::byte> frame)
+        {
+            received.emplace_back(reinterpret_cast<const char*>(frame.data()), frame.size());
+        });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+
+    SocketSink client(reactor, Endpoint::tcp("127.0.0.1", listener.localEndpoint().port()));
+    client(std::string("hello"));
+    client(std::string(""));
+    client(std::string(100000, 'x'));
+    client.flush();
+    for (int polls = 0; received.size() < 3 && polls < 10000; ++polls) {
+        manager.step();
+    }
+    ASSERT_EQ(received.size(), 3u);
+    EXPECT_EQ(received[0], "hello");
+    EXPECT_EQ(received[1], "");
+    EXPECT_EQ(received[2].size(), 100000u);
+}
+
+// Unit tests for waiting on a socket, which an idle run() blocks in.
+TEST(SocketStreamTest, WaitReady) {
+    auto reactor = std::make_shared<Reactor>();
+    SocketSource listener(reactor, Endpoint::tcp("127.0.0.1", 0));
+    EXPECT_FALSE(listener.waitReady(std::chrono::milliseconds(1)));
+    SocketSink client(reactor, Endpoint::tcp("127.0.0.1", listener.localEndpoint().port()));
+    client(std::int32_t{7});
+    client.flush();
+    bool ready = false;
+    for (int waits = 0; !ready && waits < 100; ++waits) {
+        ready = listener.waitReady(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(ready);
+    std::vector<std::int32_t> received;
+    receive(listener, received);
+    EXPECT_EQ(received, std::vector<std::int32_t>{7});
+
+    CountingSource counting{listener};
+    const auto calls = counting.calls;
+    auto source = makeSource(counting);
+    auto sink = source.addDataSink([](std::span<const std::byte>) {});
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    std::thread runner([&] { manager.run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    manager.stop();
+    runner.join();
+    // Blocking for up to a millisecond per step, a spinning run() polls
+    // orders of magnitude more often
+    EXPECT_LT(calls->load(), 1000);
+}
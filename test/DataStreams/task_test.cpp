@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/task.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    // Emits 1..count
+    struct Counter {
+        int count;
+        int next = 1;
+
+        std::optional<int> operator()() {
+            if (next > count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+
+        bool exhausted() const {
+            return next > count;
+        }
+    };
+
+    // Answers lookups on a thread of its own, after a short delay
+    class LookupService {
+    public:
+        LookupService() : mThread([this] { serve(); }) {}
+
+        ~LookupService() {
+            {
+                std::lock_guard lock(mMutex);
+                mDone = true;
+            }
+            mWake.notify_one();
+            mThread.join();
+        }
+
+        Completion<int> lookup(int key) {
+            Completion<int> reply;
+            {
+                std::lock_guard lock(mMutex);
+                mRequests.emplace_back(key, reply);
+            }
+            mWake.notify_one();
+            return reply;
+        }
+
+    private:
+        void serve() {
+            std::unique_lock lock(mMutex);
+            while (true) {
+                mWake.wait(lock, [&] { return mDone || !mRequests.empty(); });
+                if (mRequests.empty()) {
+                    return;
+                }
+                auto [key, reply] = std::move(mRequests.front());
+                mRequests.pop_front();
+                lock.unlock();
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                reply.complete(key * 100);
+                lock.lock();
+            }
+        }
+
+        std::mutex mMutex;
+        std::condition_variable mWake;
+        std::deque<std::pair<int, Completion<int>>> mRequests;
+        bool mDone = false;
+        std::thread mThread;
+    };
+
+    Task<int> add(int a, int b) {
+        co_return a + b;
+    }
+
+    Task<int> sleepThenAdd(int a, int b, std::chrono::milliseconds delay) {
+        co_await sleepFor(delay);
+        co_return co_await add(a, b);
+    }
+}
+
+// Unit tests for Task and Scheduler.
+TEST(TaskTest, Scheduler) {
+    Scheduler scheduler;
+    std::vector<int> results;
+    const auto record = [&](std::chrono::milliseconds delay, int value) -> Task<void> {
+        results.push_back(co_await sleepThenAdd(value, 0, delay));
+    };
+    scheduler.spawn(record(std::chrono::milliseconds(20), 2));
+    scheduler.spawn(record(std::chrono::milliseconds(0), 1));
+    EXPECT_EQ(results, std::vector<int>{1});
+    EXPECT_EQ(scheduler.pending(), 1u);
+    while (scheduler.pending() > 0) {
+        scheduler.waitForWork();
+        scheduler.runReady();
+    }
+    EXPECT_EQ(results, (std::vector<int>{1, 2}));
+
+    // Exceptions of a spawned task surface where it is resumed
+    const auto failing = []() -> Task<void> {
+        co_await sleepFor(std::chrono::milliseconds(1));
+        throw std::runtime_error("task failed");
+    };
+    scheduler.spawn(failing());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_THROW(scheduler.runReady(), std::runtime_error);
+    EXPECT_EQ(scheduler.pending(), 0u);
+}
+
+// Unit tests for Completion resumed from another thread.
+TEST(TaskTest, Completion) {
+    Scheduler scheduler;
+    Completion<int> reply;
+    int result = 0;
+    const auto await = [&]() -> Task<void> { result = co_await reply; };
+    scheduler.spawn(await());
+    std::thread([reply]() mutable { reply.complete(42); }).join();
+    scheduler.waitForWork();
+    EXPECT_TRUE(scheduler.runReady());
+    EXPECT_EQ(result, 42);
+
+    // Completed before being awaited
+    Completion<int> ready;
+    ready.complete(7);
+    const auto awaitReady = [&]() -> Task<void> { result = co_await ready; };
+    scheduler.spawn(awaitReady());
+    EXPECT_EQ(result, 7);
+
+    // Completed after the scheduler and the task awaiting it are gone
+    Completion<int> late;
+    const auto awaitLate = [&]() -> Task<void> { result = co_await late; };
+    {
+        Scheduler gone;
+        gone.spawn(awaitLate());
+        EXPECT_EQ(gone.pending(), 1u);
+    }
+    std::thread([late]() mutable { late.complete(1); }).join();
+    EXPECT_EQ(result, 7);
+}
+
+// Unit tests for processes returning tasks.
+TEST(TaskTest, AsynchronousProcess) {
+    LookupService service;
+    auto source = makeSource(Counter{200});
+    // Odd keys are answered from a local cache, even ones by the service
+    auto enriched = source.process([&service](int key) -> Task<int> {
+        if (key % 2 == 1) {
+            co_return key * 100;
+        }
+        co_return co_await service.lookup(key);
+    });
+    std::vector<int> received;
+    auto sink = enriched.addDataSink([&](int in) { received.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(enriched)>;
+    using t3 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>, ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, enriched, sink);
+    manager.run();
+
+    ASSERT_EQ(received.size(), 200u);
+    EXPECT_EQ(manager.scheduler().pending(), 0u);
+    // The cache hits did not wait for the lookups before them
+    EXPECT_EQ(received[0], 100);
+    EXPECT_EQ(received[1], 300);
+    std::vector<int> sorted = received;
+    std::sort(sorted.begin(), sorted.end());
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_EQ(sorted[static_cast<std::size_t>(i)], (i + 1) * 100);
+    }
+}
+
+// Unit tests for exceptions thrown by a task.
+TEST(TaskTest, Exception) {
+    auto source = makeSource(Counter{10});
+    auto sink = source.addDataSink([](int in) -> Task<void> {
+        co_await sleepFor(std::chrono::microseconds(10));
+        if (in == 5) {
+            throw std::runtime_error("lookup failed");
+        }
+    });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    EXPECT_THROW(manager.run(), std::runtime_error);
+}
+
+// Unit tests for telling how a task returning process takes its input.
+TEST(TaskTest, InputParameter) {
+    const auto byValue = [](int in) -> Task<int> { co_return in; };
+    const auto byReference = [](const int& in) -> Task<int> { co_return in; };
+    const auto generic = [](const auto& in) -> Task<int> { co_return in; };
+    static_assert(std::is_same_v<detail::InputParameter<decltype(byValue), int>, int>);
+    static_assert(std::is_same_v<detail::InputParameter<decltype(byReference), int>, const int&>);
+    static_assert(std::is_same_v<detail::InputParameter<decltype(generic), int>, const int&>);
+    // Nothing to tell for a process without parameters
+    static_assert(std::is_void_v<detail::InputParameter<Counter, int>>);
+}
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/placement.hpp"
+#include "../../include/DataStreams/spscQueue.hpp"
+#include "../../include/DataStreams/threadedDataStreamManager.hpp"
+
+using namespace hbreukers;
+
+namespace {
+    // Emits 1..count
+    struct Counter {
+        std::int64_t count;
+        std::int64_t next = 1;
+
+        std::optional<std::int64_t> operator()() {
+            if (next > count) {
+                return std::nullopt;
+            }
+            return next++;
+        }
+
+        bool exhausted() const {
+            return next > count;
+        }
+    };
+
+    // source -> double -> keep multiples of 4 -> emit twice -> sum
+    template<typename Waits>
+    std::int64_t runPipeline(std::int64_t count) {
+        auto source = makeSource(Counter{count});
+        auto doubled = source.process([](std::int64_t in) { return in * 2; });
+        auto multiples = doubled.filter([](std::int64_t in) { return in % 4 == 0; });
+        auto twice = multiples.template flatMap<2>([](std::int64_t in, auto& out) { out.push(in); out.push(in); });
+        std::int64_t sum = 0;
+        auto sink = twice.addDataSink([&sum](std::int64_t in) { sum += in; });
+
+        using t1 = ctgl::Node<decltype(source)>;
+        using t2 = ctgl::Node<decltype(doubled)>;
+        using t3 = ctgl::Node<decltype(multiples)>;
+        using t4 = ctgl::Node<decltype(twice)>;
+        using t5 = ctgl::Node<decltype(sink)>;
+        using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4, t5>,
+            ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t3, t4, 1>, ctgl::Edge<t4, t5, 1>>>;
+        ExecutorOptions options;
+        options.queueCapacity = 64;
+        auto manager = constructThreadedDataStreamManager<Waits>(program{}, options, source, doubled, multiples, twice, sink);
+        manager.run();
+        return sum;
+    }
+
+    // Sum of 2 * (4k) over the even numbers up to count
+    std::int64_t expectedSum(std::int64_t count) {
+        std::int64_t sum = 0;
+        for (std::int64_t i = 2; i <= count; i += 2) {
+            sum += 4 * i;
+        }
+        return sum;
+    }
+}
+
+// Unit tests for the SpscQueue type.
+TEST(ThreadedDataStreamManagerTest, SpscQueue) {
+    SpscQueue<std::string> queue(3);
+    EXPECT_EQ(queue.capacity(), 4u);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_TRUE(queue.tryPush(std::to_string(i)));
+        }
+        EXPECT_FALSE(queue.tryPush("full"));
+        EXPECT_TRUE(queue.full());
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_NE(queue.front(), nullptr);
+            EXPECT_EQ(*queue.front(), std::to_string(i));
+            queue.pop();
+        }
+        EXPECT_EQ(queue.front(), nullptr);
+    }
+    // Left over elements are destroyed with the queue
+    queue.tryEmplace(std::size_t{100}, 'x');
+    EXPECT_FALSE(queue.finished());
+    queue.close();
+    ASSERT_NE(queue.front(), nullptr);
+    queue.pop();
+    EXPECT_TRUE(queue.finished());
+}
+
+// Unit tests for each wait strategy.
+TEST(ThreadedDataStreamManagerTest, WaitStrategies) {
+    EXPECT_EQ(runPipeline<WaitStrategies<wait::SpinThenPark<>>>(20000), expectedSum(20000));
+    EXPECT_EQ(runPipeline<WaitStrategies<wait::Blocking>>(20000), expectedSum(20000));
+    EXPECT_EQ(runPipeline<WaitStrategies<wait::BusySpin>>(2000), expectedSum(2000));
+}
+
+// Unit tests for routers sending each value to one stage.
+TEST(ThreadedDataStreamManagerTest, Router) {
+    auto source = makeSource(Counter{1000});
+    auto parity = source.route([](std::int64_t in) { return in % 2; });
+    std::int64_t evens = 0;
+    std::int64_t odds = 0;
+    auto even = parity.addDataSink([&](std::int64_t in) { evens += in; });
+    auto odd = parity.addDataSink([&](std::int64_t in) { odds += in; });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(parity)>;
+    using t3 = ctgl::Node<decltype(even)>;
+    using t4 = ctgl::Node<decltype(odd)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>,
+        ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>, ctgl::Edge<t2, t4, 1>>>;
+    ExecutorOptions options;
+    options.queueCapacity = 16;
+    auto manager = constructThreadedDataStreamManager(program{}, options, source, parity, even, odd);
+    manager.run();
+    EXPECT_EQ(evens, 500 * 501);
+    EXPECT_EQ(odds, 500 * 500);
+}
+
+// Unit tests for per stage wait strategies and fan-in.
+TEST(ThreadedDataStreamManagerTest, FanIn) {
+    // Never exhausted, stopped once the other source is done
+    auto negative = makeSource([i = std::int64_t{0}]() mutable { return --i; });
+    auto positive = makeSource(Counter{500});
+    std::vector<std::int64_t> received;
+    auto sink = negative.addDataSink([&](std::int64_t in) { received.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(negative)>;
+    using t2 = ctgl::Node<decltype(positive)>;
+    using t3 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>, ctgl::List<ctgl::Edge<t1, t3, 1>, ctgl::Edge<t2, t3, 1>>>;
+    using Waits = WaitStrategies<wait::SpinThenPark<16>, StageWait<t3, wait::Blocking>>;
+    static_assert(std::is_same_v<Waits::For<t3>, wait::Blocking>);
+    static_assert(std::is_same_v<Waits::For<t1>, wait::SpinThenPark<16>>);
+
+    auto manager = constructThreadedDataStreamManager<Waits>(program{}, negative, positive, sink);
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        manager.stop();
+    });
+    manager.run();
+    stopper.join();
+
+    // Each source's values arrive in order
+    std::int64_t lastNegative = 0;
+    std::int64_t lastPositive = 0;
+    for (const auto value : received) {
+        if (value < 0) {
+            EXPECT_EQ(value, lastNegative - 1);
+            lastNegative = value;
+        } else {
+            EXPECT_EQ(value, lastPositive + 1);
+            lastPositive = value;
+        }
+    }
+    EXPECT_EQ(lastPositive, 500);
+    EXPECT_LT(lastNegative, 0);
+}
+
+// Unit tests for pinning, NUMA placement and naming of stage threads.
+TEST(ThreadedDataStreamManagerTest, Placement) {
+    EXPECT_EQ(detail::parseCpuList("0-3,8,10-11\n"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+
+    auto source = makeSource(Counter{1000});
+    std::string mapName;
+    std::string sinkName;
+    std::vector<int> sinkCpus;
+    const auto threadName = [] {
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        return std::string(name);
+    };
+    auto named = source.process([&, first = true](std::int64_t in) mutable {
+        if (first) {
+            mapName = threadName();
+            first = false;
+        }
+        return in;
+    });
+    std::int64_t sum = 0;
+    auto sink = named.addDataSink([&](std::int64_t in) {
+        sinkName = threadName();
+        sinkCpus.push_back(sched_getcpu());
+        sum += in;
+    });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(named)>;
+    using t3 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3>, ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t2, t3, 1>>>;
+
+    // A node that does not exist is reported instead of failing the run
+    {
+        ExecutorOptions options;
+        options.placement.place<t3>({{}, 100, "far-sink"});
+        auto manager = constructThreadedDataStreamManager(program{}, options, source, named, sink);
+        manager.run();
+        EXPECT_EQ(sum, 1000 * 1001 / 2);
+        const auto failures = manager.placementFailures();
+        EXPECT_TRUE(std::any_of(failures.begin(), failures.end(), [](const PlacementFailure& failure) {
+            return failure.stage == "far-sink";
+        }));
+    }
+
+    if (!std::filesystem::exists("/sys/devices/system/node/node0")) {
+        GTEST_SKIP() << "NUMA unavailable";
+    }
+    sum = 0;
+    sinkCpus.clear();
+    const int cpu = numaNodeCpus(0).front();
+    ExecutorOptions options;
+    options.placement.place<t3>({{cpu}, 0, "sink-stage-with-a-long-name"}).place<t2>({{}, 0, {}});
+    auto manager = constructThreadedDataStreamManager(program{}, options, source, named, sink);
+    manager.run();
+
+    EXPECT_EQ(sum, 1000 * 1001 / 2);
+    EXPECT_EQ(mapName, "stage-1");
+    EXPECT_EQ(sinkName, "sink-stage-with");
+    const auto failures = manager.placementFailures();
+    const bool pinned = std::none_of(failures.begin(), failures.end(), [](const PlacementFailure& failure) {
+        return failure.stage == "sink-stage-with" && failure.what.starts_with("pthread_setaffinity_np");
+    });
+    // Pinning is best effort too, say when the CPU is outside the cpuset
+    if (pinned) {
+        for (const auto used : sinkCpus) {
+            EXPECT_EQ(used, cpu);
+        }
+    }
+}
+
+// Unit tests for exceptions thrown by a stage.
+TEST(ThreadedDataStreamManagerTest, Exception) {
+    auto source = makeSource([i = 0]() mutable { return ++i; });
+    auto sink = source.addDataSink([](int in) {
+        if (in == 1000) {
+            throw std::runtime_error("stage failed");
+        }
+    });
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructThreadedDataStreamManager(program{}, source, sink);
+    EXPECT_THROW(manager.run(), std::runtime_error);
+}
@@ -0,0 +1,205 @@
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../../include/DataStreams/dataStream.hpp"
+#include "../../include/DataStreams/dataStreamManager.hpp"
+#include "../../include/DataStreams/runtimeDataStreamManager.hpp"
+#include "../../include/DataStreams/timer.hpp"
+#include "../../include/DataStreams/virtualClock.hpp"
+
+using namespace hbreukers;
+using namespace std::chrono_literals;
+
+namespace {
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    TimePoint at(std::chrono::steady_clock::duration since) {
+        return TimePoint(since);
+    }
+
+    struct Event {
+        std::chrono::milliseconds time;
+        int value;
+    };
+
+    // Replays recorded events
+    struct Recording {
+        std::vector<Event> events;
+        std::size_t next = 0;
+
+        std::optional<Event> operator()() {
+            if (next == events.size()) {
+                return std::nullopt;
+            }
+            return events[next++];
+        }
+
+        bool exhausted() const {
+            return next == events.size();
+        }
+    };
+
+    // Recording that also emits a marker with value 0 every interval
+    struct MarkedRecording : Recording {
+        std::chrono::milliseconds interval;
+
+        std::chrono::milliseconds timerInterval() const {
+            return interval;
+        }
+
+        Event onTimer(TimePoint now) {
+            return Event{std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()), 0};
+        }
+    };
+
+    // Sink writing its records out in batches, at the latest every interval
+    struct Batcher {
+        std::chrono::milliseconds interval;
+        std::vector<std::pair<std::size_t, TimePoint>>* flushes;
+        std::vector<int> pending;
+
+        void operator()(const Event& in) {
+            pending.push_back(in.value);
+        }
+
+        std::chrono::milliseconds timerInterval() const {
+            return interval;
+        }
+
+        void onTimer(TimePoint now) {
+            if (!pending.empty()) {
+                flushes->emplace_back(pending.size(), now);
+                pending.clear();
+            }
+        }
+    };
+}
+
+// Unit tests for expiring entries across the levels of the wheel.
+TEST(TimerTest, TimingWheel) {
+    TimingWheel<int> wheel(1ms);
+    std::vector<std::pair<int, TimePoint>> expired;
+    const auto record = [&](int payload, TimePoint expiry) { expired.emplace_back(payload, expiry); };
+
+    wheel.schedule(at(5ms), 1);
+    wheel.schedule(at(5ms), 2);
+    wheel.schedule(at(70ms), 3);
+    wheel.schedule(at(5s), 4);
+    // Past the range of the wheel
+    wheel.schedule(at(20h), 5);
+    wheel.schedule(at(0ms), 6);
+    EXPECT_EQ(wheel.size(), 6u);
+    EXPECT_EQ(wheel.nextExpiry(), at(1ms));
+
+    wheel.advance(at(4ms), record);
+    wheel.advance(at(100ms), record);
+    EXPECT_EQ(wheel.nextExpiry(), at(5s));
+    wheel.advance(at(10h), record);
+    EXPECT_EQ(wheel.size(), 1u);
+    wheel.advance(at(21h), record);
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.nextExpiry(), std::nullopt);
+    const std::vector<std::pair<int, TimePoint>> expected{
+        {6, at(1ms)}, {1, at(5ms)}, {2, at(5ms)}, {3, at(70ms)}, {4, at(5s)}, {5, at(20h)}};
+    EXPECT_EQ(expired, expected);
+
+    // Deadlines round up to the resolution and entries may reschedule
+    TimingWheel<int> periodic(1ms);
+    std::vector<TimePoint> expiries;
+    periodic.schedule(at(1ms + 300us), 0);
+    periodic.advance(at(40ms), [&](int, TimePoint expiry) {
+        expiries.push_back(expiry);
+        if (expiries.size() < 10) {
+            periodic.schedule(expiry + 3ms, 0);
+        }
+    });
+    ASSERT_EQ(expiries.size(), 10u);
+    EXPECT_EQ(expiries.front(), at(2ms));
+    EXPECT_EQ(expiries.back(), at(29ms));
+}
+
+// Unit tests for timers of nodes on the virtual clock of a simulation.
+TEST(TimerTest, Simulation) {
+    VirtualClock clock;
+    auto source = makeSource(Recording{{{1000ms, 1}, {1003ms, 2}, {1025ms, 3}, {1041ms, 4}}});
+    std::vector<std::pair<std::size_t, TimePoint>> flushes;
+    auto batcher = source.addDataSink(Batcher{10ms, &flushes, {}});
+    auto heartbeat = makeSource(TimerSource{15ms});
+    std::vector<TimePoint> beats;
+    auto beatSink = heartbeat.addDataSink([&](TimePoint in) { beats.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(batcher)>;
+    using t3 = ctgl::Node<decltype(heartbeat)>;
+    using t4 = ctgl::Node<decltype(beatSink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2, t3, t4>, ctgl::List<ctgl::Edge<t1, t2, 1>, ctgl::Edge<t3, t4, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, batcher, heartbeat, beatSink);
+    manager.simulate(clock, [](const Event& event) { return event.time; });
+
+    // Timers start with the first record and stop with the last one
+    const std::vector<std::pair<std::size_t, TimePoint>> expectedFlushes{{2, at(1010ms)}, {1, at(1030ms)}};
+    EXPECT_EQ(flushes, expectedFlushes);
+    EXPECT_EQ(beats, (std::vector<TimePoint>{at(1015ms), at(1030ms)}));
+}
+
+// Unit tests for sources with records of their own and a timer in a simulation.
+TEST(TimerTest, TimedSource) {
+    VirtualClock clock;
+    auto source = makeSource(MarkedRecording{{{{1000ms, 1}, {1012ms, 2}, {1030ms, 3}}}, 10ms});
+    std::vector<std::pair<int, std::chrono::milliseconds>> received;
+    auto sink = source.addDataSink([&](const Event& in) { received.emplace_back(in.value, in.time); });
+
+    using t1 = ctgl::Node<decltype(source)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, source, sink);
+    manager.simulate(clock, [](const Event& event) { return event.time; });
+
+    // Records and markers interleave by time, a marker first on a tie
+    const std::vector<std::pair<int, std::chrono::milliseconds>> expected{
+        {1, 1000ms}, {0, 1010ms}, {2, 1012ms}, {0, 1020ms}, {0, 1030ms}, {3, 1030ms}};
+    EXPECT_EQ(received, expected);
+}
+
+// Unit tests for timers of nodes on the wall clock.
+TEST(TimerTest, WallClock) {
+    auto heartbeat = makeSource(TimerSource{1ms});
+    std::vector<TimePoint> beats;
+    auto sink = heartbeat.addDataSink([&](TimePoint in) { beats.push_back(in); });
+
+    using t1 = ctgl::Node<decltype(heartbeat)>;
+    using t2 = ctgl::Node<decltype(sink)>;
+    using program = ctgl::Graph<ctgl::List<t1, t2>, ctgl::List<ctgl::Edge<t1, t2, 1>>>;
+    auto manager = constructDataStreamManager(program{}, heartbeat, sink);
+    const auto start = std::chrono::steady_clock::now();
+    while (beats.size() < 3 && std::chrono::steady_clock::now() - start < 5s) {
+        manager.step();
+    }
+    ASSERT_EQ(beats.size(), 3u);
+    EXPECT_GE(beats[0], start + 1ms);
+    EXPECT_LT(beats[0], beats[1]);
+    EXPECT_LT(beats[1], beats[2]);
+}
+
+// Unit tests for timers of nodes on the runtime manager.
+TEST(TimerTest, Runtime) {
+    auto heartbeat = makeSource(TimerSource{1ms});
+    std::vector<TimePoint> beats;
+    auto sink = heartbeat.addDataSink([&](TimePoint in) { beats.push_back(in); });
+
+    RuntimeDataStreamManager manager;
+    manager.add(sink, manager.addSource(heartbeat));
+    const auto start = std::chrono::steady_clock::now();
+    while (beats.size() < 3 && std::chrono::steady_clock::now() - start < 5s) {
+        manager.step();
+    }
+    ASSERT_EQ(beats.size(), 3u);
+    EXPECT_GE(beats[0], start + 1ms);
+    EXPECT_LT(beats[0], beats[1]);
+    EXPECT_LT(beats[1], beats[2]);
+}